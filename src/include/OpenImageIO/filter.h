@@ -5,6 +5,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include <OpenImageIO/export.h>
 #include <OpenImageIO/oiioversion.h>
 #include <OpenImageIO/string_view.h>
@@ -125,4 +129,84 @@ protected:
 };
 
 
+
+/// FilterTable holds tabulated copies of a filter's profiles, so that it
+/// can be evaluated many times without a virtual call for each tap. It's
+/// made from a Filter1D, or from a Filter2D, whose xfilt and yfilt profiles
+/// are tabulated separately.
+/// Between table entries, the filter is linearly interpolated; the values
+/// exactly at the edges of the filter and just inside them are kept, so
+/// filters that are discontinuous there (like box) are reproduced exactly.
+/// Elsewhere, with the default resolution, the tabulated values are within
+/// 1e-4 of the filter's own.
+/// The filter must outlive the table if it's a non-separable Filter2D,
+/// which is still evaluated directly by operator()(x,y).
+class OIIO_UTIL_API FilterTable {
+public:
+    FilterTable(const Filter1D& filter, int resolution = 2048);
+    FilterTable(const Filter2D& filter, int resolution = 2048);
+
+    /// Get the width of the filter
+    float width() const { return m_x.width; }
+    /// Get the height of the filter (same as the width for a 1D filter)
+    float height() const { return m_y.width; }
+    /// Is the filter separable?
+    bool separable() const { return m_filter2d == nullptr; }
+
+    /// Evaluate the horizontal filter (or the 1D filter).
+    float xfilt(float x) const { return m_x.eval(x); }
+
+    /// Evaluate the vertical filter (or the 1D filter).
+    float yfilt(float y) const { return m_y.eval(y); }
+
+    /// Evaluate the filter at an x and y position (relative to filter
+    /// center).
+    float operator()(float x, float y) const
+    {
+        return m_filter2d ? (*m_filter2d)(x, y) : xfilt(x) * yfilt(y);
+    }
+
+    /// Evaluate the horizontal filter at n positions (any number) starting
+    /// at x0 and spaced dx apart, storing the weights in w[0..n-1].
+    void xfilt(float x0, float dx, int n, float* w) const
+    {
+        m_x.eval(x0, dx, n, w);
+    }
+    /// Evaluate the vertical filter at n positions spaced dy apart.
+    void yfilt(float y0, float dy, int n, float* w) const
+    {
+        m_y.eval(y0, dy, n, w);
+    }
+
+private:
+    // One tabulated profile, spanning [-width/2, width/2].
+    struct Profile {
+        float width = 0.0f;
+        float rad   = 0.0f;  // width/2
+        float scale = 0.0f;  // table entries per unit
+        float edge[2];       // value at exactly -rad, rad
+        std::vector<float> table;
+
+        template<typename F> void init(float width, int resolution, F&& f);
+
+        float eval(float x) const
+        {
+            float ax = fabsf(x);
+            if (ax >= rad)
+                return ax == rad ? edge[x > 0.0f] : 0.0f;
+            float u = (x + rad) * scale;
+            int i   = std::min(int(u), int(table.size()) - 2);
+            float f = u - float(i);
+            return table[i] + f * (table[i + 1] - table[i]);
+        }
+
+        // Evaluate n positions spaced dx apart, 8 at a time.
+        void eval(float x0, float dx, int n, float* w) const;
+    };
+
+    Profile m_x, m_y;
+    const Filter2D* m_filter2d = nullptr;  // non-separable only
+};
+
+
 OIIO_NAMESPACE_END
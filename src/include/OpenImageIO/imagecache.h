@@ -100,6 +100,109 @@ public:
     /// - `float max_memory_MB` :
     ///           The maximum amount of memory (measured in MB) used for the
     ///           internal "tile cache." (Default: 256.0 MB)
+    /// - `float max_compressed_memory_MB` :
+    ///           The maximum amount of memory (measured in MB) used for a
+    ///           second tier of the tile cache, which keeps tiles evicted
+    ///           from the main tile cache in compressed form. A tile that
+    ///           is needed again after being evicted is then decompressed
+    ///           from memory instead of being read from disk again. When
+    ///           this tier is full, the tiles that were evicted first are
+    ///           discarded. The default of 0 disables it. (Default: 0.0 MB)
+    /// - `string disk_cache` :
+    ///           A directory for a persistent on-disk cache of decoded
+    ///           tiles. Tiles read from image files are written there and
+    ///           reused by later runs (and by other processes using the
+    ///           same directory at the same time), instead of being read
+    ///           and decompressed from the original file again. Tiles are
+    ///           identified by the file's SHA-1 fingerprint, if it has one
+    ///           (as written by `maketx`), or else its name, modification
+    ///           time and size. An empty string disables the disk cache.
+    ///           (Default: "")
+    /// - `int microcache_size` :
+    ///           Besides the last two tiles it used, each thread keeps a
+    ///           small set-associative cache of this many recently used
+    ///           tiles, which it checks before the (shared, locked) main
+    ///           tile cache. This helps lookups that cycle among several
+    ///           tiles, such as filters straddling tile corners. Tiles
+    ///           held by these per-thread caches can't be freed until they
+    ///           are displaced. 0 disables it. (Default: 8)
+    /// - `int tile_hugepages` :
+    ///           If nonzero, ask the system to back the memory that holds
+    ///           tile pixels with huge pages (on Linux, with transparent
+    ///           huge pages enabled in "madvise" mode or more), which can
+    ///           cut TLB misses on very large caches. (Default: 0)
+    /// - `int mmap_tiles` :
+    ///           If nonzero, tiles of image files that store their pixels
+    ///           uncompressed and exactly as the cache would hold them
+    ///           (currently: uncompressed tiled TIFF whose data type is
+    ///           the one being cached, in this machine's byte order, with
+    ///           no color or alpha conversion needed) are used right where
+    ///           they are in the memory-mapped file instead of being
+    ///           copied. Such tiles don't count against `max_memory_MB`,
+    ///           as their memory belongs to the operating system's file
+    ///           cache. A file must not be modified while it's mapped.
+    ///           Not available on Windows. (Default: 0)
+    /// - `int compact_constant_tiles` :
+    ///           If nonzero, a tile whose pixels all have the same value
+    ///           is kept as just that one pixel, and counts as one pixel
+    ///           against `max_memory_MB`; texture lookups on it don't
+    ///           need the rest. (If `tile_pixels()` is asked for all of
+    ///           its pixels, they are laid out in a read-only buffer
+    ///           shared with all other such tiles of the same size and
+    ///           value, which counts once against `max_memory_MB`.) This
+    ///           saves a lot of memory for images with large empty or
+    ///           flat areas, at the cost of checking every tile read.
+    ///           (Default: 0)
+    /// - `int skip_constant_tiles` :
+    ///           If nonzero, tiles that the format reader knows to be
+    ///           constant without reading them (such as the empty space of
+    ///           sparse OpenVDB volumes) are not read at all, and are kept
+    ///           as one pixel just like the ones `compact_constant_tiles`
+    ///           finds, whether or not that is on. (Default: 1)
+    /// - `string trace_file` :
+    ///           If not empty, write to the named file a binary trace of
+    ///           every tile lookup that isn't satisfied by the per-thread
+    ///           microcaches (with the tile, the thread, the time, and
+    ///           whether the tile was in the cache), which the
+    ///           `tilereplay` tool can replay with other cache settings.
+    ///           Setting it to another name starts a new trace; setting it
+    ///           to the empty string ends it. (Default: "")
+    /// - `string tile_manifest` :
+    ///           If not empty, the name of a file to which a manifest of
+    ///           all the tiles read (see `write_tile_manifest()`) will be
+    ///           written when the ImageCache is destroyed. (Default: "")
+    /// - `string shared_tiles` :
+    ///           The name of a POSIX shared memory segment (such as
+    ///           "/oiio_tiles") in which to keep the tiles read, so that
+    ///           all the processes on a host using the same name share one
+    ///           copy of them. The segment is created by the first process
+    ///           to attach to it (with the `max_shared_memory_MB` and
+    ///           `shared_tile_bytes` then in effect, so set those first),
+    ///           and removed when the last one detaches. The tiles a
+    ///           process uses from it still count against its
+    ///           `max_memory_MB`, so that each process lets go of the tiles
+    ///           it no longer needs, but only one copy of each tile exists
+    ///           for all of them. At most 64 caches may use one segment at
+    ///           a time; the tiles held by a process that crashed are let
+    ///           go when the others notice. Tiles are identified as
+    ///           for the `disk_cache`, and those of images that can't be
+    ///           (custom ImageInputs or IOProxy input) aren't shared. An
+    ///           empty string disables it. Only available on Linux.
+    ///           (Default: "")
+    /// - `float max_shared_memory_MB` :
+    ///           The size (in MB) of the `shared_tiles` segment. When it's
+    ///           full, the tiles not in use by any process are recycled,
+    ///           least recently used first. (Default: 4096.0 MB)
+    /// - `int shared_tile_bytes` :
+    ///           The size (in bytes) of the pixels of the largest tile the
+    ///           `shared_tiles` segment will hold. Every tile takes that
+    ///           much room in it, so it should match the tiles most
+    ///           commonly used. (Default: 65536, a 64x64 RGBA float tile)
+    /// - `float max_disk_cache_MB` :
+    ///           The size limit (in MB) of the `disk_cache` directory.
+    ///           When it grows past that, the least recently used tiles are
+    ///           deleted, by one of the `prefetch_threads` (or a thread of
+    ///           its own if there are none). (Default: 8192.0 MB)
     /// - `string searchpath` :
     ///           The search path for images: a colon-separated list of
     ///           directories that will be searched in order for any image
@@ -170,6 +273,15 @@ public:
     ///           simplify their image manipulations to only need to
     ///           consider `float` data. The default is zero, meaning that
     ///           image pixels are not forced to be `float` when in cache.
+    /// - `int float_as_half` :
+    ///           If set to nonzero (and `forcefloat` is not), the tiles of
+    ///           `float` images will be converted to `half` when stored in
+    ///           the image cache, so that twice as many texels fit in the
+    ///           same `max_memory_MB`. Lookups convert back to `float` as
+    ///           they would for a `half` file. This is only suitable if
+    ///           the values fit in `half` range and precision (such as
+    ///           most color textures, but probably not, for example,
+    ///           world-space positions). (Default: 0)
     /// - `int failure_retries` :
     ///           When an image file is opened or a tile/scanline is read but
     ///           a file error occurs, if this attribute is nonzero, it will
@@ -179,6 +291,15 @@ public:
     ///           occasional spurious networking or other glitches that would
     ///           otherwise cause the entire long-running application to fail
     ///           upon a single transient error. (Default: 0)
+    /// - `float missing_file_retry_time` :
+    ///           A file that could not be opened because it did not exist
+    ///           is normally remembered as broken until the cache is
+    ///           invalidated, so that lookups don't keep searching for it.
+    ///           If this attribute is nonzero, that is only remembered for
+    ///           this many seconds; a later lookup after that time looks
+    ///           for it again (through the searchpath) and opens it if it
+    ///           has appeared, for example because another process has
+    ///           finished writing it. (Default: 0)
     /// - `int deduplicate` :
     ///           When nonzero, the ImageCache will notice duplicate images
     ///           under different names if their headers contain a SHA-1
@@ -187,6 +308,13 @@ public:
     ///           reads.  The default is 1 (de-duplication turned on). The
     ///           only reason to set it to 0 is if you specifically want to
     ///           disable the de-duplication optimization.
+    /// - `int deduplicate_tiles` :
+    ///           When nonzero, the pixels of every tile read are hashed, and
+    ///           tiles with identical contents share one pixel buffer (and
+    ///           its memory), even if they come from different files, as
+    ///           with variants or re-exports of a texture, or the padding
+    ///           of UDIM tiles. This costs a hash of each tile read.
+    ///           (Default: 0)
     /// - `string substitute_image` :
     ///           When set to anything other than the empty string, the
     ///           ImageCache will use the named image in place of *all*
@@ -213,6 +341,35 @@ public:
     ///           enabled, this reduces the number of file opens, at the
     ///           expense of not being able to open files if their format do
     ///           not actually match their filename extension). Default: 0
+    /// - `string tile_cache_policy` :
+    ///           How tiles are chosen for eviction when the cache is full.
+    ///           `"clock"` (the default) frees tiles that have not been
+    ///           used since the last time the "clock hand" passed by.
+    ///           `"clockpro"` is a scan-resistant variant that tells tiles
+    ///           used once apart from those used repeatedly: new tiles
+    ///           start out "cold" and become "hot" only if used again
+    ///           after surviving a pass of the clock hand (or if they are
+    ///           needed again soon after being evicted). Hot tiles are not
+    ///           evicted while they occupy less than 3/4 of the cache, so
+    ///           a single large pass over an image (such as reading a big
+    ///           file through an ImageBuf backed by the cache) won't flush
+    ///           the texture working set of a render.
+    /// - `int readers_per_file` :
+    ///           The maximum number of ImageInputs the cache will keep open
+    ///           for any one file. When more than 1, threads that need to
+    ///           read tiles from the same file at the same time can do so
+    ///           concurrently using separately opened readers, instead of
+    ///           taking turns with a single one. Additional readers count
+    ///           against `max_open_files` and are only opened while there
+    ///           is room under that limit. Custom ImageInputs (see
+    ///           `add_file()`) and files read through an IOProxy always use
+    ///           a single reader. (Default: 1)
+    /// - `int prefetch_threads` :
+    ///           The number of background threads used to service
+    ///           `prefetch()` and `open_files()` requests. The thread pool
+    ///           is created the first time it is needed. If 0, the
+    ///           requested tiles are read (or files opened) immediately
+    ///           on the calling thread. (Default: 4)
     ///
     /// - `string options`
     ///           This catch-all is simply a comma-separated list of
@@ -243,6 +400,12 @@ public:
     /// - `int64 stat:cache_memory_used` :
     ///           Total bytes used by tile cache.
     ///
+    /// - `int64 stat:cache_memory_resident` :
+    ///           Bytes of memory actually held for tile pixels, including
+    ///           pooled buffers that are free for reuse. Compare with
+    ///           `stat:cache_memory_used`, the memory used by the tiles
+    ///           that are currently in the cache.
+    ///
     /// - `int stat:tiles_created` ,
     ///   `int stat:tiles_current` ,
     ///   `int stat:tiles_peak` :
@@ -278,6 +441,54 @@ public:
     /// - `float stat:fileio_time` :
     ///           Total I/O-related time (seconds).
     ///
+    /// - `int stat:prefetch_tiles` ,
+    ///   `int stat:prefetch_preempted` :
+    ///           Number of tiles queued for background reading by
+    ///           `prefetch()`, and how many of those were needed by a
+    ///           lookup before the background read had started (and so
+    ///           were read by the thread doing the lookup).
+    ///
+    /// - `int stat:compressed_tiles_stored` ,
+    ///   `int stat:compressed_tiles_hits` ,
+    ///   `int stat:compressed_tiles_misses` :
+    ///           Number of tiles evicted into the compressed tier (see
+    ///           `max_compressed_memory_MB`), and the number of tile reads
+    ///           that were satisfied from it (rather than from the file)
+    ///           or had to go to the file after all.
+    ///
+    /// - `int64 stat:compressed_memory_used` :
+    ///           Memory currently used by the compressed tier.
+    ///
+    /// - `int64 stat:find_tile_microcache_assoc_hits` :
+    ///           Number of tile lookups that missed each thread's last two
+    ///           tiles but were found in its set-associative microcache
+    ///           (see `microcache_size`).
+    ///
+    /// - `int stat:mapped_tiles` :
+    ///           Number of tiles used in place from memory-mapped files
+    ///           (see `mmap_tiles`).
+    ///
+    /// - `int stat:constant_tiles` :
+    ///           Number of tiles read that turned out to be constant and
+    ///           were compacted (see `compact_constant_tiles`).
+    ///
+    /// - `int stat:shared_tiles_hits` :
+    /// - `int stat:shared_tiles_misses` :
+    ///           Number of tiles found (or not) in the `shared_tiles`
+    ///           segment instead of being read.
+    ///
+    /// - `int stat:dedup_tiles` :
+    ///           Number of tiles read that turned out to be identical to a
+    ///           tile already in the cache, and shared its pixels (see
+    ///           `deduplicate_tiles`).
+    /// - `int64 stat:dedup_bytes_saved` :
+    ///           Total memory those tiles did not need to allocate.
+    ///
+    /// - `int stat:disk_cache_hits` ,
+    ///   `int stat:disk_cache_misses` :
+    ///           Number of tile reads that were satisfied from the
+    ///           `disk_cache` directory, or had to go to the image file.
+    ///
     /// - `float stat:fileopen_time` :
     ///           I/O time related to opening and reading headers (but not
     ///           pixel I/O).
@@ -465,6 +676,19 @@ public:
     virtual ImageHandle* get_image_handle (ustring filename,
                                             Perthread *thread_info=NULL) = 0;
 
+    /// Retrieve the handles of many images at once, setting `handles[i]`
+    /// to the handle of the image named `filenames[i]`. This gives the
+    /// same handles as calling `get_image_handle()` for each name, but
+    /// finds the files and reads their headers in parallel.
+    ///
+    /// @returns
+    ///         `true` if all the handles are `good()`.
+    ///
+    /// This method was added in OpenImageIO 2.4.
+    virtual bool get_image_handles (cspan<ustring> filenames,
+                                    span<ImageHandle*> handles,
+                                    Perthread *thread_info=NULL) = 0;
+
     /// Return true if the image handle (previously returned by
     /// `get_image_handle()`) is a valid image that can be subsequently read.
     virtual bool good(ImageHandle* file) = 0;
@@ -974,6 +1198,83 @@ public:
                      stride_t xstride=AutoStride, stride_t ystride=AutoStride,
                      stride_t zstride=AutoStride, bool copy = true) = 0;
 
+    /// Asynchronously read into the cache all tiles of the named image
+    /// (at the given subimage and MIP level) that overlap `roi`, for the
+    /// channel range [chbegin,chend). If `roi` is `ROI::All()`, the whole
+    /// data window of that level is prefetched; if `chend < chbegin`, the
+    /// tiles will contain all channels of the image (as for `get_tile()`
+    /// and texture lookups, which is what should usually be requested).
+    ///
+    /// The tile reads are queued on a background thread pool (see the
+    /// `prefetch_threads` attribute) and this call returns immediately.
+    /// Tiles already resident or already being read are skipped. A later
+    /// lookup that needs a tile whose read is still queued will read it
+    /// itself; one that needs a tile currently being read will wait for
+    /// that read to finish rather than issue a redundant one. Prefetched
+    /// tiles are subject to the usual memory limit, so prefetching more
+    /// than fits in the cache is wasteful.
+    ///
+    /// @returns
+    ///         `true` if the request was successfully queued, `false` if
+    ///         the file could not be found or opened, or the subimage or
+    ///         MIP level does not exist.
+    virtual bool prefetch (ustring filename, int subimage, int miplevel,
+                           ROI roi = ROI::All(),
+                           int chbegin = 0, int chend = -1) = 0;
+    /// A slightly more efficient variety of `prefetch()` for cases where
+    /// you can use an `ImageHandle*` to specify the image and optionally
+    /// have a `Perthread*` for the calling thread.
+    virtual bool prefetch (ImageHandle *file, Perthread *thread_info,
+                           int subimage, int miplevel, ROI roi = ROI::All(),
+                           int chbegin = 0, int chend = -1) = 0;
+
+    /// Write to the named file a manifest of all the tiles (file,
+    /// subimage, MIP level and position) read into the cache so far,
+    /// whether or not they are still resident. A later run that will need
+    /// much the same tiles (such as another render of the same shot) can
+    /// pass the manifest to `preload_tile_manifest()` to read them all up
+    /// front, in parallel, rather than stalling on each one the first
+    /// time it's needed. See also the `tile_manifest` attribute.
+    ///
+    /// @returns
+    ///         `true` upon success, `false` if the file could not be
+    ///         written.
+    virtual bool write_tile_manifest (string_view filename) const = 0;
+
+    /// Read into the cache all the tiles (with all channels) listed in
+    /// the manifest file written by `write_tile_manifest()`. If `wait` is
+    /// true, the tiles are read in parallel (using the default thread
+    /// pool) and the call returns when they all are in the cache;
+    /// otherwise, they are queued as for `prefetch()` and the call returns
+    /// immediately. The tiles are subject to the usual memory limit.
+    ///
+    /// @returns
+    ///         `true` upon success, `false` if the manifest could not be
+    ///         read or some of the files it lists could not be opened (the
+    ///         tiles of the others are still read).
+    virtual bool preload_tile_manifest (string_view filename,
+                                        bool wait = true) = 0;
+
+    /// Open all the named files and read their headers, in parallel,
+    /// rather than one at a time as each is first needed. This is much
+    /// faster when there are many files to open, such as at the start of
+    /// a render of a scene that uses thousands of textures. Files already
+    /// open are skipped, and a later lookup of a file whose header is
+    /// still being read just waits for it, so this may be called with
+    /// every file a scene might need.
+    ///
+    /// If `wait` is true, the headers are read using the default thread
+    /// pool and the call returns when they all have been; otherwise, the
+    /// files are queued on the `prefetch()` threads and the call returns
+    /// immediately.
+    ///
+    /// @returns
+    ///         `true` upon success, `false` if `wait` was true and some
+    ///         of the files could not be opened. (A file that can't be
+    ///         opened is marked broken just as if a lookup had tried to
+    ///         open it, subject to `missing_file_retry_time`.)
+    virtual bool open_files (cspan<ustring> filenames, bool wait = false) = 0;
+
     /// @}
 
     /// @{
@@ -941,6 +941,10 @@ public:
     /// - `"arbitrary_metadata"` : Does this format allow metadata with
     ///       arbitrary names and types?
     ///
+    /// - `"constant_tiles"` :
+    ///       Can this format reader identify tiles that have one value in
+    ///       every pixel without reading them, via `tile_constant_value()`?
+    ///
     /// - `"exif"` :
     ///       Can this format store Exif camera data?
     ///
@@ -1577,6 +1581,27 @@ public:
                                     int xbegin, int xend, int ybegin, int yend,
                                     int zbegin, int zend,
                                     int chbegin, int chend, void *data);
+
+    /// If the tile (all channels) whose upper left corner is at `x, y, z`
+    /// is stored in the file exactly as read_native_tile() would return it
+    /// -- uncompressed, channels interleaved, in the native data format
+    /// and byte order of this machine, needing no other transformation --
+    /// return true and store in `offset` the position in the file of its
+    /// first byte, so that a caller may map the file into memory and use
+    /// the pixels in place. The base class implementation returns false,
+    /// as should any reader for which this isn't so.
+    virtual bool tile_file_offset (int subimage, int miplevel,
+                                   int x, int y, int z, int64_t &offset);
+
+    /// If the tile (all channels) whose upper left corner is at `x, y, z`
+    /// is known, without reading it, to have the same value in every pixel
+    /// -- for example, a region of a sparse volume where nothing is stored
+    /// -- return true and store that value, one pixel of native data, in
+    /// `pixel`. The base class implementation returns false, as should any
+    /// reader that can't tell cheaply; readers that can should also return
+    /// true for `supports("constant_tiles")`.
+    virtual bool tile_constant_value (int subimage, int miplevel,
+                                      int x, int y, int z, void *pixel);
     /// @}
 
 
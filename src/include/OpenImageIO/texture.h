@@ -105,7 +105,8 @@ enum class InterpMode {
     Closest,      ///< Force closest texel
     Bilinear,     ///< Force bilinear lookup within a mip level
     Bicubic,      ///< Force cubic lookup within a mip level
-    SmartBicubic  ///< Bicubic when magnifying, else bilinear
+    SmartBicubic, ///< Bicubic when magnifying, else bilinear
+    StochasticBilinear, ///< One texel, chosen with the bilinear weights
 };
 
 
@@ -204,7 +205,8 @@ public:
         InterpClosest,      ///< Force closest texel
         InterpBilinear,     ///< Force bilinear lookup within a mip level
         InterpBicubic,      ///< Force cubic lookup within a mip level
-        InterpSmartBicubic  ///< Bicubic when magnifying, else bilinear
+        InterpSmartBicubic, ///< Bicubic when magnifying, else bilinear
+        InterpStochasticBilinear, ///< One texel, chosen with the bilinear weights
     };
 
 
@@ -767,6 +769,21 @@ public:
     virtual TextureHandle * get_texture_handle (ustring filename,
                                             Perthread *thread_info=nullptr) = 0;
 
+    /// Retrieve the handles of many textures at once, setting
+    /// `handles[i]` to the handle of the texture named `filenames[i]`.
+    /// This gives the same handles as calling `get_texture_handle()` for
+    /// each name, but finds the files and reads their headers in parallel,
+    /// which is much faster when loading a scene that names thousands of
+    /// textures.
+    ///
+    /// @returns
+    ///         `true` if all the handles are `good()`.
+    ///
+    /// This method was added in OpenImageIO 2.4.
+    virtual bool get_texture_handles (cspan<ustring> filenames,
+                                      span<TextureHandle*> handles,
+                                      Perthread *thread_info=nullptr) = 0;
+
     /// Return true if the texture handle (previously returned by
     /// `get_image_handle()`) is a valid texture that can be subsequently
     /// read.
@@ -875,6 +892,48 @@ public:
                           int nchannels, float *result,
                           float *dresultds=nullptr, float *dresultdt=nullptr) = 0;
 
+    /// Perform filtered 2D texture lookups at the four points of a 2x2
+    /// quad of pixels (or any four nearby points) that share one set of
+    /// derivatives, as a rasterizer shading quads or a ray tracer with ray
+    /// differentials may have. The texture is resolved, and the MIP
+    /// level(s) and anisotropic filter shape are computed, just once for
+    /// all four points, and lookups of the same tiles by neighboring
+    /// points are found in the per-thread tile microcache, so this is
+    /// faster than four calls to texture(). The results are the same as
+    /// for four texture() calls with the same derivatives, except that for
+    /// stochastic MIP modes all four points make the same random choice of
+    /// MIP level.
+    ///
+    /// @param  s/t
+    ///             Pointers to the 2D texture coordinates of the four
+    ///             points, each as a `float[4]`.
+    /// @param  result[]
+    ///             The results of the lookups will be placed in
+    ///             `result[0..4*nchannels-1]`, with the result of point `i`
+    ///             starting at `result[i*nchannels]`.
+    /// @param  dresultds/dresultdt
+    ///             If non-null, storage for the derivatives of the results,
+    ///             laid out like `result`.
+    ///
+    /// All other parameters are as for texture(). This was added in
+    /// OpenImageIO 2.4.
+    virtual bool texture_quad (ustring filename, TextureOpt &options,
+                               const float *s, const float *t,
+                               float dsdx, float dtdx, float dsdy, float dtdy,
+                               int nchannels, float *result,
+                               float *dresultds=nullptr,
+                               float *dresultdt=nullptr) = 0;
+
+    /// Slightly faster version of texture_quad() if the app already has a
+    /// texture handle and per-thread info.
+    virtual bool texture_quad (TextureHandle *texture_handle,
+                               Perthread *thread_info, TextureOpt &options,
+                               const float *s, const float *t,
+                               float dsdx, float dtdx, float dsdy, float dtdy,
+                               int nchannels, float *result,
+                               float *dresultds=nullptr,
+                               float *dresultdt=nullptr) = 0;
+
 
     /// Perform a filtered 3D volumetric texture lookup on a position
     /// centered at 3D position `P` (with given differentials) from the
@@ -303,6 +303,20 @@ public:
         return i;
     }
 
+    /// Return an iterator pointing to the first entry in bin `b`, with
+    /// that bin locked, or the end() iterator if the bin is empty. Used
+    /// with `iterator::incr_no_lock()`, this allows visiting the entries
+    /// of just one bin.
+    iterator begin_bin(size_t b)
+    {
+        OIIO_DASSERT(b < BINS);
+        iterator i(this);
+        i.rebin(int(b));
+        if (i.m_biniterator == m_bins[b].map.end())
+            i.unbin();
+        return i;
+    }
+
     /// Search for key.  If found, return an iterator referring to the
     /// element, otherwise, return an iterator that is equivalent to
     /// this->end().  If do_lock is true, lock the bin that we're
@@ -482,6 +496,12 @@ public:
     /// holds the lock).
     void unlock_bin(size_t bin) { m_bins[bin].unlock(); }
 
+    /// Return the number of bins.
+    static constexpr size_t nbins() { return BINS; }
+
+    /// Return the number of the bin that holds (or would hold) key.
+    size_t bin_of(const KEY& key) { return whichbin(m_hash(key)); }
+
     // Return a mask that is 1 for bits of the hash that are not used to
     // determine the bin number.
     static constexpr size_t nobin_mask() { return ~size_t(0) >> log2(BINS); }
@@ -3,14 +3,26 @@
 // https://github.com/OpenImageIO/oiio
 
 
+#include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
+#include <OpenImageIO/parallel.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
 #include <OpenImageIO/unittest.h>
 
+#include <algorithm>
 #include <iostream>
 
+#ifndef _WIN32
+#    include <unistd.h>
+#endif
+#ifdef __linux__
+#    include <sys/wait.h>
+#endif
+
 using namespace OIIO;
 
 
@@ -134,6 +146,1180 @@ test_app_buffer()
 
 
 
+// Test that prefetch() brings in exactly the tiles overlapping the ROI, and
+// that the prefetched pixels are right.
+void
+test_prefetch(int prefetch_threads)
+{
+    std::cout << "\nTesting IC prefetch with " << prefetch_threads
+              << " prefetch threads\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("prefetch_threads", prefetch_threads);
+
+    // Create a 256x256 file with 64x64 tiles
+    ustring filename("prefetch.tif");
+    ImageSpec spec(256, 256, 3, TypeDesc::UINT8);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+                       { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+    A.write(filename);
+
+    // Prefetch a region straddling 2x2 tiles, then the same again, which
+    // should not queue anything new.
+    OIIO_CHECK_ASSERT(
+        imagecache->prefetch(filename, 0, 0, ROI(32, 96, 100, 140)));
+    OIIO_CHECK_ASSERT(
+        imagecache->prefetch(filename, 0, 0, ROI(32, 96, 100, 140)));
+    int queued = -1;
+    imagecache->getattribute("stat:prefetch_tiles", queued);
+    OIIO_CHECK_EQUAL(queued, 4);
+
+    // Reading the prefetched region must not create any more tiles
+    float pixels[64 * 40 * 3];
+    OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 32, 96, 100,
+                                             140, 0, 1, TypeDesc::FLOAT,
+                                             pixels));
+    int created = -1;
+    imagecache->getattribute("stat:tiles_created", created);
+    OIIO_CHECK_EQUAL(created, 4);
+    float Apixel[3];
+    A.getpixel(95, 139, Apixel);
+    OIIO_CHECK_EQUAL(pixels[(39 * 64 + 63) * 3 + 0], Apixel[0]);
+    OIIO_CHECK_EQUAL(pixels[(39 * 64 + 63) * 3 + 1], Apixel[1]);
+    OIIO_CHECK_EQUAL(pixels[(39 * 64 + 63) * 3 + 2], Apixel[2]);
+
+    // The whole image, and bad requests
+    OIIO_CHECK_ASSERT(imagecache->prefetch(filename, 0, 0));
+    OIIO_CHECK_ASSERT(!imagecache->prefetch(filename, 0, 5));
+    OIIO_CHECK_ASSERT(!imagecache->prefetch(ustring("nonexistent.tif"), 0, 0));
+    OIIO_CHECK_ASSERT(!imagecache->prefetch(nullptr, nullptr, 0, 0));
+    imagecache->geterror();
+    imagecache->getattribute("stat:prefetch_tiles", queued);
+    OIIO_CHECK_EQUAL(queued, 16);
+
+    ImageCache::destroy(imagecache);
+}
+
+
+
+// Test many threads reading tiles of one file at once through several
+// ImageInputs ("readers_per_file").
+void
+test_concurrent_readers()
+{
+    std::cout << "\nTesting IC concurrent readers of one file\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("readers_per_file", 4);
+    int readers = 0;
+    imagecache->getattribute("readers_per_file", readers);
+    OIIO_CHECK_EQUAL(readers, 4);
+
+    ustring filename("concurrent.tif");
+    ImageSpec spec(512, 512, 3, TypeDesc::UINT8);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+                       { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+    A.write(filename);
+
+    // Each task reads one row of tiles and checks a pixel from each
+    std::atomic<int> mismatches(0);
+    parallel_for(0, 8, [&](int64_t row) {
+        int y = int(row) * 64 + 17;
+        float pixels[512 * 3];
+        if (!imagecache->get_pixels(filename, 0, 0, 0, 512, y, y + 1, 0, 1,
+                                    TypeDesc::FLOAT, pixels)) {
+            ++mismatches;
+            return;
+        }
+        for (int x = 5; x < 512; x += 64) {
+            float Apixel[3];
+            A.getpixel(x, y, Apixel);
+            for (int c = 0; c < 3; ++c)
+                if (pixels[x * 3 + c] != Apixel[c])
+                    ++mismatches;
+        }
+    });
+    OIIO_CHECK_EQUAL(mismatches, 0);
+
+    int open_files = 0;
+    imagecache->getattribute("stat:open_files_current", open_files);
+    OIIO_CHECK_ASSERT(open_files >= 1 && open_files <= 4);
+
+    ImageCache::destroy(imagecache);
+}
+
+
+
+// Many threads requesting tiles from an image much bigger than the cache,
+// so that nearly every get_tile() has to evict something. Checks that every
+// request is served and that the memory limit is (roughly) respected.
+void
+test_tile_eviction_threads()
+{
+    std::cout << "\nTesting IC threaded get_tile under memory pressure\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("max_memory_MB", 2.0f);
+    // Read the null reader's tiles in full, although they are constant
+    imagecache->attribute("skip_constant_tiles", 0);
+
+    // A procedural 1k x 1k float RGBA image in 64x64 tiles: 16 MB of
+    // pixels for a 2 MB cache.
+    ustring filename("evictstress");
+    ImageSpec config(1024, 1024, 4, TypeDesc::FLOAT);
+    config.tile_width  = 64;
+    config.tile_height = 64;
+    config.attribute("null:force", 1);
+    OIIO_CHECK_ASSERT(
+        imagecache->add_file(filename, NullInputCreator, &config));
+
+    const int nthreads = 8, ncalls = 1000, ntiles = 1024 / 64;
+    std::atomic<int> failures(0);
+    parallel_for(0, nthreads, [&](int64_t t) {
+        uint32_t rng = uint32_t(t) * 2654435761u + 1;
+        for (int i = 0; i < ncalls; ++i) {
+            rng   = rng * 1664525u + 1013904223u;
+            int x = int((rng >> 8) % ntiles) * 64;
+            int y = int((rng >> 20) % ntiles) * 64;
+            ImageCache::Tile* tile = imagecache->get_tile(filename, 0, 0, x,
+                                                          y, 0);
+            if (tile)
+                imagecache->release_tile(tile);
+            else
+                ++failures;
+        }
+    });
+    OIIO_CHECK_EQUAL(failures, 0);
+
+    long long mem_used = 0;
+    imagecache->getattribute("stat:cache_memory_used", TypeInt64, &mem_used);
+    std::cout << "  cache memory used " << Strutil::memformat(mem_used)
+              << "\n";
+    OIIO_CHECK_LE(mem_used, 2 * 2 * 1024 * 1024);
+
+    ImageCache::destroy(imagecache);
+}
+
+
+
+// Replay a mixed workload -- a texture-like working set that is used over
+// and over, interleaved with one-pass scans of a much larger image -- with
+// each tile cache policy, and compare the hit rate of the working set.
+static double
+replay_mixed_workload(const char* policy)
+{
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("max_memory_MB", 10.0f);
+    imagecache->attribute("skip_constant_tiles", 0);
+    imagecache->attribute("tile_cache_policy", policy);
+
+    // Procedural float RGBA images in 64x64 tiles (64 KB each): a working
+    // set of 96 tiles (6 MB), and a 4k x 4k image (256 MB) to scan.
+    ImageSpec config(4096, 4096, 4, TypeDesc::FLOAT);
+    config.tile_width  = 64;
+    config.tile_height = 64;
+    config.attribute("null:force", 1);
+    ustring texname("replay_texture"), scanname("replay_scan");
+    imagecache->add_file(texname, NullInputCreator, &config);
+    imagecache->add_file(scanname, NullInputCreator, &config);
+
+    ImageCache::Perthread* thread_info = imagecache->get_perthread_info();
+    ImageCache::ImageHandle* tex = imagecache->get_image_handle(texname);
+    ImageCache::ImageHandle* scan = imagecache->get_image_handle(scanname);
+    long long lookups = 0, misses = 0;
+    uint32_t rng = 1;
+    int scantile = 0;
+    for (int round = 0; round < 40; ++round) {
+        // Texture lookups, which are the ones we keep score of
+        int misses_before = 0;
+        imagecache->getattribute("stat:find_tile_cache_misses",
+                                 misses_before);
+        for (int i = 0; i < 2000; ++i) {
+            rng   = rng * 1664525u + 1013904223u;
+            int t = int((rng >> 8) % 96);
+            ImageCache::Tile* tile
+                = imagecache->get_tile(tex, thread_info, 0, 0, (t % 12) * 64,
+                                       (t / 12) * 64, 0);
+            imagecache->release_tile(tile);
+        }
+        int misses_after = 0;
+        imagecache->getattribute("stat:find_tile_cache_misses", misses_after);
+        lookups += 2000;
+        misses += misses_after - misses_before;
+        // Followed by a scan of 500 tiles (31 MB) that are used just once
+        for (int i = 0; i < 500; ++i, ++scantile) {
+            ImageCache::Tile* tile = imagecache->get_tile(
+                scan, thread_info, 0, 0, (scantile % 64) * 64,
+                ((scantile / 64) % 64) * 64, 0);
+            imagecache->release_tile(tile);
+        }
+    }
+    ImageCache::destroy(imagecache);
+    return 1.0 - double(misses) / double(lookups);
+}
+
+
+
+void
+test_cache_policy_replay()
+{
+    std::cout << "\nTesting tile cache policies on a mixed workload replay\n";
+    double clock    = replay_mixed_workload("clock");
+    double clockpro = replay_mixed_workload("clockpro");
+    std::cout << "  Working set hit rate: clock " << 100.0 * clock
+              << "%, clockpro " << 100.0 * clockpro << "%\n";
+    OIIO_CHECK_GE(clockpro, clock);
+
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(!imagecache->attribute("tile_cache_policy", "bogus"));
+    imagecache->geterror();
+    std::string policy;
+    imagecache->getattribute("tile_cache_policy", policy);
+    OIIO_CHECK_EQUAL(policy, "clock");
+    ImageCache::destroy(imagecache);
+}
+
+
+
+// Test that tiles evicted from the main cache are kept in the compressed
+// tier and come back from it with the right pixels.
+void
+test_compressed_tier()
+{
+    std::cout << "\nTesting IC compressed second-tier tile cache\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("max_memory_MB", 10.0f);
+    imagecache->attribute("max_compressed_memory_MB", 64);
+
+    // A 1k x 1k float RGBA image in 64x64 tiles (16 MB), which won't fit
+    // in the main cache.
+    ustring filename("compressedtier.exr");
+    ImageSpec spec(1024, 1024, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+                       { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+    A.write(filename);
+
+    // Two passes over all the tiles: by the second, the first tiles have
+    // been evicted and should come back from the compressed tier.
+    ImageCache::Perthread* thread_info = imagecache->get_perthread_info();
+    ImageCache::ImageHandle* handle = imagecache->get_image_handle(filename);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int y = 0; y < 1024; y += 64) {
+            for (int x = 0; x < 1024; x += 64) {
+                ImageCache::Tile* tile = imagecache->get_tile(handle,
+                                                              thread_info, 0,
+                                                              0, x, y, 0);
+                OIIO_CHECK_ASSERT(tile);
+                imagecache->release_tile(tile);
+            }
+        }
+    }
+    int stored = 0, hits = 0;
+    long long compressed_mem = 0;
+    imagecache->getattribute("stat:compressed_tiles_stored", stored);
+    imagecache->getattribute("stat:compressed_tiles_hits", hits);
+    imagecache->getattribute("stat:compressed_memory_used",
+                             TypeDesc::INT64, &compressed_mem);
+    std::cout << "  " << stored << " tiles stored, " << hits
+              << " promoted, " << Strutil::memformat(compressed_mem)
+              << " held\n";
+    OIIO_CHECK_GT(stored, 0);
+    OIIO_CHECK_GT(hits, 0);
+    OIIO_CHECK_LE(compressed_mem, 64LL * 1024 * 1024);
+
+    // Promoted pixels must match the file
+    float pixels[64 * 64 * 4];
+    OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 0, 64, 0, 64, 0,
+                                             1, TypeDesc::FLOAT, pixels));
+    float Apixel[4];
+    A.getpixel(63, 63, Apixel);
+    for (int c = 0; c < 4; ++c)
+        OIIO_CHECK_EQUAL(pixels[(63 * 64 + 63) * 4 + c], Apixel[c]);
+
+    // Invalidating the file must also drop its compressed tiles
+    imagecache->invalidate(filename);
+    imagecache->getattribute("stat:compressed_memory_used",
+                             TypeDesc::INT64, &compressed_mem);
+    OIIO_CHECK_EQUAL(compressed_mem, 0);
+
+    ImageCache::destroy(imagecache);
+}
+
+
+// Test that tiles are written to the disk cache by one ImageCache and read
+// back from it by another, and that the cache keeps to its size limit.
+void
+test_disk_cache()
+{
+    std::cout << "\nTesting IC persistent disk tile cache\n";
+    std::string cachedir = "disktilecache";
+    Filesystem::remove_all(cachedir);
+
+    // A 256x256 file with 64x64 tiles (12 KB each)
+    ustring filename("disktilecache.tif");
+    ImageSpec spec(256, 256, 3, TypeDesc::UINT8);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+                       { 0.0f, 1.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+    A.write(filename);
+
+    std::vector<float> pixels(256 * 256 * 3);
+    for (int run = 0; run < 2; ++run) {
+        ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+        imagecache->attribute("disk_cache", cachedir);
+        OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 0, 256, 0,
+                                                 256, 0, 1, TypeDesc::FLOAT,
+                                                 pixels.data()));
+        int hits = -1, misses = -1;
+        imagecache->getattribute("stat:disk_cache_hits", hits);
+        imagecache->getattribute("stat:disk_cache_misses", misses);
+        // The first run reads the file, the second one only the cache
+        OIIO_CHECK_EQUAL(hits, run ? 16 : 0);
+        OIIO_CHECK_EQUAL(misses, run ? 0 : 16);
+        float Apixel[3];
+        A.getpixel(200, 100, Apixel);
+        for (int c = 0; c < 3; ++c)
+            OIIO_CHECK_EQUAL(pixels[(100 * 256 + 200) * 3 + c], Apixel[c]);
+        ImageCache::destroy(imagecache);
+    }
+
+    // With a limit of 100 KB, only some of the tiles are kept
+    Filesystem::remove_all(cachedir);
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("disk_cache", cachedir);
+    imagecache->attribute("max_disk_cache_MB", 0.1f);
+    OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 0, 256, 0, 256,
+                                             0, 1, TypeDesc::FLOAT,
+                                             pixels.data()));
+    ImageCache::destroy(imagecache);
+    std::vector<std::string> files;
+    Filesystem::get_directory_entries(cachedir, files, true);
+    long long total = 0;
+    for (auto& f : files)
+        total += (long long)Filesystem::file_size(f);
+    OIIO_CHECK_GT(total, 0);
+    OIIO_CHECK_LE(total, (long long)(0.1 * 1024 * 1024));
+    Filesystem::remove_all(cachedir);
+}
+
+
+// Test that with "mmap_tiles", the tiles of an uncompressed tiled TIFF are
+// used in place, and those of a compressed one are not.
+void
+test_mmap_tiles()
+{
+    std::cout << "\nTesting IC memory-mapped tiles\n";
+    ImageSpec spec(256, 256, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+                       { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+    for (const char* compression : { "none", "zip" }) {
+        ustring filename(Strutil::sprintf("mmaptiles_%s.tif", compression));
+        A.specmod().attribute("compression", compression);
+        A.write(filename);
+
+        ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+        imagecache->attribute("mmap_tiles", 1);
+        std::vector<float> pixels(256 * 256 * 4);
+        OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 0, 256, 0,
+                                                 256, 0, 1, TypeDesc::FLOAT,
+                                                 pixels.data()));
+        int mapped = -1;
+        long long mem = -1;
+        imagecache->getattribute("stat:mapped_tiles", mapped);
+        imagecache->getattribute("stat:cache_memory_used", TypeDesc::INT64,
+                                 &mem);
+        if (!strcmp(compression, "none")) {
+            OIIO_CHECK_EQUAL(mapped, 16);
+            OIIO_CHECK_EQUAL(mem, 0);  // Mapped tiles aren't charged
+        } else {
+            OIIO_CHECK_EQUAL(mapped, 0);
+        }
+        float Apixel[4];
+        A.getpixel(200, 100, Apixel);
+        for (int c = 0; c < 4; ++c)
+            OIIO_CHECK_EQUAL(pixels[(100 * 256 + 200) * 4 + c], Apixel[c]);
+        ImageCache::destroy(imagecache);
+    }
+}
+
+
+// Test that constant tiles are compacted to a single pixel's worth of cache
+// memory, and still read back correctly.
+void
+test_constant_tiles()
+{
+    std::cout << "\nTesting IC constant tile compaction\n";
+    ImageSpec spec(256, 256, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.25f, 0.5f, 0.75f, 1.0f });
+    // Only the two tiles at the top right vary
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+                       { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f },
+                       ROI(128, 256, 0, 64));
+    ustring filename("constanttiles.tif");
+    A.write(filename);
+
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("compact_constant_tiles", 1);
+    std::vector<float> pixels(256 * 256 * 4);
+    OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 0, 256, 0, 256,
+                                             0, 1, TypeDesc::FLOAT,
+                                             pixels.data()));
+    int constant  = -1;
+    long long mem = -1;
+    imagecache->getattribute("stat:constant_tiles", constant);
+    imagecache->getattribute("stat:cache_memory_used", TypeDesc::INT64, &mem);
+    std::cout << "  " << constant << " constant tiles, "
+              << Strutil::memformat(mem) << " used\n";
+    // The two tiles that vary, plus a pixel for each of the 14 constant
+    // tiles
+    OIIO_CHECK_EQUAL(constant, 14);
+    OIIO_CHECK_GT(mem, 2 * 64 * 64 * 16);
+    OIIO_CHECK_LT(mem, 3 * 64 * 64 * 16);
+    for (int y : { 10, 100, 200 }) {
+        for (int x : { 10, 150, 250 }) {
+            float Apixel[4];
+            A.getpixel(x, y, Apixel);
+            for (int c = 0; c < 4; ++c)
+                OIIO_CHECK_EQUAL(pixels[(y * 256 + x) * 4 + c], Apixel[c]);
+        }
+    }
+    // Asking for all the pixels of a constant tile gets them laid out in
+    // full, in one buffer that's then charged to the cache.
+    ImageCache::Tile* tile = imagecache->get_tile(filename, 0, 0, 64, 64, 0);
+    OIIO_CHECK_ASSERT(tile);
+    if (tile) {
+        TypeDesc format;
+        const float* p = (const float*)imagecache->tile_pixels(tile, format);
+        OIIO_CHECK_EQUAL(format, TypeDesc::FLOAT);
+        OIIO_CHECK_ASSERT(p);
+        if (p) {
+            for (int i : { 0, 100, 64 * 64 - 1 }) {
+                OIIO_CHECK_EQUAL(p[4 * i + 0], 0.25f);
+                OIIO_CHECK_EQUAL(p[4 * i + 3], 1.0f);
+            }
+        }
+        imagecache->release_tile(tile);
+    }
+    imagecache->getattribute("stat:cache_memory_used", TypeDesc::INT64, &mem);
+    OIIO_CHECK_GT(mem, 3 * 64 * 64 * 16);
+    ImageCache::destroy(imagecache);
+}
+
+
+// An ImageInput whose tiles are each constant, but all of different
+// values, like an ID map or the coarse levels of a MIP map.
+class ConstantTilesInput final : public ImageInput {
+public:
+    ConstantTilesInput() {}
+    virtual const char* format_name(void) const override
+    {
+        return "constanttiles";
+    }
+    virtual bool open(const std::string& /*name*/, ImageSpec& newspec) override
+    {
+        m_spec             = ImageSpec(4096, 4096, 4, TypeDesc::FLOAT);
+        m_spec.tile_width  = 64;
+        m_spec.tile_height = 64;
+        newspec            = m_spec;
+        return true;
+    }
+    virtual bool close() override { return true; }
+    virtual bool read_native_scanline(int /*subimage*/, int /*miplevel*/,
+                                      int /*y*/, int /*z*/,
+                                      void* /*data*/) override
+    {
+        return false;
+    }
+    virtual bool read_native_tile(int /*subimage*/, int /*miplevel*/, int x,
+                                  int y, int /*z*/, void* data) override
+    {
+        float value = float(y / 64 * 64 + x / 64);
+        std::fill((float*)data, (float*)data + m_spec.tile_pixels() * 4,
+                  value);
+        return true;
+    }
+};
+
+
+
+static ImageInput*
+ConstantTilesInputCreator()
+{
+    return new ConstantTilesInput;
+}
+
+
+
+// Test the memory of constant tiles: 4096 constant tiles of different
+// values, 256 MB in all, take a pixel each. But once their pixels are
+// asked for in full, read through a 10 MB cache they must evict tiles and
+// free those buffers.
+void
+test_constant_tile_memory()
+{
+    std::cout << "\nTesting IC memory of many different constant tiles\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("max_memory_MB", 10.0f);
+    imagecache->attribute("compact_constant_tiles", 1);
+    ustring filename("constanttiles_memory");
+    OIIO_CHECK_ASSERT(
+        imagecache->add_file(filename, ConstantTilesInputCreator));
+    long long mem_used = 0;
+    for (bool full : { false, true }) {
+        for (int y = 0; y < 4096; y += 64) {
+            for (int x = 0; x < 4096; x += 64) {
+                ImageCache::Tile* tile = imagecache->get_tile(filename, 0, 0,
+                                                              x, y, 0);
+                OIIO_CHECK_ASSERT(tile);
+                if (!tile)
+                    continue;
+                TypeDesc format;
+                if (full)
+                    OIIO_CHECK_ASSERT(imagecache->tile_pixels(tile, format));
+                imagecache->release_tile(tile);
+            }
+        }
+        int constant = -1;
+        imagecache->getattribute("stat:constant_tiles", constant);
+        imagecache->getattribute("stat:cache_memory_used", TypeInt64,
+                                 &mem_used);
+        std::cout << "  " << constant << " constant tiles"
+                  << (full ? " in full" : "") << ", cache memory used "
+                  << Strutil::memformat(mem_used) << "\n";
+        if (full) {
+            OIIO_CHECK_GT(mem_used, 5 * 1024 * 1024);
+            OIIO_CHECK_LE(mem_used, 2 * 10 * 1024 * 1024);
+        } else {
+            OIIO_CHECK_EQUAL(constant, 4096);
+            OIIO_CHECK_LT(mem_used, 1024 * 1024);
+        }
+    }
+    ImageCache::destroy(imagecache);
+}
+
+
+// Test that tiles the reader reports as constant, as the null reader does
+// for all of its tiles, are never read or allocated at full size, even
+// without "compact_constant_tiles".
+void
+test_constant_tile_values()
+{
+    std::cout << "\nTesting IC constant tiles reported by the reader\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    ImageSpec config(256, 256, 3, TypeDesc::FLOAT);
+    config.tile_width  = 64;
+    config.tile_height = 64;
+    config.attribute("null:force", 1);
+    ustring filename("constantvalue_test?PIXEL=0.25,0.5,0.75");
+    imagecache->add_file(filename, NullInputCreator, &config);
+
+    std::vector<float> pixels(256 * 256 * 3);
+    OIIO_CHECK_ASSERT(imagecache->get_pixels(filename, 0, 0, 0, 256, 0, 256,
+                                             0, 1, TypeDesc::FLOAT,
+                                             pixels.data()));
+    int constant        = -1;
+    long long bytesread = -1, mem = -1;
+    imagecache->getattribute("stat:constant_tiles", constant);
+    imagecache->getattribute("stat:bytes_read", TypeDesc::INT64, &bytesread);
+    imagecache->getattribute("stat:cache_memory_used", TypeDesc::INT64, &mem);
+    // All 16 tiles together take less than one tile at full size
+    OIIO_CHECK_EQUAL(constant, 16);
+    OIIO_CHECK_EQUAL(bytesread, 0);
+    OIIO_CHECK_GT(mem, 16 * 12);
+    OIIO_CHECK_LT(mem, 64 * 64 * 12);
+    for (int i : { 0, 1000, 65535 }) {
+        OIIO_CHECK_EQUAL(pixels[3 * i + 0], 0.25f);
+        OIIO_CHECK_EQUAL(pixels[3 * i + 1], 0.5f);
+        OIIO_CHECK_EQUAL(pixels[3 * i + 2], 0.75f);
+    }
+    ImageCache::destroy(imagecache);
+}
+
+
+// Test that with "deduplicate_tiles", the tiles that two different files
+// have in common are stored only once.
+void
+test_dedup_tiles()
+{
+    std::cout << "\nTesting IC tile deduplication\n";
+    ImageSpec spec(256, 256, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+                       { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+    A.write("dedup_a.tif");
+    // B differs from A only in its top left tile
+    ImageBufAlgo::fill(A, { 0.5f, 0.5f, 0.5f, 1.0f }, ROI(0, 64, 0, 64));
+    A.write("dedup_b.tif");
+
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("deduplicate_tiles", 1);
+    std::vector<float> pixels(256 * 256 * 4);
+    for (const char* name : { "dedup_a.tif", "dedup_b.tif" })
+        OIIO_CHECK_ASSERT(imagecache->get_pixels(ustring(name), 0, 0, 0, 256,
+                                                 0, 256, 0, 1, TypeDesc::FLOAT,
+                                                 pixels.data()));
+    int dedup           = -1;
+    long long saved     = -1;
+    long long mem       = -1;
+    const int tilebytes = 64 * 64 * 16;
+    imagecache->getattribute("stat:dedup_tiles", dedup);
+    imagecache->getattribute("stat:dedup_bytes_saved", TypeDesc::INT64, &saved);
+    imagecache->getattribute("stat:cache_memory_used", TypeDesc::INT64, &mem);
+    std::cout << "  " << dedup << " deduplicated tiles, "
+              << Strutil::memformat(saved) << " saved, "
+              << Strutil::memformat(mem) << " used\n";
+    OIIO_CHECK_EQUAL(dedup, 15);
+    OIIO_CHECK_GE(saved, 15LL * tilebytes);
+    OIIO_CHECK_LT(mem, 18LL * tilebytes);
+    // The pixels of B (the last read) must be right
+    for (int y : { 10, 100, 200 }) {
+        for (int x : { 10, 150, 250 }) {
+            float Apixel[4];
+            A.getpixel(x, y, Apixel);
+            for (int c = 0; c < 4; ++c)
+                OIIO_CHECK_EQUAL(pixels[(y * 256 + x) * 4 + c], Apixel[c]);
+        }
+    }
+    ImageCache::destroy(imagecache);
+}
+
+
+// Test that two caches attached to the same shared tile store read each
+// tile only once between them.
+void
+test_shared_tiles()
+{
+#ifdef __linux__
+    std::cout << "\nTesting IC shared memory tile store\n";
+    ImageSpec spec(256, 256, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+                       { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+    ustring filename("sharedtiles.tif");
+    A.write(filename);
+
+    std::string shmname = Strutil::sprintf("/oiio_test_%d", int(getpid()));
+    ImageCache* ic[2];
+    for (auto& c : ic) {
+        c = ImageCache::create(false /*not shared*/);
+        c->attribute("max_shared_memory_MB", 8);
+        c->attribute("shared_tiles", shmname);
+        std::string name;
+        c->getattribute("shared_tiles", name);
+        OIIO_CHECK_EQUAL(name, shmname);
+    }
+    std::vector<float> pixels(256 * 256 * 4);
+    for (int i = 0; i < 2; ++i) {
+        OIIO_CHECK_ASSERT(ic[i]->get_pixels(filename, 0, 0, 0, 256, 0, 256,
+                                            0, 1, TypeDesc::FLOAT,
+                                            pixels.data()));
+        int hits = -1, misses = -1;
+        long long mem = -1;
+        ic[i]->getattribute("stat:shared_tiles_hits", hits);
+        ic[i]->getattribute("stat:shared_tiles_misses", misses);
+        ic[i]->getattribute("stat:cache_memory_used", TypeDesc::INT64, &mem);
+        std::cout << "  cache " << i << ": " << hits << " hits, " << misses
+                  << " misses\n";
+        OIIO_CHECK_EQUAL(hits, i ? 16 : 0);
+        OIIO_CHECK_EQUAL(misses, i ? 0 : 16);
+        // Each cache is charged for the shared tiles it uses
+        OIIO_CHECK_GE(mem, 16 * 64 * 64 * 16);
+        OIIO_CHECK_LT(mem, 17 * 64 * 64 * 16);
+        float Apixel[4];
+        A.getpixel(200, 100, Apixel);
+        for (int c = 0; c < 4; ++c)
+            OIIO_CHECK_EQUAL(pixels[(100 * 256 + 200) * 4 + c], Apixel[c]);
+    }
+    for (auto& c : ic)
+        ImageCache::destroy(c);
+#endif
+}
+
+
+// Test that a shared tile store smaller than the working set keeps
+// recycling its slots: each cache charges the shared tiles it uses to its
+// own memory limit, so what it evicts, it lets go of in the store too.
+void
+test_shared_tiles_recycle()
+{
+#ifdef __linux__
+    std::cout << "\nTesting IC shared tile store smaller than the working set\n";
+    // 1024 tiles of 16 KB: 16 MB through a 12 MB store and 10 MB caches
+    ImageSpec spec(2048, 2048, 4, TypeDesc::UINT8);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+                       { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+    ustring filename("sharedtiles_recycle.tif");
+    A.write(filename);
+
+    std::string shmname = Strutil::sprintf("/oiio_test_recycle_%d",
+                                           int(getpid()));
+    ImageCache* ic[2];
+    for (auto& c : ic) {
+        c = ImageCache::create(false /*not shared*/);
+        c->attribute("max_memory_MB", 10.0f);
+        c->attribute("max_shared_memory_MB", 12);
+        c->attribute("shared_tile_bytes", 64 * 64 * 4);
+        c->attribute("shared_tiles", shmname);
+    }
+
+    // The first cache reads every tile once, in order...
+    for (int y = 0; y < 2048; y += 64) {
+        for (int x = 0; x < 2048; x += 64) {
+            ImageCache::Tile* tile = ic[0]->get_tile(filename, 0, 0, x, y, 0);
+            OIIO_CHECK_ASSERT(tile);
+            if (tile)
+                ic[0]->release_tile(tile);
+        }
+    }
+    long long mem = -1;
+    ic[0]->getattribute("stat:cache_memory_used", TypeDesc::INT64, &mem);
+    std::cout << "  cache memory used " << Strutil::memformat(mem) << "\n";
+    OIIO_CHECK_GT(mem, 5 * 1024 * 1024);
+    OIIO_CHECK_LE(mem, 2 * 10 * 1024 * 1024);
+
+    // ...and the second still finds the last ones it read in the store.
+    for (int x = 0; x < 2048; x += 64) {
+        ImageCache::Tile* tile = ic[1]->get_tile(filename, 0, 0, x, 2048 - 64,
+                                                 0);
+        OIIO_CHECK_ASSERT(tile);
+        if (tile)
+            ic[1]->release_tile(tile);
+    }
+    int hits = -1;
+    ic[1]->getattribute("stat:shared_tiles_hits", hits);
+    std::cout << "  " << hits << " of 32 tiles found in the store\n";
+    OIIO_CHECK_EQUAL(hits, 32);
+    for (auto& c : ic)
+        ImageCache::destroy(c);
+#endif
+}
+
+
+// Test that the tiles held by a process that died without detaching from
+// the shared tile store are let go of, so that the others can reuse them.
+void
+test_shared_tiles_dead_holder()
+{
+#ifdef __linux__
+    std::cout << "\nTesting IC shared tile store with a dead process\n";
+    // Two images of 16 tiles, through a store with exactly 16 slots
+    ImageSpec spec(256, 256, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ustring filename[2] = { ustring("sharedtiles_dead_0.tif"),
+                            ustring("sharedtiles_dead_1.tif") };
+    for (int i = 0; i < 2; ++i) {
+        ImageBufAlgo::fill(A, { 0.25f * i, 0.5f, 0.0f, 1.0f });
+        A.write(filename[i]);
+    }
+    std::string shmname = Strutil::sprintf("/oiio_test_dead_%d",
+                                           int(getpid()));
+    auto make_cache = [&]() {
+        ImageCache* ic = ImageCache::create(false /*not shared*/);
+        ic->attribute("max_shared_memory_MB", 1.01f);
+        ic->attribute("shared_tile_bytes", 64 * 64 * 4 * 4);
+        ic->attribute("shared_tiles", shmname);
+        return ic;
+    };
+    auto read_all = [](ImageCache* ic, ustring filename) {
+        std::vector<float> pixels(256 * 256 * 4);
+        return ic->get_pixels(filename, 0, 0, 0, 256, 0, 256, 0, 1,
+                              TypeDesc::FLOAT, pixels.data());
+    };
+
+    // The parent stays attached, so the segment outlives the child, which
+    // fills every slot and exits without letting go of any of them.
+    ImageCache* ic[2] = { make_cache(), make_cache() };
+    pid_t child = fork();
+    if (child == 0) {
+        ImageCache* childic = make_cache();
+        _exit(read_all(childic, filename[0]) ? 0 : 1);
+    }
+    OIIO_CHECK_ASSERT(child > 0);
+    int status = -1;
+    waitpid(child, &status, 0);
+    OIIO_CHECK_ASSERT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // The first cache can only store its tiles if the dead child's slots
+    // are reclaimed, and then the second finds them all.
+    for (int i = 0; i < 2; ++i) {
+        OIIO_CHECK_ASSERT(read_all(ic[i], filename[1]));
+        int hits = -1;
+        ic[i]->getattribute("stat:shared_tiles_hits", hits);
+        std::cout << "  cache " << i << ": " << hits << " hits\n";
+        OIIO_CHECK_EQUAL(hits, i ? 16 : 0);
+    }
+    for (auto& c : ic)
+        ImageCache::destroy(c);
+#endif
+}
+
+
+// Test that a tile manifest written by one cache preloads just the tiles
+// it used into another.
+void
+test_tile_manifest()
+{
+    std::cout << "\nTesting IC tile manifest\n";
+    ImageSpec spec(256, 256, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f },
+                       { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f });
+    ustring filename("manifest.tif");
+    A.write(filename);
+
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    int tiles[3][2] = { { 0, 0 }, { 128, 64 }, { 192, 192 } };
+    for (auto& t : tiles) {
+        ImageCache::Tile* tile = ic->get_tile(filename, 0, 0, t[0], t[1], 0);
+        OIIO_CHECK_ASSERT(tile);
+        ic->release_tile(tile);
+    }
+    OIIO_CHECK_ASSERT(ic->write_tile_manifest("test.manifest"));
+    ImageCache::destroy(ic);
+
+    ic = ImageCache::create(false /*not shared*/);
+    OIIO_CHECK_ASSERT(ic->preload_tile_manifest("test.manifest"));
+    int preloaded = -1;
+    ic->getattribute("stat:prefetch_tiles", preloaded);
+    OIIO_CHECK_EQUAL(preloaded, 3);
+    // Getting the same tiles again reads nothing more
+    for (auto& t : tiles) {
+        ImageCache::Tile* tile = ic->get_tile(filename, 0, 0, t[0], t[1], 0);
+        OIIO_CHECK_ASSERT(tile);
+        ic->release_tile(tile);
+    }
+    int created = -1;
+    ic->getattribute("stat:tiles_created", created);
+    OIIO_CHECK_EQUAL(created, 3);
+    OIIO_CHECK_ASSERT(!ic->preload_tile_manifest("nonexistent.manifest"));
+    ic->geterror();
+    ImageCache::destroy(ic);
+}
+
+
+// Test that a tile trace records the lookups that reach the main cache.
+void
+test_trace()
+{
+    std::cout << "\nTesting IC tile trace\n";
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    ImageSpec config(256, 256, 4, TypeDesc::FLOAT);
+    config.tile_width  = 64;
+    config.tile_height = 64;
+    config.attribute("null:force", 1);
+    ustring filename("trace_test");
+    ic->add_file(filename, NullInputCreator, &config);
+
+    ic->attribute("microcache_size", 0);
+    ic->attribute("trace_file", "test.tiletrace");
+    // Cycling among 3 tiles always misses the two-tile microcache
+    for (int i = 0; i < 6; ++i) {
+        int t                  = i % 3;
+        ImageCache::Tile* tile = ic->get_tile(filename, 0, 0, t * 64, 0, 0);
+        OIIO_CHECK_ASSERT(tile);
+        ic->release_tile(tile);
+    }
+    ic->attribute("trace_file", "");
+    std::string trace;
+    OIIO_CHECK_ASSERT(Filesystem::read_text_file("test.tiletrace", trace));
+    OIIO_CHECK_ASSERT(Strutil::starts_with(trace, "OIIOtrc1"));
+    // Magic, the file name, then one chunk of 40 byte tile records
+    size_t size = 8 + (12 + filename.size()) + 8 + 6 * 40;
+    OIIO_CHECK_EQUAL(trace.size(), size);
+    ImageCache::destroy(ic);
+}
+
+
+// Test that open_files() opens the files up front, and that a missing file
+// is only looked for again after "missing_file_retry_time".
+void
+test_open_files()
+{
+    std::cout << "\nTesting IC open_files and missing file retries\n";
+    ImageBuf A(ImageSpec(64, 64, 3, TypeDesc::UINT8));
+    ImageBufAlgo::fill(A, { 0.5f, 0.25f, 1.0f });
+    std::vector<ustring> filenames;
+    for (int i = 0; i < 8; ++i) {
+        filenames.emplace_back(Strutil::sprintf("openfiles_%d.tif", i));
+        A.write(filenames.back());
+    }
+    ustring missing("openfiles_missing.tif");
+    Filesystem::remove(missing);
+
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    ic->attribute("missing_file_retry_time", 0.25f);
+    OIIO_CHECK_ASSERT(ic->open_files(filenames, true));
+    int opened = 0;
+    ic->getattribute("stat:open_files_created", opened);
+    OIIO_CHECK_EQUAL(opened, 8);
+    filenames.push_back(missing);
+    OIIO_CHECK_ASSERT(!ic->open_files(filenames, true));
+    ic->geterror();
+
+    // Appearing doesn't help until the retry time has passed
+    A.write(missing);
+    ImageSpec spec;
+    OIIO_CHECK_ASSERT(!ic->get_imagespec(missing, spec));
+    ic->geterror();
+    Sysutil::usleep(300000);
+    OIIO_CHECK_ASSERT(ic->get_imagespec(missing, spec));
+    OIIO_CHECK_EQUAL(spec.width, 64);
+    ImageCache::destroy(ic);
+}
+
+
+// Test that get_image_handles() gives the same handles as get_image_handle().
+void
+test_image_handles()
+{
+    std::cout << "\nTesting IC get_image_handles\n";
+    ImageBuf A(ImageSpec(64, 64, 3, TypeDesc::UINT8));
+    ImageBufAlgo::fill(A, { 0.25f, 0.5f, 0.75f });
+    std::vector<ustring> filenames;
+    for (int i = 0; i < 16; ++i) {
+        filenames.emplace_back(Strutil::sprintf("imagehandles_%d.tif", i));
+        A.write(filenames.back());
+    }
+
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    std::vector<ImageCache::ImageHandle*> handles(filenames.size());
+    OIIO_CHECK_ASSERT(ic->get_image_handles(filenames, handles));
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        OIIO_CHECK_ASSERT(ic->good(handles[i]));
+        OIIO_CHECK_EQUAL(handles[i], ic->get_image_handle(filenames[i]));
+    }
+    filenames.emplace_back("imagehandles_missing.tif");
+    handles.resize(filenames.size());
+    OIIO_CHECK_ASSERT(!ic->get_image_handles(filenames, handles));
+    OIIO_CHECK_ASSERT(!ic->good(handles.back()));
+    ic->geterror();
+    ImageCache::destroy(ic);
+}
+
+
+// Test that when there are more files in use than max_open_files, the ones
+// closed are those least recently used, so a popular file stays open.
+void
+test_open_files_lru()
+{
+    std::cout << "\nTesting IC least recently used file closing\n";
+    ImageSpec spec(64, 64, 1, TypeDesc::UINT8);
+    spec.tile_width  = 16;
+    spec.tile_height = 16;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.5f });
+    std::vector<ustring> filenames;
+    for (int i = 0; i < 8; ++i) {
+        filenames.emplace_back(Strutil::sprintf("lrufiles_%d.tif", i));
+        A.write(filenames.back());
+    }
+    ustring popular("lrufiles_popular.tif");
+    A.write(popular);
+
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    ic->attribute("max_open_files", 4);
+    OIIO_CHECK_ASSERT(ic->good(ic->get_image_handle(popular)));
+    for (int t = 0; t < 16; ++t) {
+        for (ustring filename : filenames) {
+            ImageCache::Tile* tile = ic->get_tile(filename, 0, 0, (t % 4) * 16,
+                                                  (t / 4) * 16, 0);
+            OIIO_CHECK_ASSERT(tile);
+            ic->release_tile(tile);
+            ic->get_image_handle(popular);  // Marks it as used
+        }
+    }
+    int timesopened = 0, current = 0;
+    ic->get_image_info(popular, 0, 0, ustring("stat:timesopened"), TypeInt,
+                       &timesopened);
+    OIIO_CHECK_EQUAL(timesopened, 1);
+    ic->getattribute("stat:open_files_current", current);
+    OIIO_CHECK_LE(current, 4);
+    ImageCache::destroy(ic);
+}
+
+
+// Test destroying a cache while it still has files open, which closes
+// them along with the cache.
+void
+test_destroy_with_open_files()
+{
+    std::cout << "\nTesting IC destroyed with files open\n";
+    ImageSpec spec(64, 64, 1, TypeDesc::UINT8);
+    spec.tile_width  = 16;
+    spec.tile_height = 16;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 0.25f });
+    std::vector<ustring> filenames;
+    for (int i = 0; i < 4; ++i) {
+        filenames.emplace_back(Strutil::sprintf("destroyopen_%d.tif", i));
+        A.write(filenames.back());
+    }
+    for (int c = 0; c < 3; ++c) {
+        ImageCache* ic = ImageCache::create(false /*not shared*/);
+        for (ustring filename : filenames) {
+            float pixel = 0.0f;
+            OIIO_CHECK_ASSERT(ic->get_pixels(filename, 0, 0, 3, 4, 5, 6, 0, 1,
+                                             TypeDesc::FLOAT, &pixel));
+            OIIO_CHECK_EQUAL(pixel, 0.25f);
+        }
+        int current = 0;
+        ic->getattribute("stat:open_files_current", current);
+        OIIO_CHECK_EQUAL(current, int(filenames.size()));
+        ImageCache::destroy(ic);
+    }
+}
+
+
+// Test that with "float_as_half", a float image takes half the cache
+// memory, and reads back with half precision.
+void
+test_float_as_half()
+{
+    std::cout << "\nTesting IC float_as_half\n";
+    ImageSpec spec(256, 256, 4, TypeDesc::FLOAT);
+    spec.tile_width  = 64;
+    spec.tile_height = 64;
+    ImageBuf A(spec);
+    ImageBufAlgo::fill(A, { 1.0f / 3.0f, 0.1f, 1000.5f, 1.0f },
+                       { 0.0f, 0.2f, 0.75f, 1.0f }, { 0.5f, 0.6f, 0.3f, 1.0f },
+                       { 2.0f, 0.4f, 0.05f, 1.0f });
+    ustring filename("floatashalf.tif");
+    A.write(filename);
+
+    long long mem[2] = { 0, 0 };
+    for (int as_half = 0; as_half < 2; ++as_half) {
+        ImageCache* ic = ImageCache::create(false /*not shared*/);
+        ic->attribute("float_as_half", as_half);
+        int cachedformat = 0;
+        OIIO_CHECK_ASSERT(ic->get_image_info(filename, 0, 0,
+                                             ustring("cachedformat"), TypeInt,
+                                             &cachedformat));
+        OIIO_CHECK_EQUAL(cachedformat, as_half ? int(TypeDesc::HALF)
+                                               : int(TypeDesc::FLOAT));
+        std::vector<float> pixels(256 * 256 * 4);
+        OIIO_CHECK_ASSERT(ic->get_pixels(filename, 0, 0, 0, 256, 0, 256, 0, 1,
+                                         TypeDesc::FLOAT, pixels.data()));
+        ic->getattribute("stat:cache_memory_used", TypeDesc::INT64,
+                         &mem[as_half]);
+        float Apixel[4];
+        A.getpixel(10, 200, Apixel);
+        for (int c = 0; c < 4; ++c) {
+            float expected = as_half ? float(half(Apixel[c])) : Apixel[c];
+            OIIO_CHECK_EQUAL(pixels[(200 * 256 + 10) * 4 + c], expected);
+        }
+        ImageCache::destroy(ic);
+    }
+    // Half the memory, give or take the padding at the end of each tile
+    OIIO_CHECK_LT(mem[1], mem[0] * 11 / 20);
+}
+
+
+// Test that when many tiles are churned through a small cache, the memory
+// held for tile pixels stays close to what the cache really uses.
+void
+test_tile_pool_resident()
+{
+    std::cout << "\nTesting IC tile pixel pool resident memory\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("max_memory_MB", 10.0f);
+    imagecache->attribute("skip_constant_tiles", 0);
+    ImageSpec config(4096, 4096, 4, TypeDesc::FLOAT);
+    config.tile_width  = 64;
+    config.tile_height = 64;
+    config.attribute("null:force", 1);
+    ustring filename("tilepool_test");
+    imagecache->add_file(filename, NullInputCreator, &config);
+
+    // 1024 tiles of 64 KB: 64 MB through a 10 MB cache
+    ImageCache::Perthread* thread_info = imagecache->get_perthread_info();
+    ImageCache::ImageHandle* handle = imagecache->get_image_handle(filename);
+    for (int t = 0; t < 1024; ++t) {
+        ImageCache::Tile* tile = imagecache->get_tile(handle, thread_info, 0,
+                                                      0, (t % 64) * 64,
+                                                      (t / 64) * 64, 0);
+        imagecache->release_tile(tile);
+    }
+    long long used = 0, resident = 0;
+    imagecache->getattribute("stat:cache_memory_used", TypeDesc::INT64, &used);
+    imagecache->getattribute("stat:cache_memory_resident", TypeDesc::INT64,
+                             &resident);
+    std::cout << "  used " << Strutil::memformat(used) << ", resident "
+              << Strutil::memformat(resident) << "\n";
+    OIIO_CHECK_GE(resident, used);
+    OIIO_CHECK_LE(resident, 2 * 10LL * 1024 * 1024);
+    ImageCache::destroy(imagecache);
+}
+
+
+// Test that lookups cycling among four tiles, which defeat the two-tile
+// microcache, are caught by the set-associative one.
+void
+test_microcache(int microcache_size)
+{
+    std::cout << "\nTesting IC microcache of size " << microcache_size
+              << "\n";
+    ImageCache* imagecache = ImageCache::create(false /*not shared*/);
+    imagecache->attribute("microcache_size", microcache_size);
+    ImageSpec config(256, 256, 4, TypeDesc::FLOAT);
+    config.tile_width  = 64;
+    config.tile_height = 64;
+    config.attribute("null:force", 1);
+    ustring filename("microcache_test");
+    imagecache->add_file(filename, NullInputCreator, &config);
+
+    ImageCache::Perthread* thread_info = imagecache->get_perthread_info();
+    ImageCache::ImageHandle* handle = imagecache->get_image_handle(filename);
+    for (int i = 0; i < 400; ++i) {
+        int t                  = i % 4;
+        ImageCache::Tile* tile = imagecache->get_tile(handle, thread_info, 0,
+                                                      0, (t % 2) * 64,
+                                                      (t / 2) * 64, 0);
+        OIIO_CHECK_ASSERT(tile);
+        imagecache->release_tile(tile);
+    }
+    long long misses = 0, assoc_hits = 0;
+    imagecache->getattribute("stat:find_tile_microcache_misses",
+                             TypeDesc::INT64, &misses);
+    imagecache->getattribute("stat:find_tile_microcache_assoc_hits",
+                             TypeDesc::INT64, &assoc_hits);
+    std::cout << "  " << misses << " misses, " << assoc_hits
+              << " set-associative hits\n";
+    if (microcache_size) {
+        OIIO_CHECK_GT(assoc_hits, 300);
+        OIIO_CHECK_LT(misses, 100);
+    } else {
+        OIIO_CHECK_EQUAL(assoc_hits, 0);
+        OIIO_CHECK_EQUAL(misses, 400);
+    }
+    ImageCache::destroy(imagecache);
+}
+
+
 int
 main(int /*argc*/, char* /*argv*/[])
 {
@@ -146,5 +1332,33 @@ main(int /*argc*/, char* /*argv*/[])
 
     test_app_buffer();
 
+    test_prefetch(0);
+    test_prefetch(4);
+
+    test_concurrent_readers();
+
+    test_tile_eviction_threads();
+    test_cache_policy_replay();
+    test_compressed_tier();
+    test_disk_cache();
+    test_mmap_tiles();
+    test_constant_tiles();
+    test_constant_tile_values();
+    test_constant_tile_memory();
+    test_dedup_tiles();
+    test_shared_tiles();
+    test_shared_tiles_recycle();
+    test_shared_tiles_dead_holder();
+    test_tile_manifest();
+    test_trace();
+    test_open_files();
+    test_image_handles();
+    test_open_files_lru();
+    test_destroy_with_open_files();
+    test_float_as_half();
+    test_tile_pool_resident();
+    test_microcache(0);
+    test_microcache(8);
+
     return unit_test_failures;
 }
@@ -854,6 +854,24 @@ ImageInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
 
 
 
+bool
+ImageInput::tile_file_offset(int /*subimage*/, int /*miplevel*/, int /*x*/,
+                             int /*y*/, int /*z*/, int64_t& /*offset*/)
+{
+    return false;
+}
+
+
+
+bool
+ImageInput::tile_constant_value(int /*subimage*/, int /*miplevel*/, int /*x*/,
+                                int /*y*/, int /*z*/, void* /*pixel*/)
+{
+    return false;
+}
+
+
+
 bool
 ImageInput::read_image(TypeDesc format, void* data, stride_t xstride,
                        stride_t ystride, stride_t zstride,
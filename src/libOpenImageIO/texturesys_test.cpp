@@ -0,0 +1,473 @@
+// Copyright 2008-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/OpenImageIO/oiio
+
+
+#include <OpenImageIO/Imath.h>
+#include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/texture.h>
+#include <OpenImageIO/unittest.h>
+
+#include <iostream>
+#include <random>
+
+using namespace OIIO;
+
+
+
+// Make a MIP-mapped texture of noise, so that every texel differs.
+static ustring
+make_noise_texture()
+{
+    ustring filename("stochastic_noise.tx");
+    ImageBuf A(ImageSpec(128, 128, 3, TypeDesc::FLOAT));
+    ImageBufAlgo::noise(A, "uniform", 0.0f, 1.0f, false /*mono*/, 42);
+    ImageSpec config;
+    config.tile_width  = 16;
+    config.tile_height = 16;
+    OIIO_CHECK_ASSERT(
+        ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, A, filename,
+                                   config));
+    return filename;
+}
+
+
+
+// An ImageInput for a tiled volume whose every voxel differs, so that
+// volume lookups can be tested without a volume file format that can be
+// written.
+class VolumeNoiseInput final : public ImageInput {
+public:
+    VolumeNoiseInput() {}
+    virtual const char* format_name(void) const override
+    {
+        return "volumenoise";
+    }
+    virtual bool open(const std::string& /*name*/, ImageSpec& newspec) override
+    {
+        m_spec             = ImageSpec(32, 32, 3, TypeDesc::FLOAT);
+        m_spec.depth       = 32;
+        m_spec.full_depth  = 32;
+        m_spec.tile_width  = 8;
+        m_spec.tile_height = 8;
+        m_spec.tile_depth  = 8;
+        newspec            = m_spec;
+        return true;
+    }
+    virtual bool close() override { return true; }
+    virtual bool read_native_scanline(int /*subimage*/, int /*miplevel*/,
+                                      int /*y*/, int /*z*/,
+                                      void* /*data*/) override
+    {
+        return false;
+    }
+    virtual bool read_native_tile(int /*subimage*/, int /*miplevel*/, int x,
+                                  int y, int z, void* data) override
+    {
+        float* d = (float*)data;
+        for (int k = z; k < z + m_spec.tile_depth; ++k)
+            for (int j = y; j < y + m_spec.tile_height; ++j)
+                for (int i = x; i < x + m_spec.tile_width; ++i)
+                    for (int c = 0; c < m_spec.nchannels; ++c)
+                        *d++ = voxel(i, j, k, c);
+        return true;
+    }
+    static float voxel(int x, int y, int z, int c)
+    {
+        unsigned h = unsigned(((x * 73 + y) * 37 + z) * 3 + c) * 2654435761u;
+        return float(h >> 8) / float(1 << 24);
+    }
+};
+
+
+
+static ImageInput*
+VolumeNoiseInputCreator()
+{
+    return new VolumeNoiseInput;
+}
+
+
+
+// Test that the stochastic filtering modes, averaged over many lookups with
+// well distributed rnd values, give the results of the filters they stand
+// in for.
+static void
+test_stochastic(TextureSystem* ts, ustring filename, TextureOpt::MipMode mode,
+                TextureOpt::MipMode stochasticmode, float s, float t,
+                float dsdx, float dtdx, float dsdy, float dtdy)
+{
+    std::cout << "Testing stochastic filtering at " << s << ", " << t
+              << " derivs " << dsdx << " " << dtdx << " " << dsdy << " "
+              << dtdy << "\n";
+    TextureOpt opt;
+    opt.mipmode    = mode;
+    opt.interpmode = TextureOpt::InterpBilinear;
+    float expected[3];
+    OIIO_CHECK_ASSERT(ts->texture(filename, opt, s, t, dsdx, dtdx, dsdy, dtdy,
+                                  3, expected));
+
+    opt.mipmode    = stochasticmode;
+    opt.interpmode = TextureOpt::InterpStochasticBilinear;
+    const int n    = 4096;
+    double sum[3]  = { 0, 0, 0 };
+    for (int i = 0; i < n; ++i) {
+        opt.rnd = (i + 0.5f) / n;
+        float r[3];
+        OIIO_CHECK_ASSERT(ts->texture(filename, opt, s, t, dsdx, dtdx, dsdy,
+                                      dtdy, 3, r));
+        for (int c = 0; c < 3; ++c)
+            sum[c] += r[c];
+    }
+    for (int c = 0; c < 3; ++c)
+        OIIO_CHECK_EQUAL_THRESH(sum[c] / n, expected[c], 0.005);
+}
+
+
+
+// Test that texture_quad gives the same results as four texture() calls.
+static void
+test_texture_quad(TextureSystem* ts, ustring filename, TextureOpt::MipMode mode)
+{
+    std::cout << "Testing texture_quad, mipmode " << int(mode) << "\n";
+    const float s[4] = { 0.3f, 0.31f, 0.3f, 0.31f };
+    const float t[4] = { 0.6f, 0.6f, 0.603f, 0.603f };
+    float dsdx = 0.01f, dtdx = 0.001f, dsdy = -0.002f, dtdy = 0.003f;
+    TextureOpt opt;
+    opt.mipmode = mode;
+    float quad[12], dquadds[12], dquaddt[12];
+    OIIO_CHECK_ASSERT(ts->texture_quad(filename, opt, s, t, dsdx, dtdx, dsdy,
+                                       dtdy, 3, quad, dquadds, dquaddt));
+    for (int i = 0; i < 4; ++i) {
+        float r[3], drds[3], drdt[3];
+        OIIO_CHECK_ASSERT(ts->texture(filename, opt, s[i], t[i], dsdx, dtdx,
+                                      dsdy, dtdy, 3, r, drds, drdt));
+        for (int c = 0; c < 3; ++c) {
+            OIIO_CHECK_EQUAL(quad[3 * i + c], r[c]);
+            OIIO_CHECK_EQUAL(dquadds[3 * i + c], drds[c]);
+            OIIO_CHECK_EQUAL(dquaddt[3 * i + c], drdt[c]);
+        }
+    }
+}
+
+
+
+// Test that batched texture lookups give the same results as single point
+// lookups, lane for lane, so that no SIMD lane can pick up the inputs of
+// another or write its results where they don't belong.
+static void
+test_texture_batch(TextureSystem* ts, ustring filename,
+                   TextureOpt::MipMode mipmode,
+                   TextureOpt::InterpMode interpmode)
+{
+    std::cout << "Testing batched texture, mipmode " << int(mipmode)
+              << " interpmode " << int(interpmode) << "\n";
+    const int nchannels = 3;
+    const int BW        = Tex::BatchWidth;
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> st(-0.25f, 1.25f);
+    std::uniform_real_distribution<float> deriv(-0.02f, 0.02f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int b = 0; b < 16; ++b) {
+        TextureOptBatch bopt;
+        bopt.mipmode    = (Tex::MipMode)mipmode;
+        bopt.interpmode = (Tex::InterpMode)interpmode;
+        bopt.swrap      = Tex::Wrap::Periodic;
+        bopt.twrap      = Tex::Wrap::Clamp;
+        alignas(Tex::BatchAlign) float s[BW], t[BW];
+        alignas(Tex::BatchAlign) float dsdx[BW], dtdx[BW], dsdy[BW], dtdy[BW];
+        for (int i = 0; i < BW; ++i) {
+            s[i]    = st(rng);
+            t[i]    = st(rng);
+            dsdx[i] = deriv(rng);
+            dtdx[i] = deriv(rng);
+            dsdy[i] = deriv(rng);
+            dtdy[i] = deriv(rng);
+            bopt.sblur[i]  = (i & 1) ? 0.0f : 0.01f * unit(rng);
+            bopt.tblur[i]  = (i & 1) ? 0.0f : 0.01f * unit(rng);
+            bopt.rblur[i]  = 0.0f;
+            bopt.swidth[i] = 0.5f + unit(rng);
+            bopt.twidth[i] = 0.5f + unit(rng);
+            bopt.rwidth[i] = 1.0f;
+            bopt.rnd[i]    = unit(rng);
+        }
+        // Every other batch leaves some lanes off
+        Tex::RunMask mask = (b & 1) ? (Tex::RunMaskOn & 0x5b5b5b5b5b5b5b5bULL)
+                                    : Tex::RunMaskOn;
+        alignas(Tex::BatchAlign) float result[nchannels * BW];
+        alignas(Tex::BatchAlign) float dresultds[nchannels * BW];
+        alignas(Tex::BatchAlign) float dresultdt[nchannels * BW];
+        std::fill(result, result + nchannels * BW, -1.0f);
+        std::fill(dresultds, dresultds + nchannels * BW, -1.0f);
+        std::fill(dresultdt, dresultdt + nchannels * BW, -1.0f);
+        OIIO_CHECK_ASSERT(ts->texture(filename, bopt, mask, s, t, dsdx, dtdx,
+                                      dsdy, dtdy, nchannels, result,
+                                      dresultds, dresultdt));
+
+        for (int i = 0; i < BW; ++i) {
+            if (!(mask & (Tex::RunMask(1) << i))) {
+                for (int c = 0; c < nchannels; ++c) {
+                    OIIO_CHECK_EQUAL(result[c * BW + i], -1.0f);
+                    OIIO_CHECK_EQUAL(dresultds[c * BW + i], -1.0f);
+                    OIIO_CHECK_EQUAL(dresultdt[c * BW + i], -1.0f);
+                }
+                continue;
+            }
+            TextureOpt opt;
+            opt.mipmode    = mipmode;
+            opt.interpmode = interpmode;
+            opt.swrap      = TextureOpt::WrapPeriodic;
+            opt.twrap      = TextureOpt::WrapClamp;
+            opt.sblur      = bopt.sblur[i];
+            opt.tblur      = bopt.tblur[i];
+            opt.swidth     = bopt.swidth[i];
+            opt.twidth     = bopt.twidth[i];
+            opt.rnd        = bopt.rnd[i];
+            float r[nchannels], drds[nchannels], drdt[nchannels];
+            OIIO_CHECK_ASSERT(ts->texture(filename, opt, s[i], t[i], dsdx[i],
+                                          dtdx[i], dsdy[i], dtdy[i],
+                                          nchannels, r, drds, drdt));
+            // Derivatives are in units of texels, so allow for their
+            // magnitude.
+            for (int c = 0; c < nchannels; ++c) {
+                OIIO_CHECK_EQUAL_THRESH(result[c * BW + i], r[c], 1.0e-5f);
+                OIIO_CHECK_EQUAL_THRESH(dresultds[c * BW + i], drds[c],
+                                        1.0e-5f
+                                            * std::max(1.0f, std::abs(drds[c])));
+                OIIO_CHECK_EQUAL_THRESH(dresultdt[c * BW + i], drdt[c],
+                                        1.0e-5f
+                                            * std::max(1.0f, std::abs(drdt[c])));
+            }
+        }
+    }
+}
+
+
+
+// Test that batched lookups given only one of the derivative outputs zero
+// it and still compute the right results, like single point lookups do.
+static void
+test_batch_lone_derivs(TextureSystem* ts, ustring filename)
+{
+    std::cout << "Testing batched lookups with one derivative output\n";
+    const int nchannels = 3;
+    const int BW        = Tex::BatchWidth;
+    TextureOptBatch bopt;
+    bopt.mipmode = Tex::MipMode::Trilinear;
+    alignas(Tex::BatchAlign) float s[BW], t[BW], dx[BW], dy[BW];
+    alignas(Tex::BatchAlign) float R[3 * BW], dRdx[3 * BW], dRdy[3 * BW];
+    for (int i = 0; i < BW; ++i) {
+        s[i]           = 0.1f + 0.8f * i / BW;
+        t[i]           = 0.7f - 0.5f * i / BW;
+        dx[i]          = 0.004f;
+        dy[i]          = 0.0f;
+        bopt.sblur[i]  = 0.0f;
+        bopt.tblur[i]  = 0.0f;
+        bopt.rblur[i]  = 0.0f;
+        bopt.swidth[i] = 1.0f;
+        bopt.twidth[i] = 1.0f;
+        bopt.rwidth[i] = 1.0f;
+        bopt.rnd[i]    = 0.5f;
+        // R, dRdx, dRdy are float[3][BW]
+        R[i]             = 1.0f;
+        R[BW + i]        = -0.5f + float(i) / BW;
+        R[2 * BW + i]    = 0.25f;
+        dRdx[i]          = 0.0f;
+        dRdx[BW + i]     = 0.01f;
+        dRdx[2 * BW + i] = 0.0f;
+        dRdy[i]          = 0.0f;
+        dRdy[BW + i]     = 0.0f;
+        dRdy[2 * BW + i] = 0.01f;
+    }
+
+    alignas(Tex::BatchAlign) float expected[nchannels * BW];
+    alignas(Tex::BatchAlign) float result[nchannels * BW];
+    alignas(Tex::BatchAlign) float deriv[nchannels * BW];
+    for (int which = 0; which < 2; ++which) {
+        float* drds = which == 0 ? deriv : nullptr;
+        float* drdt = which == 1 ? deriv : nullptr;
+
+        OIIO_CHECK_ASSERT(ts->texture(filename, bopt, Tex::RunMaskOn, s, t,
+                                      dx, dy, dy, dx, nchannels, expected));
+        std::fill(deriv, deriv + nchannels * BW, -1.0f);
+        OIIO_CHECK_ASSERT(ts->texture(filename, bopt, Tex::RunMaskOn, s, t,
+                                      dx, dy, dy, dx, nchannels, result, drds,
+                                      drdt));
+        for (int i = 0; i < nchannels * BW; ++i) {
+            OIIO_CHECK_EQUAL(result[i], expected[i]);
+            OIIO_CHECK_EQUAL(deriv[i], 0.0f);
+        }
+
+        OIIO_CHECK_ASSERT(ts->environment(filename, bopt, Tex::RunMaskOn, R,
+                                          dRdx, dRdy, nchannels, expected));
+        std::fill(deriv, deriv + nchannels * BW, -1.0f);
+        OIIO_CHECK_ASSERT(ts->environment(filename, bopt, Tex::RunMaskOn, R,
+                                          dRdx, dRdy, nchannels, result, drds,
+                                          drdt));
+        for (int i = 0; i < nchannels * BW; ++i) {
+            OIIO_CHECK_EQUAL(result[i], expected[i]);
+            OIIO_CHECK_EQUAL(deriv[i], 0.0f);
+        }
+    }
+}
+
+
+
+// Test that batched texture3d lookups give the same results as single
+// point lookups, lane for lane.
+static void
+test_texture3d_batch(TextureSystem* ts, ustring filename,
+                     TextureOpt::InterpMode interpmode)
+{
+    std::cout << "Testing batched texture3d, interpmode " << int(interpmode)
+              << "\n";
+    const int nchannels = 3;
+    const int BW        = Tex::BatchWidth;
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<float> pos(-0.25f, 1.25f);
+    std::uniform_real_distribution<float> deriv(-0.02f, 0.02f);
+    for (int b = 0; b < 16; ++b) {
+        TextureOptBatch bopt;
+        bopt.mipmode    = Tex::MipMode::NoMIP;
+        bopt.interpmode = (Tex::InterpMode)interpmode;
+        bopt.swrap      = Tex::Wrap::Periodic;
+        bopt.twrap      = Tex::Wrap::Clamp;
+        bopt.rwrap      = (b & 2) ? Tex::Wrap::Black : Tex::Wrap::Mirror;
+        // P and its derivatives are float[3][BW]
+        alignas(Tex::BatchAlign) float P[3 * BW], dPdx[3 * BW];
+        alignas(Tex::BatchAlign) float dPdy[3 * BW], dPdz[3 * BW];
+        for (int i = 0; i < 3 * BW; ++i) {
+            P[i]    = pos(rng);
+            dPdx[i] = deriv(rng);
+            dPdy[i] = deriv(rng);
+            dPdz[i] = deriv(rng);
+        }
+        for (int i = 0; i < BW; ++i) {
+            bopt.sblur[i]  = 0.0f;
+            bopt.tblur[i]  = 0.0f;
+            bopt.rblur[i]  = 0.0f;
+            bopt.swidth[i] = 1.0f;
+            bopt.twidth[i] = 1.0f;
+            bopt.rwidth[i] = 1.0f;
+            bopt.rnd[i]    = 0.5f;
+        }
+        Tex::RunMask mask = (b & 1) ? (Tex::RunMaskOn & 0x6d6d6d6d6d6d6d6dULL)
+                                    : Tex::RunMaskOn;
+        alignas(Tex::BatchAlign) float result[nchannels * BW];
+        alignas(Tex::BatchAlign) float dresultds[nchannels * BW];
+        alignas(Tex::BatchAlign) float dresultdt[nchannels * BW];
+        alignas(Tex::BatchAlign) float dresultdr[nchannels * BW];
+        std::fill(result, result + nchannels * BW, -1.0f);
+        std::fill(dresultds, dresultds + nchannels * BW, -1.0f);
+        std::fill(dresultdt, dresultdt + nchannels * BW, -1.0f);
+        std::fill(dresultdr, dresultdr + nchannels * BW, -1.0f);
+        OIIO_CHECK_ASSERT(ts->texture3d(filename, bopt, mask, P, dPdx, dPdy,
+                                        dPdz, nchannels, result, dresultds,
+                                        dresultdt, dresultdr));
+
+        for (int i = 0; i < BW; ++i) {
+            if (!(mask & (Tex::RunMask(1) << i))) {
+                for (int c = 0; c < nchannels; ++c) {
+                    OIIO_CHECK_EQUAL(result[c * BW + i], -1.0f);
+                    OIIO_CHECK_EQUAL(dresultds[c * BW + i], -1.0f);
+                    OIIO_CHECK_EQUAL(dresultdt[c * BW + i], -1.0f);
+                    OIIO_CHECK_EQUAL(dresultdr[c * BW + i], -1.0f);
+                }
+                continue;
+            }
+            TextureOpt opt;
+            opt.mipmode    = TextureOpt::MipModeNoMIP;
+            opt.interpmode = interpmode;
+            opt.swrap      = TextureOpt::WrapPeriodic;
+            opt.twrap      = TextureOpt::WrapClamp;
+            opt.rwrap      = (b & 2) ? TextureOpt::WrapBlack
+                                     : TextureOpt::WrapMirror;
+            Imath::V3f p(P[i], P[BW + i], P[2 * BW + i]);
+            Imath::V3f dx(dPdx[i], dPdx[BW + i], dPdx[2 * BW + i]);
+            Imath::V3f dy(dPdy[i], dPdy[BW + i], dPdy[2 * BW + i]);
+            Imath::V3f dz(dPdz[i], dPdz[BW + i], dPdz[2 * BW + i]);
+            float r[nchannels], drds[nchannels], drdt[nchannels];
+            float drdr[nchannels];
+            OIIO_CHECK_ASSERT(ts->texture3d(filename, opt, p, dx, dy, dz,
+                                            nchannels, r, drds, drdt, drdr));
+            // Derivatives are in units of voxels, so allow for their
+            // magnitude.
+            for (int c = 0; c < nchannels; ++c) {
+                OIIO_CHECK_EQUAL_THRESH(result[c * BW + i], r[c], 1.0e-5f);
+                OIIO_CHECK_EQUAL_THRESH(dresultds[c * BW + i], drds[c],
+                                        1.0e-5f
+                                            * std::max(1.0f, std::abs(drds[c])));
+                OIIO_CHECK_EQUAL_THRESH(dresultdt[c * BW + i], drdt[c],
+                                        1.0e-5f
+                                            * std::max(1.0f, std::abs(drdt[c])));
+                OIIO_CHECK_EQUAL_THRESH(dresultdr[c * BW + i], drdr[c],
+                                        1.0e-5f
+                                            * std::max(1.0f, std::abs(drdr[c])));
+            }
+        }
+    }
+}
+
+
+
+int
+main(int /*argc*/, char* /*argv*/[])
+{
+    ustring filename  = make_noise_texture();
+    TextureSystem* ts = TextureSystem::create(false /*not shared*/);
+
+    // Magnified, minified between MIP levels, and anisotropic lookups
+    test_stochastic(ts, filename, TextureOpt::MipModeTrilinear,
+                    TextureOpt::MipModeStochasticTrilinear, 0.3f, 0.6f, 0.001f,
+                    0.0f, 0.0f, 0.001f);
+    test_stochastic(ts, filename, TextureOpt::MipModeTrilinear,
+                    TextureOpt::MipModeStochasticTrilinear, 0.41f, 0.27f,
+                    0.012f, 0.0f, 0.0f, 0.012f);
+    test_stochastic(ts, filename, TextureOpt::MipModeAniso,
+                    TextureOpt::MipModeStochasticAniso, 0.41f, 0.27f, 0.05f,
+                    0.02f, 0.0f, 0.006f);
+    test_stochastic(ts, filename, TextureOpt::MipModeAniso,
+                    TextureOpt::MipModeStochasticAniso, 0.77f, 0.13f, 0.003f,
+                    -0.004f, 0.0005f, 0.0004f);
+
+    test_texture_quad(ts, filename, TextureOpt::MipModeAniso);
+    test_texture_quad(ts, filename, TextureOpt::MipModeTrilinear);
+    test_texture_quad(ts, filename, TextureOpt::MipModeNoMIP);
+
+    // The batched engine's modes, including the default anisotropic
+    // "smart" bicubic one (whose magnified lanes go point by point), and
+    // one that goes entirely point by point
+    for (auto mipmode :
+         { TextureOpt::MipModeNoMIP, TextureOpt::MipModeOneLevel,
+           TextureOpt::MipModeTrilinear,
+           TextureOpt::MipModeStochasticTrilinear }) {
+        test_texture_batch(ts, filename, mipmode, TextureOpt::InterpClosest);
+        test_texture_batch(ts, filename, mipmode, TextureOpt::InterpBilinear);
+    }
+    for (auto mipmode :
+         { TextureOpt::MipModeDefault, TextureOpt::MipModeAniso,
+           TextureOpt::MipModeStochasticAniso }) {
+        test_texture_batch(ts, filename, mipmode, TextureOpt::InterpBilinear);
+        test_texture_batch(ts, filename, mipmode,
+                           TextureOpt::InterpSmartBicubic);
+    }
+    test_texture_batch(ts, filename, TextureOpt::MipModeTrilinear,
+                       TextureOpt::InterpBicubic);
+    test_batch_lone_derivs(ts, filename);
+
+    TextureSystem::destroy(ts);
+
+    // Volume lookups, from a volume that exists only in the cache
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    ustring volname("volumenoise");
+    OIIO_CHECK_ASSERT(ic->add_file(volname, VolumeNoiseInputCreator));
+    ts = TextureSystem::create(false /*not shared*/, ic);
+    test_texture3d_batch(ts, volname, TextureOpt::InterpClosest);
+    test_texture3d_batch(ts, volname, TextureOpt::InterpBilinear);
+    TextureSystem::destroy(ts);
+    ImageCache::destroy(ic);
+
+    return unit_test_failures;
+}
@@ -286,6 +286,58 @@ vector_to_latlong(const Imath::V3f& R, bool y_is_up, float& s, float& t)
 
 
 
+/// Batched flavor of vector_to_latlong: convert the directions of all
+/// lanes to latlong st coordinates. The choice of axes and the scaling are
+/// done for all lanes at once, but there is no SIMD atan2, so the angles
+/// themselves are computed lane by lane with the same math as the single
+/// point version, keeping the results identical.
+inline void
+vector_to_latlong(const Tex::FloatWide& Rx, const Tex::FloatWide& Ry,
+                  const Tex::FloatWide& Rz, bool y_is_up, Tex::FloatWide& s,
+                  Tex::FloatWide& t)
+{
+    using Tex::FloatWide;
+    FloatWide sy, sx, ty, tx0, tx1;  // atan2 arguments for s and t
+    if (y_is_up) {
+        sy  = -Rx;
+        sx  = Rz;
+        ty  = Ry;
+        tx0 = Rz;
+        tx1 = -Rx;
+    } else {
+        sy  = Ry;
+        sx  = Rx;
+        ty  = Rz;
+        tx0 = Rx;
+        tx1 = Ry;
+    }
+    FloatWide sangle, tangle;
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        sangle[i] = atan2f(sy[i], sx[i]);
+        tangle[i] = atan2f(ty[i], hypotf(tx0[i], tx1[i]));
+    }
+    s = sangle / (2.0f * (float)M_PI) + 0.5f;
+    t = 0.5f - tangle / (float)M_PI;
+    // learned from experience, beware NaNs
+    s = blend0not(s, s != s);
+    t = blend0not(t, t != t);
+}
+
+
+
+/// Normalize the vectors of all lanes of a batch, held as x, y, z
+/// components. Zero-length vectors are left alone.
+inline void
+normalize_wide(Tex::FloatWide* v)
+{
+    Tex::FloatWide len = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    auto nonzero       = (len != 0.0f);
+    for (int i = 0; i < 3; ++i)
+        v[i] = blend(v[i], v[i] / len, nonzero);
+}
+
+
+
 bool
 TextureSystemImpl::environment(ustring filename, TextureOpt& options,
                                const Imath::V3f& R, const Imath::V3f& dRdx,
@@ -583,20 +635,44 @@ TextureSystemImpl::environment(TextureHandle* texture_handle_,
 
 
 bool
-TextureSystemImpl::environment(TextureHandle* texture_handle,
-                               Perthread* thread_info, TextureOptBatch& options,
-                               Tex::RunMask mask, const float* R,
-                               const float* dRdx, const float* dRdy,
-                               int nchannels, float* result, float* dresultds,
+TextureSystemImpl::environment(TextureHandle* texture_handle_,
+                               Perthread* thread_info_,
+                               TextureOptBatch& options, Tex::RunMask mask,
+                               const float* R_, const float* dRdx_,
+                               const float* dRdy_, int nchannels,
+                               float* result, float* dresultds,
                                float* dresultdt)
 {
-    // (FIXME) CHEAT! Texture points individually
+    using Tex::FloatWide;
+    using Tex::IntWide;
+    typedef FloatWide::vbool_t BoolWide;
+
+    // Handle >4 channel lookups by recursion.
+    if (nchannels > 4) {
+        int save_firstchannel = options.firstchannel;
+        bool ok               = true;
+        while (nchannels) {
+            int n = std::min(nchannels, 4);
+            ok &= environment(texture_handle_, thread_info_, options, mask, R_,
+                              dRdx_, dRdy_, n, result, dresultds, dresultdt);
+            result += n * Tex::BatchWidth;
+            if (dresultds)
+                dresultds += n * Tex::BatchWidth;
+            if (dresultdt)
+                dresultdt += n * Tex::BatchWidth;
+            options.firstchannel += n;
+            nchannels -= n;
+        }
+        options.firstchannel = save_firstchannel;  // restore what we changed
+        return ok;
+    }
+
+    zero_lone_derivs(mask, nchannels, dresultds, dresultdt);
+
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
     opt.subimagename        = options.subimagename;
-    opt.swrap               = (TextureOpt::Wrap)options.swrap;
-    opt.twrap               = (TextureOpt::Wrap)options.twrap;
     opt.mipmode             = (TextureOpt::MipMode)options.mipmode;
     opt.interpmode          = (TextureOpt::InterpMode)options.interpmode;
     opt.anisotropic         = options.anisotropic;
@@ -604,39 +680,272 @@ TextureSystemImpl::environment(TextureHandle* texture_handle,
     opt.fill                = options.fill;
     opt.missingcolor        = options.missingcolor;
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        float r[4], drds[4], drdt[4];  // temp result
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rnd    = options.rnd[i];
-            Imath::V3f R_(R[i], R[i + Tex::BatchWidth],
-                          R[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dRdx_(dRdx[i], dRdx[i + Tex::BatchWidth],
-                             dRdx[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dRdy_(dRdy[i], dRdy[i + Tex::BatchWidth],
-                             dRdy[i + 2 * Tex::BatchWidth]);
-            if (dresultds) {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r, drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                }
-            } else {
-                ok &= environment(texture_handle, thread_info, opt, R_, dRdx_,
-                                  dRdy_, nchannels, r);
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    TextureFile* texturefile = verify_texturefile((TextureFile*)texture_handle_,
+                                                  thread_info);
+    int nlanes = 0;
+    for (Tex::RunMask m = mask; m; m &= m - 1)
+        ++nlanes;
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.environment_batches;
+    stats.environment_queries += nlanes;
+
+    if (!texturefile || texturefile->broken())
+        return missing_texture(options, mask, nchannels, result, dresultds,
+                               dresultdt);
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int s = m_imagecache->subimage_from_name(texturefile, opt.subimagename);
+        if (s < 0) {
+            error("Unknown subimage \"{}\" in texture \"{}\"",
+                  opt.subimagename, texturefile->filename());
+            return missing_texture(options, mask, nchannels, result,
+                                   dresultds, dresultdt);
+        }
+        opt.subimage = s;
+        opt.subimagename.clear();
+    }
+    if (opt.subimage < 0 || opt.subimage >= texturefile->subimages()) {
+        error("Unknown subimage \"{}\" in texture \"{}\"", opt.subimagename,
+              texturefile->filename());
+        return missing_texture(options, mask, nchannels, result, dresultds,
+                               dresultdt);
+    }
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    // Environment maps dictate particular wrap modes
+    opt.swrap = texturefile->m_sample_border
+                    ? TextureOpt::WrapPeriodicSharedBorder
+                    : TextureOpt::WrapPeriodic;
+    opt.twrap = TextureOpt::WrapClamp;
+
+    opt.envlayout      = LayoutLatLong;
+    int actualchannels = OIIO::clamp(spec.nchannels - opt.firstchannel, 0,
+                                     nchannels);
+    BoolWide active    = BoolWide::from_bitmask(int(mask));
+
+    // Calculate unit-length vectors in the direction of R, R+dRdx, R+dRdy
+    // for all lanes at once. These define the ellipses we're filtering over.
+    FloatWide R[3], Rx[3], Ry[3];
+    for (int i = 0; i < 3; ++i) {
+        R[i]  = FloatWide(R_ + i * Tex::BatchWidth);
+        Rx[i] = R[i] + FloatWide(dRdx_ + i * Tex::BatchWidth);
+        Ry[i] = R[i] + FloatWide(dRdy_ + i * Tex::BatchWidth);
+    }
+    normalize_wide(R);   // center
+    normalize_wide(Rx);  // x axis of the ellipse
+    normalize_wide(Ry);  // y axis of the ellipse
+    FloatWide cosx = R[0] * Rx[0] + R[1] * Rx[1] + R[2] * Rx[2];
+    FloatWide cosy = R[0] * Ry[0] + R[1] * Ry[1] + R[2] * Ry[2];
+    // Angles formed by the ellipse axes. There is no SIMD acos, so that
+    // alone is computed lane by lane.
+    FloatWide xfilt_noblur, yfilt_noblur;
+    for (int i = 0; i < Tex::BatchWidth; ++i) {
+        xfilt_noblur[i] = safe_acos(cosx[i]);
+        yfilt_noblur[i] = safe_acos(cosy[i]);
+    }
+    xfilt_noblur = max(xfilt_noblur, FloatWide(1e-8f));
+    yfilt_noblur = max(yfilt_noblur, FloatWide(1e-8f));
+    IntWide naturalres(float(M_PI) / min(xfilt_noblur, yfilt_noblur));
+
+    // Account for width and blur
+    FloatWide xfilt = xfilt_noblur * FloatWide(options.swidth)
+                      + FloatWide(options.sblur);
+    FloatWide yfilt = yfilt_noblur * FloatWide(options.twidth)
+                      + FloatWide(options.tblur);
+
+    // Figure out major versus minor, and aspect ratio
+    BoolWide x_is_majoraxis = (xfilt >= yfilt);
+    FloatWide Rmajor[3];  // major axis
+    for (int i = 0; i < 3; ++i)
+        Rmajor[i] = blend(Ry[i], Rx[i], x_is_majoraxis);
+    FloatWide majorlength = blend(yfilt, xfilt, x_is_majoraxis);
+    FloatWide minorlength = blend(xfilt, yfilt, x_is_majoraxis);
+
+    TextureOpt::MipMode mipmode = opt.mipmode;
+    bool aniso                  = (mipmode == TextureOpt::MipModeDefault
+                  || mipmode == TextureOpt::MipModeAniso
+                  || mipmode == TextureOpt::MipModeStochasticAniso);
+
+    FloatWide filtwidth;
+    IntWide nsamples(1);
+    FloatWide invsamples = FloatWide::One();
+    int maxsamples       = 1;
+    if (aniso) {
+        // Clamping the anisotropy is full of special cases, so it's done
+        // lane by lane.
+        for (int i = 0; i < Tex::BatchWidth; ++i) {
+            if (!(mask & (Tex::RunMask(1) << i)))
+                continue;
+            float major = majorlength[i], minor = minorlength[i];
+            float trueaspect;
+            float aspect   = anisotropic_aspect(major, minor, opt, trueaspect);
+            minorlength[i] = minor;
+            if (trueaspect > stats.max_aniso)
+                stats.max_aniso = trueaspect;
+            nsamples[i]   = std::max(1, (int)ceilf(aspect - 0.25f));
+            invsamples[i] = 1.0f / nsamples[i];
+            maxsamples    = std::max(maxsamples, nsamples[i]);
+        }
+        filtwidth = minorlength;
+    } else {
+        filtwidth = opt.conservative_filter ? majorlength : minorlength;
+    }
+
+    // Determine the MIP-map level(s) of every lane: we will blend
+    //    data(miplevel0) * (1-levelblend) + data(miplevel1) * levelblend
+    // The filter width doesn't depend on the position along the major
+    // axis, so this is shared by all the anisotropic samples.
+    ImageCacheFile::SubimageInfo& subinfo(
+        texturefile->subimageinfo(opt.subimage));
+    int nmiplevels    = (int)subinfo.levels.size();
+    int min_mip_level = subinfo.min_mip_level;
+    IntWide miplevel0(min_mip_level), miplevel1(min_mip_level);
+    FloatWide levelblend = FloatWide::Zero();
+    if (mipmode != TextureOpt::MipModeNoMIP) {
+        BoolWide found = BoolWide::False();
+        for (int m = min_mip_level; m < nmiplevels; ++m) {
+            // Filters are in radians, and the vertical resolution of a
+            // latlong map is PI radians, so this is the raster size of
+            // the filter width at this level.
+            FloatWide filtwidth_ras = float(subinfo.spec(m).full_height)
+                                      * filtwidth * float(M_1_PI);
+            BoolWide hit = (filtwidth_ras <= 1.0f) & !found;
+            if (none(hit))
+                continue;
+            miplevel0  = blend(miplevel0, IntWide(m - 1), hit);
+            miplevel1  = blend(miplevel1, IntWide(m), hit);
+            levelblend = blend(levelblend,
+                               min(max(2.0f * filtwidth_ras - 1.0f,
+                                       FloatWide::Zero()),
+                                   FloatWide::One()),
+                               hit);
+            found |= hit;
+            if (all(found))
+                break;
+        }
+        // Lanes that would like to blur even more make do with the
+        // coarsest MIP level; lanes that wish they had more resolution
+        // than the finest level get the finest.
+        miplevel0        = blend(IntWide(nmiplevels - 1), miplevel0, found);
+        miplevel1        = blend(IntWide(nmiplevels - 1), miplevel1, found);
+        levelblend       = blend0(levelblend, found);
+        BoolWide toofine = miplevel0 < min_mip_level;
+        miplevel0        = blend(miplevel0, IntWide(min_mip_level), toofine);
+        miplevel1        = blend(miplevel1, IntWide(min_mip_level), toofine);
+        levelblend       = blend0not(levelblend, toofine);
+        if (mipmode == TextureOpt::MipModeOneLevel) {
+            // Force use of just one mipmap level
+            miplevel1  = miplevel0;
+            levelblend = FloatWide::Zero();
+        }
+    }
+    FloatWide levelweight0 = 1.0f - levelblend;
+    FloatWide levelweight1 = levelblend;
+
+    FloatWide r[4], drds[4], drdt[4];
+    for (int c = 0; c < nchannels; ++c) {
+        r[c].clear();
+        drds[c].clear();
+        drdt[c].clear();
+    }
+    bool ok                = true;
+    bool first             = true;
+    long long closest_pts  = 0;
+    long long bilinear_pts = 0;
+    long long bicubic_pts  = 0;
+    FloatWide pos          = -0.5f + 0.5f * invsamples;
+    for (int sample = 0; sample < maxsamples; ++sample, pos += invsamples) {
+        BoolWide sampling = active & (nsamples > sample);
+        FloatWide s, t;
+        vector_to_latlong(R[0] + pos * Rmajor[0], R[1] + pos * Rmajor[1],
+                          R[2] + pos * Rmajor[2], texturefile->m_y_up, s, t);
+
+        // Sample each MIP level that any lane needs, all lanes using that
+        // level at once.
+        for (int m = min_mip_level; m < nmiplevels; ++m) {
+            BoolWide use0 = sampling & (miplevel0 == m)
+                            & (levelweight0 != 0.0f);
+            BoolWide use1 = sampling & (miplevel1 == m)
+                            & (levelweight1 != 0.0f);
+            BoolWide uses = use0 | use1;
+            if (none(uses))
+                continue;
+            FloatWide weight = (blend0(levelweight0, use0)
+                                + blend0(levelweight1, use1))
+                               * invsamples;
+            BoolWide cubic = BoolWide::False();
+            if (opt.interpmode == TextureOpt::InterpBicubic)
+                cubic = uses;
+            else if (opt.interpmode == TextureOpt::InterpSmartBicubic)
+                cubic = uses
+                        & ((m == 0) ? BoolWide::True()
+                                    : (IntWide(subinfo.spec(m).full_height)
+                                       < naturalres / 2));
+            int cubicbits  = cubic.bitmask();
+            int linearbits = (uses & !cubic).bitmask();
+            if (linearbits) {
+                ok &= sample_batch(s, t, m, Tex::RunMask(linearbits), weight,
+                                   *texturefile, thread_info, opt, nchannels,
+                                   actualchannels, first, r,
+                                   dresultds ? drds : nullptr,
+                                   dresultds ? drdt : nullptr);
+                first = false;
+                int npoints = 0;
+                for (int b = linearbits; b; b &= b - 1)
+                    ++npoints;
+                if (opt.interpmode == TextureOpt::InterpClosest)
+                    closest_pts += npoints;
+                else
+                    bilinear_pts += npoints;
+            }
+            // Bicubic lanes have no batched sampler yet; filter them one
+            // at a time.
+            for (int i = 0; cubicbits; ++i, cubicbits >>= 1) {
+                if (!(cubicbits & 1))
+                    continue;
+                OIIO_SIMD4_ALIGN float sval[4] = { s[i], 0.0f, 0.0f, 0.0f };
+                OIIO_SIMD4_ALIGN float tval[4] = { t[i], 0.0f, 0.0f, 0.0f };
+                OIIO_SIMD4_ALIGN float wval[4] = { weight[i], 0.0f, 0.0f,
+                                                   0.0f };
+                vfloat4 rr, rrds, rrdt;
+                ok &= sample_bicubic(1, sval, tval, m, *texturefile,
+                                     thread_info, opt, nchannels,
+                                     actualchannels, wval, &rr,
+                                     dresultds ? &rrds : NULL,
+                                     dresultds ? &rrdt : NULL);
                 for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
+                    r[c][i] += rr[c];
+                    if (dresultds) {
+                        drds[c][i] += rrds[c];
+                        drdt[c][i] += rrdt[c];
+                    }
                 }
+                ++bicubic_pts;
             }
         }
     }
+
+    // Update stats
+    for (int i = 0; i < Tex::BatchWidth; ++i)
+        if (mask & (Tex::RunMask(1) << i))
+            stats.aniso_probes += nsamples[i];
+    stats.aniso_queries += nlanes;
+    stats.closest_interps += closest_pts;
+    stats.bilinear_interps += bilinear_pts;
+    stats.cubic_interps += bicubic_pts;
+
+    if (actualchannels < nchannels && opt.firstchannel == 0 && m_gray_to_rgb)
+        fill_gray_channels(spec, nchannels, r, drds, drdt);
+    for (int c = 0; c < nchannels; ++c) {
+        r[c].store_mask(int(mask), result + c * Tex::BatchWidth);
+        if (dresultds) {
+            drds[c].store_mask(int(mask), dresultds + c * Tex::BatchWidth);
+            drdt[c].store_mask(int(mask), dresultdt + c * Tex::BatchWidth);
+        }
+    }
     return ok;
 }
 
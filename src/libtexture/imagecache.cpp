@@ -10,6 +10,17 @@
 #include <string>
 #include <vector>
 
+#include <zlib.h>
+
+#ifndef _WIN32
+#    include <cerrno>
+#    include <fcntl.h>
+#    include <pthread.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/filesystem.h>
 #include <OpenImageIO/fmath.h>
@@ -17,6 +28,7 @@
 #include <OpenImageIO/imagecache.h>
 #include <OpenImageIO/imageio.h>
 #include <OpenImageIO/optparser.h>
+#include <OpenImageIO/parallel.h>
 #include <OpenImageIO/simd.h>
 #include <OpenImageIO/strutil.h>
 #include <OpenImageIO/sysutil.h>
@@ -121,6 +133,7 @@ ImageCacheStatistics::init()
     // ImageCache stats:
     find_tile_calls             = 0;
     find_tile_microcache_misses = 0;
+    find_tile_microcache_assoc_hits = 0;
     find_tile_cache_misses      = 0;
     //    tiles_created = 0;
     //    tiles_current = 0;
@@ -138,6 +151,19 @@ ImageCacheStatistics::init()
     tile_locking_time = 0;
     find_file_time    = 0;
     find_tile_time    = 0;
+    prefetch_tiles          = 0;
+    prefetch_preempted      = 0;
+    compressed_tiles_stored = 0;
+    compressed_tiles_hits   = 0;
+    compressed_tiles_misses = 0;
+    disk_cache_hits         = 0;
+    disk_cache_misses       = 0;
+    mapped_tiles            = 0;
+    constant_tiles          = 0;
+    dedup_tiles             = 0;
+    shared_tiles_hits       = 0;
+    shared_tiles_misses     = 0;
+    dedup_bytes_saved       = 0;
 
     // TextureSystem stats:
     texture_queries     = 0;
@@ -167,6 +193,7 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     // ImageCache stats:
     find_tile_calls += s.find_tile_calls;
     find_tile_microcache_misses += s.find_tile_microcache_misses;
+    find_tile_microcache_assoc_hits += s.find_tile_microcache_assoc_hits;
     find_tile_cache_misses += s.find_tile_cache_misses;
     //    tiles_created += s.tiles_created;
     //    tiles_current += s.tiles_current;
@@ -184,6 +211,19 @@ ImageCacheStatistics::merge(const ImageCacheStatistics& s)
     tile_locking_time += s.tile_locking_time;
     find_file_time += s.find_file_time;
     find_tile_time += s.find_tile_time;
+    prefetch_tiles += s.prefetch_tiles;
+    prefetch_preempted += s.prefetch_preempted;
+    compressed_tiles_stored += s.compressed_tiles_stored;
+    compressed_tiles_hits += s.compressed_tiles_hits;
+    compressed_tiles_misses += s.compressed_tiles_misses;
+    disk_cache_hits += s.disk_cache_hits;
+    disk_cache_misses += s.disk_cache_misses;
+    mapped_tiles += s.mapped_tiles;
+    constant_tiles += s.constant_tiles;
+    dedup_tiles += s.dedup_tiles;
+    shared_tiles_hits += s.shared_tiles_hits;
+    shared_tiles_misses += s.shared_tiles_misses;
+    dedup_bytes_saved += s.dedup_bytes_saved;
 
     // TextureSystem stats:
     texture_queries += s.texture_queries;
@@ -263,8 +303,7 @@ ImageCacheFile::ImageCacheFile(ImageCacheImpl& imagecache,
                                ImageCachePerThreadInfo* /*thread_info*/,
                                ustring filename, ImageInput::Creator creator,
                                const ImageSpec* config)
-    : m_filename(filename)
-    , m_used(true)
+    : m_filename_original(filename)
     , m_broken(false)
     , m_texformat(TexFormatTexture)
     , m_swrap(TextureOpt::WrapBlack)
@@ -292,8 +331,9 @@ ImageCacheFile::ImageCacheFile(ImageCacheImpl& imagecache,
     , m_inputcreator(creator)
     , m_configspec(config ? new ImageSpec(*config) : NULL)
 {
-    m_filename_original = m_filename;
-    m_filename = imagecache.resolve_filename(m_filename_original.string());
+    // Resolve the name before anyone else can see the file.
+    ustring resolved(imagecache.resolve_filename(m_filename_original.string()));
+    m_filename = resolved.c_str();
     // N.B. the file is not opened, the ImageInput is NULL.  This is
     // reflected by the fact that m_validspec is false.
 
@@ -359,6 +399,8 @@ ImageCacheFile::set_imageinput(std::shared_ptr<ImageInput> newval)
 #endif
     if (oldval)
         imagecache().decr_open_files();
+    if (!newval != !oldval)
+        imagecache().update_open_file(this);
 }
 
 
@@ -390,6 +432,9 @@ ImageCacheFile::SubimageInfo::init(ImageCacheFile& icfile,
             || spec.format == TypeDesc::HALF
             /* future expansion:  || spec.format == AnotherFormat ... */)
             datatype = spec.format;
+        else if (spec.format == TypeDesc::FLOAT
+                 && icfile.imagecache().float_as_half())
+            datatype = TypeDesc::HALF;
     }
     channelsize = datatype.size();
     pixelsize   = channelsize * spec.nchannels;
@@ -490,17 +535,19 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
         // name construction, just open with the extension in order to skip
         // an unnecessary file open.
         std::string fmt;
+        ustring filename = this->filename();
         if (m_imagecache.trust_file_extensions()
-            && m_filename.find('?') != m_filename.npos)
+            && filename.find('?') != filename.npos)
             fmt = OIIO::Filesystem::extension(fmt, false);
         else
-            fmt = m_filename.string();
+            fmt = filename.string();
         inp = ImageInput::create(fmt, false, &configspec,
                                  m_imagecache.plugin_searchpath());
     }
     if (!inp) {
         mark_broken(OIIO::geterror());
         invalidate_spec();
+        mark_open_failed();
         return {};
     }
 
@@ -508,7 +555,7 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     mark_not_broken();
     bool ok = true;
     for (int tries = 0; tries <= imagecache().failure_retries(); ++tries) {
-        ok = inp->open(m_filename.c_str(), nativespec, configspec);
+        ok = inp->open(filename().c_str(), nativespec, configspec);
         if (ok) {
             tempspec = nativespec;
             if (tries)  // succeeded, but only after a failure!
@@ -523,10 +570,12 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     }
     if (!ok) {
         mark_broken(inp->geterror());
+        mark_open_failed();
         inp.reset();
         return {};
     }
-    m_fileformat = ustring(inp->format_name());
+    m_fileformat             = ustring(inp->format_name());
+    m_reports_constant_tiles = inp->supports("constant_tiles");
     ++m_timesopened;
     use();
 
@@ -677,7 +726,7 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
     } while (inp->seek_subimage(nsubimages, 0, nativespec));
     OIIO_DASSERT((size_t)nsubimages == m_subimages.size());
 
-    m_total_imagesize_ondisk = imagesize_t(Filesystem::file_size(m_filename));
+    m_total_imagesize_ondisk = imagesize_t(Filesystem::file_size(filename()));
 
     thread_info->m_stats.files_totalsize -= old_total_imagesize;
     thread_info->m_stats.files_totalsize += m_total_imagesize;
@@ -691,6 +740,77 @@ ImageCacheFile::open(ImageCachePerThreadInfo* thread_info)
 
 
 
+std::shared_ptr<ImageInput>
+ImageCacheFile::lock_reader(ImageCachePerThreadInfo* thread_info)
+{
+    std::shared_ptr<ImageInput> inp = open(thread_info);
+    if (!inp)
+        return inp;
+    if (inp->try_lock())
+        return inp;  // Nobody else is reading -- the common case
+
+    // The primary ImageInput is busy with another thread's read. Try an
+    // extra reader instead. Custom ImageInputs and IOProxy-backed files
+    // can't be opened a second time, so they always share the one.
+    int maxreaders = imagecache().readers_per_file();
+    if (maxreaders > 1 && m_allow_release && !m_inputcreator) {
+        Timer input_mutex_timer;
+        lock_guard lock(m_extra_readers_mutex);
+        m_mutex_wait_time += input_mutex_timer();
+        for (auto& r : m_extra_readers)
+            if (r->try_lock())
+                return r;
+        // All busy. Open another, as long as it doesn't push us over the
+        // limit of open files (we'd rather not close some other file
+        // just to read this one faster).
+        if (int(m_extra_readers.size()) + 1 < maxreaders
+            && imagecache().open_files_headroom()) {
+            std::shared_ptr<ImageInput> r = open_extra_reader(thread_info);
+            if (r) {
+                r->lock();
+                m_extra_readers.push_back(r);
+                return r;
+            }
+        }
+    }
+
+    // Wait our turn for the primary ImageInput.
+    Timer input_mutex_timer;
+    inp->lock();
+    m_mutex_wait_time += input_mutex_timer();
+    return inp;
+}
+
+
+
+std::shared_ptr<ImageInput>
+ImageCacheFile::open_extra_reader(ImageCachePerThreadInfo* /*thread_info*/)
+{
+    ImageSpec configspec;
+    if (m_configspec)
+        configspec = *m_configspec;
+    if (imagecache().unassociatedalpha())
+        configspec.attribute("oiio:UnassociatedAlpha", 1);
+
+    // The primary ImageInput already told us the format, no need to
+    // probe for it again.
+    std::shared_ptr<ImageInput> inp
+        = ImageInput::create(m_fileformat.string(), false, &configspec,
+                             m_imagecache.plugin_searchpath());
+    if (!inp) {
+        (void)OIIO::geterror();  // Eat the error, we'll do without
+        return {};
+    }
+    ImageSpec nativespec;
+    if (!inp->open(filename().string(), nativespec, configspec))
+        return {};
+    ++m_timesopened;
+    imagecache().incr_open_files();
+    return inp;
+}
+
+
+
 void
 ImageCacheFile::init_from_spec()
 {
@@ -767,7 +887,7 @@ ImageCacheFile::init_from_spec()
     if (fing.length())
         m_fingerprint = ustring(fing);
 
-    m_mod_time = Filesystem::last_write_time(m_filename);
+    m_mod_time = Filesystem::last_write_time(filename());
 
     // Set all mipmap level read counts to zero
     int maxmip = 1;
@@ -782,6 +902,147 @@ ImageCacheFile::init_from_spec()
 
 
 
+std::string
+ImageCacheFile::disk_cache_key(const TileID& id) const
+{
+    // Custom ImageInputs and IOProxy input aren't files we can identify
+    // across runs, and config hints may change how the pixels decode.
+    if (m_inputcreator || !m_allow_release || m_configspec)
+        return std::string();
+    // Identify the file by its content hash if it has one (so that copies
+    // of the same texture in different places share cached tiles),
+    // otherwise by name, modification time and size.
+    std::string file = m_fingerprint.size()
+                           ? m_fingerprint.string()
+                           : Strutil::fmt::format("{}:{}:{}", filename(),
+                                                  (long long)m_mod_time,
+                                                  m_total_imagesize_ondisk);
+    const ImageSpec& spec(this->spec(id.subimage(), id.miplevel()));
+    return Strutil::fmt::format(
+        "{}|{}|{}|{},{},{}|{}x{}x{}|{}-{}|{}|{}", file, id.subimage(),
+        id.miplevel(), id.x(), id.y(), id.z(), spec.tile_width,
+        spec.tile_height, spec.tile_depth, id.chbegin(), id.chend(),
+        datatype(id.subimage()).c_str(), int(imagecache().unassociatedalpha()));
+}
+
+
+
+bool
+ImageCacheFile::mark_tile_read(const TileID& id)
+{
+    LevelInfo& lev(levelinfo(id.subimage(), id.miplevel()));
+    int whichtile = ((id.x() - lev.spec.x) / lev.spec.tile_width)
+                    + ((id.y() - lev.spec.y) / lev.spec.tile_height)
+                          * lev.nxtiles
+                    + ((id.z() - lev.spec.z) / lev.spec.tile_depth)
+                          * (lev.nxtiles * lev.nytiles);
+    int index       = whichtile / 64;
+    int64_t bitmask = int64_t(1ULL << (whichtile & 63));
+    int64_t oldval  = lev.tiles_read[index].fetch_or(bitmask);
+    return (oldval & bitmask) != 0;
+}
+
+
+
+const char*
+ImageCacheFile::mapped_tile(const TileID& id,
+                            ImageCachePerThreadInfo* thread_info,
+                            std::shared_ptr<const char>& mapping)
+{
+#ifndef _WIN32
+    // The tile must be stored in the file just as we'd cache it: a real
+    // tiled level of a file we can open by name, all channels, in the
+    // file's own data type.
+    int subimage = id.subimage(), miplevel = id.miplevel();
+    const SubimageInfo& si(subimageinfo(subimage));
+    const ImageSpec& spec(this->spec(subimage, miplevel));
+    if (m_mapping_failed || m_inputcreator || !m_allow_release
+        || si.untiled || (si.unmipped && miplevel != 0) || id.chbegin() != 0
+        || id.chend() != spec.nchannels || spec.channelformats.size()
+        || datatype(subimage) != spec.format)
+        return nullptr;
+
+    int64_t offset = 0;
+    {
+        std::shared_ptr<ImageInput> inp = lock_reader(thread_info);
+        if (!inp)
+            return nullptr;
+        std::lock_guard<const ImageInput> unlocker(*inp, std::adopt_lock);
+        if (!inp->tile_file_offset(subimage, miplevel, id.x(), id.y(), id.z(),
+                                   offset))
+            return nullptr;
+    }
+
+    spin_lock lock(m_mapping_mutex);
+    if (!m_mapping && !m_mapping_failed) {
+        // Map the whole file, once. We can close the descriptor right
+        // away, the mapping stays valid without it.
+        m_mapping_failed = true;
+        ustring filename = this->filename();
+        int fd           = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0
+            && Filesystem::last_write_time(filename) == m_mod_time) {
+            size_t len = size_t(st.st_size);
+            void* addr = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                m_mapping.reset((const char*)addr, [len](const char* p) {
+                    munmap((void*)p, len);
+                });
+                m_mapping_size   = len;
+                m_mapping_failed = false;
+            }
+        }
+        ::close(fd);
+    }
+    // Make sure that the whole tile, plus the padding we allow SIMD loads
+    // to read past its end, lies within the file, and that the pixels are
+    // suitably aligned for their data type.
+    size_t end = size_t(offset) + spec.tile_bytes() + OIIO_SIMD_MAX_SIZE_BYTES;
+    if (!m_mapping || offset < 0 || end > m_mapping_size
+        || offset % spec.format.size())
+        return nullptr;
+    mapping = m_mapping;
+    return m_mapping.get() + offset;
+#else
+    (void)id;
+    (void)thread_info;
+    (void)mapping;
+    return nullptr;
+#endif
+}
+
+
+
+bool
+ImageCacheFile::constant_tile(const TileID& id,
+                              ImageCachePerThreadInfo* thread_info, void* pixel)
+{
+    int subimage = id.subimage(), miplevel = id.miplevel();
+    const SubimageInfo& si(subimageinfo(subimage));
+    const ImageSpec& spec(this->spec(subimage, miplevel));
+    if (!m_reports_constant_tiles || si.untiled
+        || (si.unmipped && miplevel != 0) || spec.channelformats.size())
+        return false;
+
+    char* native = OIIO_ALLOCA(char, spec.pixel_bytes(true));
+    {
+        std::shared_ptr<ImageInput> inp = lock_reader(thread_info);
+        if (!inp)
+            return false;
+        std::lock_guard<const ImageInput> unlocker(*inp, std::adopt_lock);
+        if (!inp->tile_constant_value(subimage, miplevel, id.x(), id.y(),
+                                      id.z(), native))
+            return false;
+    }
+    return convert_types(spec.format, native + id.chbegin() * spec.format.size(),
+                         datatype(subimage), pixel, id.nchannels());
+}
+
+
+
 bool
 ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info, int subimage,
                           int miplevel, int x, int y, int z, int chbegin,
@@ -803,9 +1064,11 @@ ImageCacheFile::read_tile(ImageCachePerThreadInfo* thread_info, int subimage,
         return read_unmipped(thread_info, subimage, miplevel, x, y, z, chbegin,
                              chend, format, data);
 
-    std::shared_ptr<ImageInput> inp = open(thread_info);
+    std::shared_ptr<ImageInput> inp = lock_reader(thread_info);
     if (!inp)
         return false;
+    // lock_reader handed us the ImageInput locked; unlock it when we leave.
+    std::lock_guard<const ImageInput> unlocker(*inp, std::adopt_lock);
 
     // Special case for untiled images -- need to do tile emulation
     if (subinfo.untiled)
@@ -1056,6 +1319,14 @@ ImageCacheFile::close()
     // are still hanging onto it.
     std::shared_ptr<ImageInput> empty;
     set_imageinput(empty);
+    // Same for any extra readers.
+    std::vector<std::shared_ptr<ImageInput>> extras;
+    {
+        lock_guard lock(m_extra_readers_mutex);
+        extras.swap(m_extra_readers);
+    }
+    for (size_t i = 0, e = extras.size(); i < e; ++i)
+        imagecache().decr_open_files();
 }
 
 
@@ -1066,9 +1337,7 @@ ImageCacheFile::release()
     Timer input_mutex_timer;
     recursive_lock_guard guard(m_input_mutex);
     m_mutex_wait_time += input_mutex_timer();
-    if (m_used)
-        m_used = false;
-    else if (m_allow_release)
+    if (m_allow_release)
         close();
 }
 
@@ -1085,8 +1354,18 @@ ImageCacheFile::invalidate()
     mark_not_broken();
     m_fingerprint.clear();
     duplicate(NULL);
+    {
+        // Tiles still using the old mapping keep it alive until they're
+        // freed, but the file may have changed, so don't hand it out again.
+        spin_lock lock(m_mapping_mutex);
+        m_mapping.reset();
+        m_mapping_size   = 0;
+        m_mapping_failed = false;
+    }
 
-    m_filename = m_imagecache.resolve_filename(m_filename_original.string());
+    ustring filename(
+        m_imagecache.resolve_filename(m_filename_original.string()));
+    m_filename.store(filename.c_str(), std::memory_order_release);
 
     // Eat any errors that occurred in the open/close
     while (!imagecache().geterror().empty())
@@ -1165,6 +1444,38 @@ ImageCacheFile::mark_broken(string_view error)
 
 
 
+void
+ImageCacheFile::mark_open_failed()
+{
+    m_missing      = !Filesystem::exists(filename());
+    m_missing_time = std::chrono::steady_clock::now();
+}
+
+
+
+bool
+ImageCacheFile::retry_missing(float retry_time)
+{
+    if (!m_broken || !m_missing || retry_time <= 0.0f)
+        return false;
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<float>(now - m_missing_time).count()
+        < retry_time)
+        return false;
+    m_missing_time = now;
+    // It may have turned up in any of the searchpath directories.
+    ustring filename(
+        imagecache().resolve_filename(m_filename_original.string()));
+    if (!Filesystem::exists(filename))
+        return false;
+    m_filename.store(filename.c_str(), std::memory_order_release);
+    m_missing = false;
+    mark_not_broken();
+    return true;
+}
+
+
+
 ImageCacheFile*
 ImageCacheImpl::find_file_no_add(ustring filename,
                                  ImageCachePerThreadInfo* thread_info)
@@ -1276,6 +1587,9 @@ ImageCacheImpl::verify_file(ImageCacheFile* tf,
         recursive_lock_guard guard(tf->m_input_mutex);
         tf->m_mutex_wait_time += input_mutex_timer();
         if (!tf->validspec()) {
+            // A file that was missing before is only looked for again
+            // once "missing_file_retry_time" has passed.
+            tf->retry_missing(m_missing_file_retry_time);
             tf->open(thread_info);
             OIIO_DASSERT(tf->m_broken || tf->validspec());
             double createtime = timer();
@@ -1366,13 +1680,6 @@ ImageCacheImpl::clear_fingerprints()
 void
 ImageCacheImpl::check_max_files(ImageCachePerThreadInfo* /*thread_info*/)
 {
-#if 0
-    if (! (m_stat_open_files_created % 16) || m_stat_open_files_current >= m_max_open_files) {
-        std::cerr << "open files " << m_stat_open_files_current << ", max = " << m_max_open_files << "\n";
-    std::cout << "    ImageInputs : " << m_stat_open_files_created << " created, " << m_stat_open_files_current << " current, " << m_stat_open_files_peak << " peak\n";
-    }
-#endif
-
     // Early out if we aren't exceeding the open file handle limit
     if (m_stat_open_files_current < m_max_open_files)
         return;
@@ -1385,60 +1692,58 @@ ImageCacheImpl::check_max_files(ImageCachePerThreadInfo* /*thread_info*/)
     if (!m_file_sweep_mutex.try_lock())
         return;
 
-    // Now, what we want to do is have a "clock hand" that sweeps across
-    // the cache, releasing files that haven't been used for a long
-    // time.  Because of multi-thread, rather than keep an iterator
-    // around for this (which could be invalidated since the last time
-    // we used it), we just remember the filename of the next file to
-    // check, then look it up fresh.  That is m_file_sweep_name.
-
-    // Get a (locked) iterator for the next tile to be examined.
-    FilenameMap::iterator sweep;
-    if (!m_file_sweep_name.empty()) {
-        // We saved the sweep_id. Find the iterator corresponding to it.
-        sweep = m_files.find(m_file_sweep_name);
-        // Note: if the sweep_id is no longer in the table, sweep will be an
-        // empty iterator. That's ok, it will be fixed early in the main
-        // loop below.
+    // Close the least recently used of the open files until we're under
+    // the limit. There are only ever about max_open_files of them, so
+    // it's cheap to sort them all, and much cheaper than the reopening
+    // (and header reading) that closing a popular file would lead to.
+    std::vector<std::pair<long long, ImageCacheFile*>> lru;
+    {
+        std::lock_guard<std::mutex> lock(m_open_files_mutex);
+        lru.reserve(m_open_files.size());
+        for (ImageCacheFile* file : m_open_files)
+            if (file->m_allow_release)
+                lru.emplace_back(file->m_last_used.load(), file);
+    }
+    std::sort(lru.begin(), lru.end());
+    // N.B. Files are only destroyed along with the ImageCache, so it's
+    // safe to use them outside the lock.
+    for (auto& f : lru) {
+        if (m_stat_open_files_current < m_max_open_files)
+            break;
+        f.second->release();
     }
+    m_file_sweep_mutex.unlock();
+}
 
 
-    // Loop while we still have too many files open.  Also, be careful
-    // of looping for too long, exit the loop if we just keep spinning
-    // uncontrollably.
-    int full_loops = 0;
-    while (m_stat_open_files_current >= m_max_open_files && full_loops <= 100) {
-        // If we have fallen off the end of the cache, loop back to the
-        // beginning and increment our full_loops count.
-        if (!sweep) {
-            sweep = m_files.begin();
-            ++full_loops;
+
+void
+ImageCacheImpl::update_open_file(ImageCacheFile* file)
+{
+    // N.B. Find out before locking, because get_imageinput() may itself
+    // need to lock. A concurrent open or close could change it before we
+    // update the list, so check again afterwards.
+    bool open = bool(file->get_imageinput(nullptr));
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(m_open_files_mutex);
+            if (open && file->m_open_index < 0) {
+                file->m_open_index = int(m_open_files.size());
+                m_open_files.push_back(file);
+                file->m_last_used = ++m_file_open_clock;
+            } else if (!open && file->m_open_index >= 0) {
+                ImageCacheFile* last             = m_open_files.back();
+                m_open_files[file->m_open_index] = last;
+                last->m_open_index               = file->m_open_index;
+                m_open_files.pop_back();
+                file->m_open_index = -1;
+            }
         }
-        // If we're STILL at the end, it must be that somehow the entire
-        // cache is empty.  So just declare ourselves done.
-        if (!sweep)
+        bool now = bool(file->get_imageinput(nullptr));
+        if (now == open)
             break;
-        OIIO_DASSERT(sweep->second);
-        sweep->second->release();  // May reduce open files
-        ++sweep;
-        // Note: This loop is a lot less complicated than the one in
-        // ImageCacheImpl::check_max_mem. That's because for the file
-        // cache, we just need to release old ones, we don't actually
-        // erase entries from the cache, so there is no tricky lock/unlock,
-        // erasure, or invalidation of iterators.
-    }
-
-    // OK, by this point we have either closed enough files to be below
-    // the limit again, or the cache is empty, or we've looped over the
-    // cache too many times and are giving up.
-
-    // Now we must save the filename for next time.  Just set it to an
-    // empty string if we don't have a valid iterator at this point.
-    m_file_sweep_name = (sweep ? sweep->first : ustring());
-    m_file_sweep_mutex.unlock();
-
-    // N.B. As we exit, the iterators will go out of scope and we will
-    // retain no locks on the cache.
+        open = now;
+    }
 }
 
 
@@ -1453,9 +1758,12 @@ ImageCacheImpl::set_min_cache_size(long long newsize)
 
 ImageCacheTile::ImageCacheTile(const TileID& id)
     : m_id(id)
+    , m_shard(id.file().imagecache().tile_shard(id))
     , m_valid(true)
 {
-    id.file().imagecache().incr_tiles(0);  // mem counted separately in read
+    m_hot = id.file().imagecache().admit_hot(id);
+    // mem counted separately in read
+    id.file().imagecache().incr_tiles(0, m_shard, m_hot);
 }
 
 
@@ -1464,6 +1772,7 @@ ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
                                TypeDesc format, stride_t xstride,
                                stride_t ystride, stride_t zstride, bool copy)
     : m_id(id)
+    , m_shard(id.file().imagecache().tile_shard(id))
 {
     ImageCacheFile& file(m_id.file());
     const ImageSpec& spec(file.spec(id.subimage(), id.miplevel()));
@@ -1476,7 +1785,8 @@ ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
                         (unsigned long long)size,
                         (unsigned long long)memsize());
         m_pixels_size = size;
-        m_pixels.reset(new char[m_pixels_size]);
+        m_pixels.reset(
+            file.imagecache().tile_pool().allocate(m_pixels_size));
         m_valid
             = convert_image(id.nchannels(), spec.tile_width, spec.tile_height,
                             spec.tile_depth, pels, format, xstride, ystride,
@@ -1489,7 +1799,8 @@ ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
         m_pixels.reset((char*)pels);
         m_valid = true;
     }
-    id.file().imagecache().incr_tiles(m_pixels_size);
+    m_hot = id.file().imagecache().admit_hot(id);
+    id.file().imagecache().incr_tiles(m_pixels_size, m_shard, m_hot);
     m_pixels_ready = true;  // Caller sent us the pixels, no read necessary
     // FIXME -- for shadow, fill in mindepth, maxdepth
 }
@@ -1498,9 +1809,12 @@ ImageCacheTile::ImageCacheTile(const TileID& id, const void* pels,
 
 ImageCacheTile::~ImageCacheTile()
 {
-    m_id.file().imagecache().decr_tiles(memsize());
+    m_id.file().imagecache().decr_tiles(memsize(), m_shard, m_hot);
     if (m_nofree)
         m_pixels.release();  // release without freeing
+    else
+        m_id.file().imagecache().tile_pool().deallocate(m_pixels.release(),
+                                                        m_pixels_size);
 }
 
 
@@ -1526,31 +1840,164 @@ ImageCacheTile::read(ImageCachePerThreadInfo* thread_info)
     m_pixelsize   = m_id.nchannels() * m_channelsize;
     size_t size   = memsize_needed();
     OIIO_ASSERT(memsize() == 0 && size > OIIO_SIMD_MAX_SIZE_BYTES);
-    m_pixels.reset(new char[m_pixels_size = size]);
+    if (file.imagecache().mmap_tiles()) {
+        // Use the pixels right where they are in the (mapped) file, if
+        // we can. We don't own them and they don't count against the
+        // cache's memory limit -- they're just pages of the OS file cache.
+        if (const char* p = file.mapped_tile(m_id, thread_info,
+                                             m_shared_pixels)) {
+            m_nofree = true;
+            m_pixels.reset(const_cast<char*>(p));
+            m_valid = true;
+            file.mark_tile_read(m_id);
+            ++thread_info->m_stats.mapped_tiles;
+            m_pixels_ready = true;
+            return;
+        }
+    }
+    if (file.imagecache().skip_constant_tiles()) {
+        // If the reader can tell that the tile is constant (like the empty
+        // space of a sparse volume), skip reading it and just keep the one
+        // pixel, just as if we had read it and found it constant. Unlike
+        // checking every tile read, that costs nothing, so it doesn't wait
+        // for compact_constant_tiles.
+        char* pixel = OIIO_ALLOCA(char, m_pixelsize);
+        if (file.constant_tile(m_id, thread_info, pixel)) {
+            m_pixels_size = m_pixelsize + OIIO_SIMD_MAX_SIZE_BYTES;
+            m_pixels.reset(
+                file.imagecache().tile_pool().allocate(m_pixels_size));
+            memcpy(m_pixels.get(), pixel, m_pixelsize);
+            memset(m_pixels.get() + m_pixelsize, 0, OIIO_SIMD_MAX_SIZE_BYTES);
+            m_constant = true;
+            m_valid    = true;
+            file.mark_tile_read(m_id);
+            ++thread_info->m_stats.constant_tiles;
+            m_id.file().imagecache().incr_mem(m_pixels_size, m_shard, m_hot);
+            m_pixels_ready = true;
+            return;
+        }
+    }
+    // Maybe another process on this host already read the tile into the
+    // shared tile store. Unlike mapped tiles, those are charged to us, so
+    // that evicting them lets go of our reference and the store can
+    // recycle their slots.
+    SharedTileStore& shared(file.imagecache().shared_tiles());
+    std::string sharedkey;
+    if (shared.enabled())
+        sharedkey = file.disk_cache_key(m_id);
+    if (!sharedkey.empty()) {
+        m_shared_pixels = shared.find(sharedkey, size);
+        if (m_shared_pixels) {
+            m_nofree = true;
+            m_pixels.reset(const_cast<char*>(m_shared_pixels.get()));
+            m_pixels_size = size;
+            m_valid       = true;
+            file.mark_tile_read(m_id);
+            ++thread_info->m_stats.shared_tiles_hits;
+            m_id.file().imagecache().incr_mem(m_pixels_size, m_shard, m_hot);
+            m_pixels_ready = true;
+            return;
+        }
+        ++thread_info->m_stats.shared_tiles_misses;
+    }
+    m_pixels_size = size;
+    m_pixels.reset(file.imagecache().tile_pool().allocate(size));
     // Clear the end pad values so there aren't NaNs sucked up by simd loads
     memset(m_pixels.get() + size - OIIO_SIMD_MAX_SIZE_BYTES, 0,
            OIIO_SIMD_MAX_SIZE_BYTES);
-    m_valid = file.read_tile(thread_info, m_id.subimage(), m_id.miplevel(),
-                             m_id.x(), m_id.y(), m_id.z(), m_id.chbegin(),
-                             m_id.chend(), file.datatype(m_id.subimage()),
-                             &m_pixels[0]);
-    m_id.file().imagecache().incr_mem(size);
+    // If the tile was evicted earlier and is still in the compressed tier,
+    // decompressing it there is much cheaper than going back to the file.
+    bool promoted = false;
+    CompressedTileCache& compressed(file.imagecache().compressed_tiles());
+    if (compressed.enabled()) {
+        promoted = compressed.fetch(m_id, &m_pixels[0], size);
+        if (promoted)
+            ++thread_info->m_stats.compressed_tiles_hits;
+        else
+            ++thread_info->m_stats.compressed_tiles_misses;
+    }
+    // Next best is finding the decoded tile in the on-disk cache, perhaps
+    // left there by an earlier run.
+    DiskTileCache& disk(file.imagecache().disk_tiles());
+    std::string diskkey;
+    size_t disksize = size - OIIO_SIMD_MAX_SIZE_BYTES;  // Not the padding
+    if (!promoted && disk.enabled())
+        diskkey = file.disk_cache_key(m_id);
+    if (!diskkey.empty()) {
+        promoted = disk.read(diskkey, &m_pixels[0], disksize);
+        if (promoted)
+            ++thread_info->m_stats.disk_cache_hits;
+        else
+            ++thread_info->m_stats.disk_cache_misses;
+    }
+    if (promoted) {
+        m_valid = true;
+    } else {
+        m_valid = file.read_tile(thread_info, m_id.subimage(),
+                                 m_id.miplevel(), m_id.x(), m_id.y(), m_id.z(),
+                                 m_id.chbegin(), m_id.chend(),
+                                 file.datatype(m_id.subimage()), &m_pixels[0]);
+        if (m_valid && !diskkey.empty()
+            && disk.write(diskkey, &m_pixels[0], disksize)
+            && disk.cleanup_due())
+            file.imagecache().run_in_background([&disk]() { disk.cleanup(); });
+    }
+    if (m_valid && file.imagecache().compact_constant_tiles()) {
+        // If every pixel is the same as the next, the tile is constant:
+        // trade our buffer for one holding just the first pixel (and the
+        // SIMD padding), and only charge the tile for that.
+        const char* p = m_pixels.get();
+        size_t bytes  = size - OIIO_SIMD_MAX_SIZE_BYTES;
+        if (!memcmp(p, p + m_pixelsize, bytes - m_pixelsize)) {
+            char* pixel = file.imagecache().tile_pool().allocate(
+                m_pixelsize + OIIO_SIMD_MAX_SIZE_BYTES);
+            memcpy(pixel, p, m_pixelsize);
+            memset(pixel + m_pixelsize, 0, OIIO_SIMD_MAX_SIZE_BYTES);
+            file.imagecache().tile_pool().deallocate(m_pixels.release(), size);
+            m_pixels.reset(pixel);
+            m_constant    = true;
+            m_pixels_size = size = m_pixelsize + OIIO_SIMD_MAX_SIZE_BYTES;
+            ++thread_info->m_stats.constant_tiles;
+        }
+    }
+    if (m_valid && !m_constant && !sharedkey.empty()) {
+        // Put the tile in the shared store for the other processes, and
+        // use it from there ourselves (still charged to us, as above).
+        m_shared_pixels = shared.insert(sharedkey, m_pixels.get(), size);
+        if (m_shared_pixels) {
+            file.imagecache().tile_pool().deallocate(m_pixels.release(), size);
+            m_pixels.reset(const_cast<char*>(m_shared_pixels.get()));
+            m_nofree = true;
+        }
+    }
+    if (m_valid && !m_shared_pixels && file.imagecache().deduplicate_tiles()) {
+        // Share the pixels with any other tile that has the same ones. The
+        // buffer we end up with is charged to the cache for as long as any
+        // tile uses it, so the tile itself takes no memory.
+        size_t bytes  = size - OIIO_SIMD_MAX_SIZE_BYTES;
+        uint64_t hash = farmhash::Hash(m_pixels.get(), bytes);
+        std::shared_ptr<const char> mine
+            = file.imagecache().share_tile_pixels(m_pixels.release(), size,
+                                                  m_shard);
+        m_shared_pixels = file.imagecache().dedup_tiles().share(hash, mine,
+                                                                bytes);
+        if (m_shared_pixels != mine) {
+            ++thread_info->m_stats.dedup_tiles;
+            thread_info->m_stats.dedup_bytes_saved += size;
+        }
+        m_pixels.reset(const_cast<char*>(m_shared_pixels.get()));
+        m_nofree      = true;
+        m_deduped     = true;
+        m_pixels_size = size = 0;
+    }
+    m_id.file().imagecache().incr_mem(size, m_shard, m_hot);
     if (m_valid) {
-        // Figure out if
-        ImageCacheFile::LevelInfo& lev(
-            file.levelinfo(m_id.subimage(), m_id.miplevel()));
-        int whichtile = ((m_id.x() - lev.spec.x) / lev.spec.tile_width)
-                        + ((m_id.y() - lev.spec.y) / lev.spec.tile_height)
-                              * lev.nxtiles
-                        + ((m_id.z() - lev.spec.z) / lev.spec.tile_depth)
-                              * (lev.nxtiles * lev.nytiles);
-        int index       = whichtile / 64;
-        int64_t bitmask = int64_t(1ULL << (whichtile & 63));
-        int64_t oldval  = lev.tiles_read[index].fetch_or(bitmask);
-        if (oldval & bitmask)  // Was it previously read?
-            file.register_redundant_tile(lev.spec.tile_bytes());
+        // Reading a tile from the file again is redundant; getting it back
+        // from one of the other tiers isn't.
+        if (file.mark_tile_read(m_id) && !promoted)
+            file.register_redundant_tile(
+                file.spec(m_id.subimage(), m_id.miplevel()).tile_bytes());
     } else {
-        // (! m_valid)
         m_used = false;  // Don't let it hold mem if invalid
         if (file.mod_time() != Filesystem::last_write_time(file.filename()))
             file.imagecache().error(
@@ -1595,110 +2042,1250 @@ ImageCacheTile::data(int x, int y, int z, int c) const
     if (x < 0 || x >= (int)w || y < 0 || y >= (int)h || z < 0 || z >= (int)d
         || c < m_id.chbegin() || c > m_id.chend())
         return NULL;
-    size_t offset = ((z * h + y) * w + x) * pixelsize()
-                    + (c - m_id.chbegin()) * channelsize();
+    size_t offset = (c - m_id.chbegin()) * channelsize();
+    if (!m_constant)
+        offset += ((z * h + y) * w + x) * pixelsize();
     return (const void*)&m_pixels[offset];
 }
 
 
 
-ImageCacheImpl::ImageCacheImpl()
-    : m_perthread_info(&cleanup_perthread_info)
+const void*
+ImageCacheTile::full_data() const
 {
-    init();
+    if (!m_constant)
+        return data();
+    spin_lock lock(m_full_mutex);
+    if (!m_full_pixels) {
+        ImageCacheImpl& imagecache(m_id.file().imagecache());
+        m_full_pixels = imagecache.constant_tiles().get(imagecache,
+                                                        m_pixels.get(),
+                                                        m_pixelsize,
+                                                        memsize_needed(),
+                                                        m_shard);
+    }
+    return m_full_pixels.get();
+}
+
+
+
+TilePixelPool::~TilePixelPool()
+{
+    for (auto& c : m_classes)
+        for (auto& slab : c->slabs)
+            free_slab(slab.second->base);
+}
+
+
+
+TilePixelPool::SizeClass&
+TilePixelPool::size_class(size_t bufsize)
+{
+    {
+        spin_rw_read_lock lock(m_classes_mutex);
+        for (auto& c : m_classes)
+            if (c->bufsize == bufsize)
+                return *c;
+    }
+    spin_rw_write_lock lock(m_classes_mutex);
+    for (auto& c : m_classes)  // Somebody may have added it meanwhile
+        if (c->bufsize == bufsize)
+            return *c;
+    m_classes.emplace_back(new SizeClass);
+    SizeClass& c(*m_classes.back());
+    c.bufsize = bufsize;
+    c.nbufs   = int(slab_size / bufsize);
+    return c;
+}
+
+
+
+char*
+TilePixelPool::new_slab()
+{
+    // Align slabs to the huge page size, so that the system is able to
+    // back each one with a single huge page if asked to.
+    char* base = (char*)aligned_malloc(slab_size, slab_size);
+    if (!base)
+        throw std::bad_alloc();
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (m_hugepages)
+        madvise(base, slab_size, MADV_HUGEPAGE);
+#endif
+    m_resident += slab_size;
+    return base;
 }
 
 
 
 void
-ImageCacheImpl::set_max_open_files(int max_open_files)
+TilePixelPool::free_slab(char* base)
 {
-    // Clamp to somewhat less than the maximum number of files allowed
-    // by the system.
-    int m = int(std::min(Sysutil::max_open_files(),
-                         size_t(std::numeric_limits<int>::max())));
-    m     = std::max(10, m - 5 * int(Sysutil::hardware_concurrency()));
-    m_max_open_files = std::min(max_open_files, m);
-    // std::cout << "clamped max_open_files = " << m_max_open_files << "\n";
+    aligned_free(base);
+    m_resident -= slab_size;
+}
+
+
+
+char*
+TilePixelPool::allocate(size_t size)
+{
+    // Round up to whole cache lines, so every buffer is well aligned.
+    size_t bufsize = round_to_multiple(size, size_t(64));
+    if (bufsize > slab_size / 4) {
+        // Too big to share a slab with more than a few others, so this one
+        // gets an allocation of its own.
+        char* buf = (char*)aligned_malloc(bufsize, 64);
+        if (!buf)
+            throw std::bad_alloc();
+        m_resident += bufsize;
+        return buf;
+    }
+
+    SizeClass& c(size_class(bufsize));
+    spin_lock lock(c.mutex);
+    if (c.partial.empty()) {
+        std::unique_ptr<Slab> slab(new Slab);
+        slab->base = new_slab();
+        slab->free.reserve(c.nbufs);
+        for (int i = c.nbufs - 1; i >= 0; --i)
+            slab->free.push_back(i);
+        c.partial.push_back(slab.get());
+        c.slabs[slab->base] = std::move(slab);
+    }
+    Slab* slab = c.partial.back();
+    int i      = slab->free.back();
+    slab->free.pop_back();
+    if (slab->free.empty())
+        c.partial.pop_back();  // Full now
+    return slab->base + size_t(i) * bufsize;
 }
 
 
 
 void
-ImageCacheImpl::init()
+TilePixelPool::deallocate(char* buf, size_t size)
 {
-    set_max_open_files(100);
-    m_max_memory_bytes     = 1024LL * 1024 * 1024;  // 1 GB default cache size
-    m_autotile             = 0;
-    m_autoscanline         = false;
-    m_automip              = false;
-    m_forcefloat           = false;
-    m_accept_untiled       = true;
-    m_accept_unmipped      = true;
-    m_deduplicate          = true;
-    m_unassociatedalpha    = false;
-    m_failure_retries      = 0;
-    m_latlong_y_up_default = true;
-    m_Mw2c.makeIdentity();
-    m_mem_used                = 0;
-    m_statslevel              = 0;
-    m_max_errors_per_file     = 100;
-    m_stat_tiles_created      = 0;
-    m_stat_tiles_current      = 0;
-    m_stat_tiles_peak         = 0;
-    m_stat_open_files_created = 0;
-    m_stat_open_files_current = 0;
-    m_stat_open_files_peak    = 0;
+    if (!buf)
+        return;
+    size_t bufsize = round_to_multiple(size, size_t(64));
+    if (bufsize > slab_size / 4) {
+        aligned_free(buf);
+        m_resident -= bufsize;
+        return;
+    }
 
-    // Allow environment variable to override default options
-    const char* options = getenv("OPENIMAGEIO_IMAGECACHE_OPTIONS");
-    if (options)
-        attribute("options", options);
+    SizeClass& c(size_class(bufsize));
+    spin_lock lock(c.mutex);
+    // Find the slab holding buf: the last one starting at or below it.
+    auto s = c.slabs.upper_bound(buf);
+    OIIO_DASSERT(s != c.slabs.begin());
+    --s;
+    Slab* slab = s->second.get();
+    OIIO_DASSERT(buf >= slab->base && buf < slab->base + slab_size);
+    slab->free.push_back(int((buf - slab->base) / bufsize));
+    if (slab->free.size() == 1) {
+        c.partial.push_back(slab);  // Was full, has room again
+    } else if (int(slab->free.size()) == c.nbufs && c.partial.size() > 1) {
+        // Completely unused, and other slabs have room for new tiles, so
+        // give this one back to the system.
+        c.partial.erase(std::find(c.partial.begin(), c.partial.end(), slab));
+        free_slab(slab->base);
+        c.slabs.erase(s);
+    }
 }
 
 
 
-ImageCacheImpl::~ImageCacheImpl()
+std::shared_ptr<const char>
+ConstantTileCache::get(ImageCacheImpl& imagecache, const char* pixel,
+                       size_t pixelsize, size_t size, int shard)
 {
-    printstats();
-    erase_perthread_info();
+    std::string key((const char*)&size, sizeof(size));
+    key.append(pixel, pixelsize);
+    spin_lock lock(m_mutex);
+    std::weak_ptr<const char>& entry(m_buffers[key]);
+    std::shared_ptr<const char> buf = entry.lock();
+    if (!buf) {
+        char* b        = imagecache.tile_pool().allocate(size);
+        size_t npixels = (size - OIIO_SIMD_MAX_SIZE_BYTES) / pixelsize;
+        for (size_t i = 0; i < npixels; ++i)
+            memcpy(b + i * pixelsize, pixel, pixelsize);
+        memset(b + npixels * pixelsize, 0, size - npixels * pixelsize);
+        buf   = imagecache.share_tile_pixels(b, size, shard);
+        entry = buf;
+        if (m_buffers.size() >= m_prune_size) {
+            for (auto i = m_buffers.begin(); i != m_buffers.end();) {
+                if (i->second.expired())
+                    i = m_buffers.erase(i);
+                else
+                    ++i;
+            }
+            m_prune_size = 2 * m_buffers.size() + 64;
+        }
+    }
+    return buf;
 }
 
 
 
-void
-ImageCacheImpl::mergestats(ImageCacheStatistics& stats) const
+std::shared_ptr<const char>
+TileDedupCache::share(uint64_t hash, const std::shared_ptr<const char>& buf,
+                      size_t size)
 {
-    stats.init();
-    spin_lock lock(m_perthread_info_mutex);
-    for (size_t i = 0; i < m_all_perthread_info.size(); ++i)
-        stats.merge(m_all_perthread_info[i]->m_stats);
+    std::shared_ptr<const char> found;
+    {
+        spin_lock lock(m_mutex);
+        auto f = m_buffers.find(hash);
+        if (f != m_buffers.end() && f->second.size == size)
+            found = f->second.buffer.lock();
+        if (!found) {
+            m_buffers[hash] = Entry { buf, size };
+            if (m_buffers.size() >= m_prune_size) {
+                for (auto i = m_buffers.begin(); i != m_buffers.end();) {
+                    if (i->second.buffer.expired())
+                        i = m_buffers.erase(i);
+                    else
+                        ++i;
+                }
+                m_prune_size = 2 * m_buffers.size() + 256;
+            }
+            return buf;
+        }
+    }
+    // Compare the pixels outside the lock. On the (unlikely) hash
+    // collision, just don't share.
+    return memcmp(found.get(), buf.get(), size) ? buf : found;
 }
 
 
 
-std::string
-ImageCacheImpl::onefile_stat_line(const ImageCacheFileRef& file, int i,
-                                  bool includestats) const
+std::shared_ptr<const char>
+ImageCacheImpl::share_tile_pixels(char* pixels, size_t size, int shard)
 {
-    // FIXME -- make meaningful stat printouts for multi-image textures
-    std::ostringstream out;
-    out.imbue(std::locale::classic());  // Force "C" locale with '.' decimal
-    const ImageSpec& spec(file->spec(0, 0));
-    const char* formatcode = "u8";
-    switch (spec.format.basetype) {
-    case TypeDesc::UINT8: formatcode = "u8 "; break;
-    case TypeDesc::INT8: formatcode = "i8 "; break;
-    case TypeDesc::UINT16: formatcode = "u16"; break;
-    case TypeDesc::INT16: formatcode = "i16"; break;
-    case TypeDesc::UINT: formatcode = "u32"; break;
-    case TypeDesc::INT: formatcode = "i32"; break;
-    case TypeDesc::UINT64: formatcode = "i64"; break;
-    case TypeDesc::INT64: formatcode = "u64"; break;
-    case TypeDesc::HALF: formatcode = "f16"; break;
-    case TypeDesc::FLOAT: formatcode = "f32"; break;
-    case TypeDesc::DOUBLE: formatcode = "f64"; break;
-    default: break;
+    incr_mem(size, shard, false);
+    return std::shared_ptr<const char>(pixels, [=](const char* p) {
+        decr_mem(size, shard);
+        m_tile_pool.deallocate(const_cast<char*>(p), size);
+    });
+}
+
+
+
+void
+CompressedTileCache::max_memory(long long bytes)
+{
+    spin_lock lock(m_mutex);
+    m_max_memory = std::max(bytes, 0LL);
+    if (!m_max_memory) {
+        m_tiles.clear();
+        m_order.clear();
+        m_mem_used = 0;
+    } else {
+        trim();
+    }
+}
+
+
+
+bool
+CompressedTileCache::store(const TileID& id, const void* data, size_t size)
+{
+    if (!enabled())
+        return false;
+
+    // Compress outside the lock. Favor speed: the point of this tier is to
+    // be much cheaper than reading and decoding the tile again.
+    uLongf csize = compressBound(uLong(size));
+    std::unique_ptr<char[]> buf(new char[csize]);
+    if (compress2((Bytef*)buf.get(), &csize, (const Bytef*)data, uLong(size),
+                  Z_BEST_SPEED)
+        != Z_OK)
+        return false;
+    if ((long long)csize > m_max_memory)
+        return false;  // Wouldn't fit even in an empty cache
+    Entry entry;
+    entry.data.reset(new char[csize]);
+    memcpy(entry.data.get(), buf.get(), csize);
+    entry.compressed_size = csize;
+    entry.size            = size;
+
+    spin_lock lock(m_mutex);
+    entry.serial = m_serial++;
+    auto found   = m_tiles.find(id);
+    if (found != m_tiles.end()) {
+        m_mem_used -= found->second.compressed_size;
+        m_tiles.erase(found);
+    }
+    m_order.emplace_back(id, entry.serial);
+    m_mem_used += entry.compressed_size;
+    m_tiles.emplace(id, std::move(entry));
+    trim();
+    return true;
+}
+
+
+
+bool
+CompressedTileCache::fetch(const TileID& id, void* data, size_t size)
+{
+    Entry entry;
+    {
+        spin_lock lock(m_mutex);
+        auto found = m_tiles.find(id);
+        if (found == m_tiles.end() || found->second.size != size)
+            return false;
+        entry = std::move(m_tiles[id]);
+        m_tiles.erase(id);
+        m_mem_used -= entry.compressed_size;
+        // Its entry in m_order is now stale, and trim() will skip it.
+    }
+    uLongf dsize = uLongf(size);
+    return uncompress((Bytef*)data, &dsize, (const Bytef*)entry.data.get(),
+                      uLong(entry.compressed_size))
+               == Z_OK
+           && dsize == size;
+}
+
+
+
+void
+CompressedTileCache::erase(const ImageCacheFile* file)
+{
+    spin_lock lock(m_mutex);
+    if (!file) {
+        m_tiles.clear();
+        m_order.clear();
+        m_mem_used = 0;
+        return;
+    }
+    for (auto t = m_tiles.begin(); t != m_tiles.end();) {
+        if (t->first.file_ptr() == file) {
+            m_mem_used -= t->second.compressed_size;
+            t = m_tiles.erase(t);
+        } else {
+            ++t;
+        }
+    }
+}
+
+
+
+void
+CompressedTileCache::trim()
+{
+    while (m_mem_used > m_max_memory && !m_order.empty()) {
+        auto oldest = m_order.front();
+        m_order.pop_front();
+        auto found = m_tiles.find(oldest.first);
+        if (found != m_tiles.end() && found->second.serial == oldest.second) {
+            m_mem_used -= found->second.compressed_size;
+            m_tiles.erase(found);
+        }
+    }
+    // Don't let stale entries pile up in m_order if tiles are fetched much
+    // more often than the budget forces us to discard any.
+    if (m_order.size() > 2 * m_tiles.size() + 1024) {
+        std::deque<std::pair<TileID, uint64_t>> order;
+        for (auto& o : m_order) {
+            auto found = m_tiles.find(o.first);
+            if (found != m_tiles.end() && found->second.serial == o.second)
+                order.push_back(o);
+        }
+        m_order.swap(order);
+    }
+}
+
+
+
+// Header of a tile file in the disk cache, followed by the key and then
+// the pixels.
+struct DiskTileHeader {
+    char magic[8];      // "OIIOtile"
+    uint32_t version;   // disk_tile_version
+    uint32_t keylen;    // Length of the key
+    uint64_t datasize;  // Bytes of pixel data
+};
+static const uint32_t disk_tile_version = 1;
+
+
+
+void
+DiskTileCache::directory(ustring dir)
+{
+    if (dir.size() && !Filesystem::is_directory(dir)) {
+        std::string err;
+        Filesystem::create_directory(dir, err);
+    }
+    std::lock_guard<std::mutex> lock(m_cleanup_mutex);
+    m_dir        = dir;
+    m_bytes_used = -1;
+}
+
+
+
+std::string
+DiskTileCache::path(string_view key) const
+{
+    // Spread tiles over 256 subdirectories to keep directories small.
+    std::string hash = Strutil::fmt::format("{:016x}", farmhash::Hash(key));
+    return Strutil::fmt::format("{}/{}/{}.tile", m_dir, hash.substr(0, 2),
+                                hash);
+}
+
+
+
+bool
+DiskTileCache::read(string_view key, void* data, size_t size)
+{
+    std::string filename = path(key);
+    FILE* fd             = Filesystem::fopen(filename, "rb");
+    if (!fd)
+        return false;
+    DiskTileHeader header;
+    std::string filekey(key.size(), '\0');
+    bool ok = fread(&header, sizeof(header), 1, fd) == 1
+              && !memcmp(header.magic, "OIIOtile", 8)
+              && header.version == disk_tile_version
+              && header.keylen == key.size() && header.datasize == size
+              && fread(&filekey[0], 1, key.size(), fd) == key.size()
+              && filekey == key && fread(data, 1, size, fd) == size;
+    fclose(fd);
+    if (ok) {
+        // Mark it as recently used, so cleanup() keeps it.
+        Filesystem::last_write_time(filename, time(nullptr));
+    }
+    return ok;
+}
+
+
+
+bool
+DiskTileCache::write(string_view key, const void* data, size_t size)
+{
+    std::string filename = path(key);
+    std::string dir      = Filesystem::parent_path(filename);
+    if (!Filesystem::is_directory(dir)) {
+        std::string err;
+        Filesystem::create_directory(dir, err);
+    }
+    // Write to a uniquely named temporary file, then rename it into place,
+    // which is atomic, so another thread or process either finds the
+    // whole tile or none of it.
+    std::string tmpname = filename + "." + Filesystem::unique_path() + ".tmp";
+    FILE* fd            = Filesystem::fopen(tmpname, "wb");
+    if (!fd)
+        return false;
+    DiskTileHeader header;
+    memcpy(header.magic, "OIIOtile", 8);
+    header.version  = disk_tile_version;
+    header.keylen   = uint32_t(key.size());
+    header.datasize = size;
+    bool ok         = fwrite(&header, sizeof(header), 1, fd) == 1
+              && fwrite(key.data(), 1, key.size(), fd) == key.size()
+              && fwrite(data, 1, size, fd) == size;
+    ok &= (fclose(fd) == 0);
+    std::string err;
+    if (!ok || !Filesystem::rename(tmpname, filename, err)) {
+        Filesystem::remove(tmpname, err);
+        return false;
+    }
+
+    // Until cleanup() has taken stock of the directory, there's nothing to
+    // add to; it counts what we write in the meantime.
+    long long filesize = (long long)(sizeof(header) + key.size() + size);
+    m_bytes_written += filesize;
+    if (m_bytes_used >= 0)
+        m_bytes_used += filesize;
+    return true;
+}
+
+
+
+bool
+DiskTileCache::cleanup_due()
+{
+    long long used = m_bytes_used;
+    if (used >= 0 && used <= m_max_bytes)
+        return false;
+    bool due = false;
+    return m_cleanup_due.compare_exchange_strong(due, true);
+}
+
+
+
+void
+DiskTileCache::cleanup()
+{
+    std::lock_guard<std::mutex> lock(m_cleanup_mutex);
+
+    // Take stock of the whole directory, since other processes may be
+    // adding to (or cleaning up) the same cache. Tiles we write while
+    // that's going on may or may not be seen, so count them in anyway.
+    long long written = m_bytes_written;
+    std::vector<std::string> files;
+    Filesystem::get_directory_entries(m_dir.string(), files, true);
+    struct TileFile {
+        std::time_t time;
+        long long size;
+        const std::string* name;
+    };
+    std::vector<TileFile> tiles;
+    tiles.reserve(files.size());
+    long long total = 0;
+    std::time_t now = time(nullptr);
+    for (auto& f : files) {
+        std::time_t t = Filesystem::last_write_time(f);
+        if (Strutil::ends_with(f, ".tmp")) {
+            // Leftover from a process that died mid-write?
+            if (now - t > 3600)
+                Filesystem::remove(f);
+            continue;
+        }
+        if (!Strutil::ends_with(f, ".tile"))
+            continue;
+        long long size = (long long)Filesystem::file_size(f);
+        tiles.push_back({ t, size, &f });
+        total += size;
+    }
+
+    // Delete the least recently used tiles until we're at 90% of the limit,
+    // so that we don't have to do this again right away.
+    long long target = m_max_bytes - m_max_bytes / 10;
+    if (total > target) {
+        std::sort(tiles.begin(), tiles.end(),
+                  [](const TileFile& a, const TileFile& b) {
+                      return a.time < b.time;
+                  });
+        for (auto& t : tiles) {
+            if (total <= target)
+                break;
+            if (Filesystem::remove(*t.name))
+                total -= t.size;
+        }
+    }
+    m_bytes_used  = total + (m_bytes_written - written);
+    m_cleanup_due = false;
+}
+
+
+
+#ifdef __linux__
+namespace {
+
+// The layout of a shared tile segment: a header, the hash index (the first
+// slot of each bucket's chain), the slot table, then the slots' pixels.
+// All of it is shared by the processes, so it's made only of plain data,
+// lock-free atomics, and a process-shared mutex.
+//
+// Each attachment to the segment (a process, or one of several caches in a
+// process) has an entry in the header, and each slot has a bit for every
+// entry that holds references to it. The reference counts themselves are
+// kept by each attachment. An attachment also holds a lock on the byte of
+// the segment file at its entry's index for as long as it's attached; the
+// kernel drops that lock when the process dies, so the others can tell
+// that it's gone (whatever its pid, and whatever pid namespace they're in)
+// and drop its entry and all of its references at once.
+//
+// The mutex is robust: if a process dies holding it, the next one to lock
+// it is told so, and rebuilds the index from the slot table before using
+// it.
+enum { ShmMaxAttached = 64 };
+
+struct ShmTileHeader {
+    char magic[8];                  // "OIIOshm3"
+    uint64_t size;                  // Bytes in the whole segment
+    uint64_t slot_bytes;            // Bytes of pixels each slot can hold
+    uint32_t nslots;                // Number of slots
+    uint32_t nbuckets;              // Hash index size (a power of 2)
+    std::atomic<uint32_t> ready;    // Fully initialized
+    pthread_mutex_t mutex;          // Guards what follows, and the slots
+    uint32_t removed;               // Unlinked by the last to detach
+    uint32_t hand;                  // Clock hand
+    int32_t attached[ShmMaxAttached];  // Pid of each attachment, or 0
+};
+
+struct ShmTileSlot {
+    uint64_t key[2];                // Two hashes of the tile's key
+    uint64_t size;                  // Bytes of pixels
+    uint64_t holders;               // Attachments referencing it (bits)
+    int32_t next;                   // Next slot in the bucket, or -1
+    uint32_t state;                 // ShmSlotFree/Writing/Ready
+    uint32_t used;                  // Found since the clock last passed
+};
+
+enum { ShmSlotFree = 0, ShmSlotWriting, ShmSlotReady };
+
+static const char shm_tile_magic[8] = { 'O', 'I', 'I', 'O', 's', 'h', 'm', '3' };
+
+}  // namespace
+
+
+
+class SharedTileStore::Segment
+    : public std::enable_shared_from_this<SharedTileStore::Segment> {
+public:
+    Segment(const std::string& name, int fd, char* base, size_t size)
+        : m_name(name)
+        , m_fd(fd)
+        , m_base(base)
+        , m_size(size)
+        , m_header((ShmTileHeader*)base)
+    {
+    }
+    ~Segment()
+    {
+        if (m_index >= 0 && lock()) {
+            // Every pointer we handed out holds on to us, so we hold no
+            // more references by now. Remove the segment if no live
+            // process is attached to it anymore. That's decided, and done,
+            // under the lock, so that a process attaching at the same time
+            // either counts or sees that the segment was removed.
+            m_header->attached[m_index] = 0;
+            entry_lock(m_index, F_UNLCK);
+            reap();
+            bool last = std::all_of(m_header->attached,
+                                    m_header->attached + ShmMaxAttached,
+                                    [](int32_t pid) { return pid == 0; });
+            if (last) {
+                shm_unlink(m_name.c_str());
+                m_header->removed = 1;
+            }
+            unlock();
+        }
+        munmap(m_base, m_size);
+        close(m_fd);
+    }
+
+    // Attach to the segment, creating it if needed.
+    static std::shared_ptr<Segment> open(const std::string& name,
+                                         long long bytes, size_t slot_bytes);
+
+    size_t size() const { return m_size; }
+
+    std::shared_ptr<const char> find(const uint64_t key[2], size_t size);
+    std::shared_ptr<const char> insert(const uint64_t key[2],
+                                       const void* data, size_t size);
+
+private:
+    static size_t slots_offset(uint32_t nbuckets)
+    {
+        return round_to_multiple(round_to_multiple(sizeof(ShmTileHeader), 64)
+                                     + nbuckets * sizeof(int32_t),
+                                 64);
+    }
+    static size_t pixels_offset(uint32_t nslots, uint32_t nbuckets)
+    {
+        return round_to_multiple(slots_offset(nbuckets)
+                                     + nslots * sizeof(ShmTileSlot),
+                                 4096);
+    }
+    // Set up our pointers to the parts of the segment.
+    void setup()
+    {
+        m_buckets = (int32_t*)(m_base
+                               + round_to_multiple(sizeof(ShmTileHeader), 64));
+        m_slots   = (ShmTileSlot*)(m_base + slots_offset(m_header->nbuckets));
+        m_pixels  = m_base
+                   + pixels_offset(m_header->nslots, m_header->nbuckets);
+    }
+    // Lock the segment, repairing it first if the last holder died with
+    // it locked. Return false if it can't be locked at all.
+    bool lock();
+    void unlock() { pthread_mutex_unlock(&m_header->mutex); }
+    // Set (F_WRLCK, without waiting) or clear (F_UNLCK) our lock on the
+    // byte for attachment entry i, or find out if anybody holds it
+    // (F_GETLK). Return true if it's set, cleared, or held, respectively.
+    bool entry_lock(int i, int type);
+    // The rest must be called with the lock held.
+    int32_t& bucket(const uint64_t key[2])
+    {
+        return m_buckets[key[0] & (m_header->nbuckets - 1)];
+    }
+    // Find the slot (Ready, or still being written) with the key.
+    int lookup(const uint64_t key[2], size_t size);
+    int victim();
+    void link(int s)
+    {
+        m_slots[s].next         = bucket(m_slots[s].key);
+        bucket(m_slots[s].key) = s;
+    }
+    void unlink(int s);
+    // Drop the attachments of processes that died, and their references.
+    void reap();
+    // Rebuild the index after a process died holding the lock.
+    void recover();
+    // Count a reference from us to slot s.
+    void ref(int s)
+    {
+        if (m_refs[s]++ == 0)
+            m_slots[s].holders |= uint64_t(1) << m_index;
+        m_slots[s].used = 1;
+    }
+    // Hand out a reference (already counted) to slot s. Call this without
+    // the lock held.
+    std::shared_ptr<const char> share(int s);
+    void unref(int s);
+
+    std::string m_name;
+    int m_fd;
+    char* m_base;
+    size_t m_size;
+    ShmTileHeader* m_header;
+    int32_t* m_buckets    = nullptr;
+    ShmTileSlot* m_slots  = nullptr;
+    char* m_pixels        = nullptr;
+    int m_index           = -1;  // Our entry in m_header->attached
+    std::unique_ptr<int32_t[]> m_refs;  // Our references to each slot
+};
+
+
+
+std::shared_ptr<SharedTileStore::Segment>
+SharedTileStore::Segment::open(const std::string& name, long long bytes,
+                               size_t slot_bytes)
+{
+    slot_bytes       = round_to_multiple(slot_bytes, 64);
+    uint32_t nslots  = uint32_t(std::min(bytes / (long long)slot_bytes,
+                                        (long long)(1 << 30)));
+    uint32_t nbuckets = uint32_t(ceil2(int(std::max(nslots, 1u))));
+    // If the last process detaches and removes the segment while we're
+    // attaching to it, start over with a new one.
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        size_t size  = pixels_offset(nslots, nbuckets) + nslots * slot_bytes;
+        bool created = false;
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+        if (fd >= 0) {
+            created = true;
+            if (!nslots || ftruncate(fd, off_t(size)) != 0) {
+                close(fd);
+                shm_unlink(name.c_str());
+                return nullptr;
+            }
+        } else if (errno == EEXIST) {
+            // Somebody else made it. Wait (a little) for them to size it.
+            fd = shm_open(name.c_str(), O_RDWR, 0);
+            if (fd < 0) {
+                if (errno == ENOENT)
+                    continue;  // Removed already
+                return nullptr;
+            }
+            struct stat st;
+            for (int i = 0; fstat(fd, &st) == 0
+                            && st.st_size < off_t(sizeof(ShmTileHeader));
+                 ++i) {
+                if (i > 1000) {
+                    close(fd);
+                    return nullptr;
+                }
+                Sysutil::usleep(1000);
+            }
+            size = size_t(st.st_size);
+        } else {
+            return nullptr;
+        }
+        void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            if (created)
+                shm_unlink(name.c_str());
+            return nullptr;
+        }
+        auto seg = std::make_shared<Segment>(name, fd, (char*)base, size);
+        ShmTileHeader* h(seg->m_header);
+        if (created) {
+            // A new segment is all zeroes: just fill in the rest.
+            memcpy(h->magic, shm_tile_magic, sizeof(h->magic));
+            h->size       = size;
+            h->slot_bytes = slot_bytes;
+            h->nslots     = nslots;
+            h->nbuckets   = nbuckets;
+            pthread_mutexattr_t attr;
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+            pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+            int err = pthread_mutex_init(&h->mutex, &attr);
+            pthread_mutexattr_destroy(&attr);
+            if (err) {
+                shm_unlink(name.c_str());
+                return nullptr;
+            }
+            seg->setup();
+            std::fill(seg->m_buckets, seg->m_buckets + nbuckets, -1);
+            for (uint32_t s = 0; s < nslots; ++s)
+                seg->m_slots[s].next = -1;
+            h->ready.store(1, std::memory_order_release);
+        } else {
+            for (int i = 0; !h->ready.load(std::memory_order_acquire); ++i) {
+                if (i > 1000)
+                    return nullptr;
+                Sysutil::usleep(1000);
+            }
+            if (memcmp(h->magic, shm_tile_magic, sizeof(h->magic))
+                || h->size != size)
+                return nullptr;
+            seg->setup();
+        }
+        if (!seg->lock())
+            return nullptr;
+        if (h->removed) {
+            seg->unlock();
+            continue;
+        }
+        seg->reap();
+        int index = -1;
+        for (int i = 0; i < ShmMaxAttached && index < 0; ++i)
+            if (!h->attached[i] && seg->entry_lock(i, F_WRLCK))
+                index = i;
+        if (index >= 0)
+            h->attached[index] = int32_t(getpid());
+        seg->unlock();
+        if (index < 0)
+            return nullptr;  // Too many attachments already
+        seg->m_refs.reset(new int32_t[h->nslots]());
+        seg->m_index = index;
+        return seg;
+    }
+    return nullptr;
+}
+
+
+
+bool
+SharedTileStore::Segment::lock()
+{
+    int err = pthread_mutex_lock(&m_header->mutex);
+    if (err == EOWNERDEAD) {
+        recover();
+        err = pthread_mutex_consistent(&m_header->mutex);
+    }
+    return err == 0;
+}
+
+
+
+bool
+SharedTileStore::Segment::entry_lock(int i, int type)
+{
+    // Open file description locks belong to our descriptor, not to the
+    // process, so they also tell apart several caches in one process.
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type   = short(type == F_GETLK ? F_WRLCK : type);
+    fl.l_whence = SEEK_SET;
+    fl.l_start  = i;
+    fl.l_len    = 1;
+    if (fcntl(m_fd, type == F_GETLK ? F_OFD_GETLK : F_OFD_SETLK, &fl) != 0)
+        return false;
+    return type == F_GETLK ? fl.l_type != F_UNLCK : true;
+}
+
+
+
+int
+SharedTileStore::Segment::lookup(const uint64_t key[2], size_t size)
+{
+    for (int s = bucket(key); s >= 0; s = m_slots[s].next) {
+        const ShmTileSlot& slot(m_slots[s]);
+        if (slot.key[0] == key[0] && slot.key[1] == key[1]
+            && slot.size == size)
+            return s;
+    }
+    return -1;
+}
+
+
+
+int
+SharedTileStore::Segment::victim()
+{
+    // Clock sweep: take a free slot, or an unreferenced one that hasn't
+    // been found since the last time the hand passed it. If there's none,
+    // processes that died may be holding some; drop theirs and try again.
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass)
+            reap();
+        for (uint32_t i = 0, n = m_header->nslots; i < 2 * n; ++i) {
+            int s          = int(m_header->hand);
+            m_header->hand = (m_header->hand + 1) % n;
+            ShmTileSlot& slot(m_slots[s]);
+            if (slot.state == ShmSlotFree)
+                return s;
+            if (slot.state != ShmSlotReady || slot.holders)
+                continue;
+            if (slot.used) {
+                slot.used = 0;
+                continue;
+            }
+            unlink(s);
+            slot.state = ShmSlotFree;
+            return s;
+        }
+    }
+    return -1;
+}
+
+
+
+void
+SharedTileStore::Segment::reap()
+{
+    uint64_t dead = 0;
+    for (int i = 0; i < ShmMaxAttached; ++i) {
+        if (m_header->attached[i] && i != m_index && !entry_lock(i, F_GETLK)) {
+            m_header->attached[i] = 0;
+            dead |= uint64_t(1) << i;
+        }
+    }
+    if (!dead)
+        return;
+    for (uint32_t s = 0, n = m_header->nslots; s < n; ++s) {
+        ShmTileSlot& slot(m_slots[s]);
+        slot.holders &= ~dead;
+        // A tile a dead process was still writing will never be finished
+        if (slot.state == ShmSlotWriting && !slot.holders) {
+            unlink(s);
+            slot.state = ShmSlotFree;
+        }
+    }
+}
+
+
+
+void
+SharedTileStore::Segment::recover()
+{
+    // The process that held the lock may have died halfway through
+    // changing a chain, or a slot. Throw away the index, drop the dead
+    // processes' references and unfinished tiles, and index the slots
+    // that are left again.
+    uint32_t n = m_header->nslots;
+    std::fill(m_buckets, m_buckets + m_header->nbuckets, -1);
+    for (uint32_t s = 0; s < n; ++s)
+        m_slots[s].next = -1;
+    m_header->hand %= n;
+    reap();
+    for (uint32_t s = 0; s < n; ++s) {
+        ShmTileSlot& slot(m_slots[s]);
+        if (slot.state > ShmSlotReady || slot.size > m_header->slot_bytes
+            || (slot.state == ShmSlotWriting && !slot.holders))
+            slot.state = ShmSlotFree;
+        if (slot.state != ShmSlotFree)
+            link(int(s));
+    }
+}
+
+
+
+void
+SharedTileStore::Segment::unlink(int s)
+{
+    for (int32_t* p = &bucket(m_slots[s].key); *p >= 0;
+         p = &m_slots[*p].next) {
+        if (*p == s) {
+            *p = m_slots[s].next;
+            break;
+        }
+    }
+    m_slots[s].next = -1;
+}
+
+
+
+std::shared_ptr<const char>
+SharedTileStore::Segment::share(int s)
+{
+    // The pointer keeps the segment mapped, and drops the slot's reference
+    // when the last copy of it goes away.
+    return std::shared_ptr<const char>(
+        m_pixels + size_t(s) * m_header->slot_bytes,
+        [seg = shared_from_this(), s](const char*) { seg->unref(s); });
+}
+
+
+
+void
+SharedTileStore::Segment::unref(int s)
+{
+    if (!lock()) {
+        --m_refs[s];  // Leave the slot held; nothing else we can do
+        return;
+    }
+    if (--m_refs[s] == 0)
+        m_slots[s].holders &= ~(uint64_t(1) << m_index);
+    unlock();
+}
+
+
+
+std::shared_ptr<const char>
+SharedTileStore::Segment::find(const uint64_t key[2], size_t size)
+{
+    if (!lock())
+        return nullptr;
+    int s = lookup(key, size);
+    if (s >= 0 && m_slots[s].state == ShmSlotReady)
+        ref(s);
+    else
+        s = -1;
+    unlock();
+    return s >= 0 ? share(s) : nullptr;
+}
+
+
+
+std::shared_ptr<const char>
+SharedTileStore::Segment::insert(const uint64_t key[2], const void* data,
+                                 size_t size)
+{
+    if (size > m_header->slot_bytes || !lock())
+        return nullptr;
+    // Another thread or process may have beaten us to it. If it's still
+    // writing the tile, let it: the caller just keeps its own copy.
+    int s = lookup(key, size);
+    if (s >= 0) {
+        bool ready = (m_slots[s].state == ShmSlotReady);
+        if (ready)
+            ref(s);
+        unlock();
+        return ready ? share(s) : nullptr;
+    }
+    s = victim();
+    if (s < 0) {
+        unlock();
+        return nullptr;
+    }
+    // Index the slot right away, so that nobody else adds the same tile
+    // while we write it.
+    ShmTileSlot& slot(m_slots[s]);
+    slot.key[0]  = key[0];
+    slot.key[1]  = key[1];
+    slot.size    = size;
+    slot.state   = ShmSlotWriting;
+    slot.holders = 0;
+    link(s);
+    ref(s);
+    unlock();
+    // Copy the pixels without holding the lock; nobody else will touch a
+    // slot that's being written.
+    memcpy(m_pixels + size_t(s) * m_header->slot_bytes, data, size);
+    if (lock()) {
+        slot.state = ShmSlotReady;
+        unlock();
+    }
+    return share(s);
+}
+#else
+// Shared tile store is only implemented on Linux.
+class SharedTileStore::Segment {
+public:
+    static std::shared_ptr<Segment> open(const std::string&, long long,
+                                         size_t)
+    {
+        return nullptr;
+    }
+    size_t size() const { return 0; }
+    std::shared_ptr<const char> find(const uint64_t*, size_t)
+    {
+        return nullptr;
+    }
+    std::shared_ptr<const char> insert(const uint64_t*, const void*, size_t)
+    {
+        return nullptr;
+    }
+};
+#endif
+
+
+
+bool
+SharedTileStore::name(ustring name)
+{
+    std::shared_ptr<Segment> seg;
+    if (name.size())
+        seg = Segment::open(name.string(), m_max_bytes,
+                            size_t(m_tile_bytes) + OIIO_SIMD_MAX_SIZE_BYTES);
+    spin_lock lock(m_mutex);
+    m_segment = seg;
+    m_name    = seg ? name : ustring();
+    m_enabled = bool(seg);
+    return seg || name.empty();
+}
+
+
+
+std::shared_ptr<SharedTileStore::Segment>
+SharedTileStore::segment() const
+{
+    spin_lock lock(m_mutex);
+    return m_segment;
+}
+
+
+
+long long
+SharedTileStore::mem_size() const
+{
+    std::shared_ptr<Segment> seg = segment();
+    return seg ? (long long)seg->size() : 0;
+}
+
+
+
+// Hash a tile key two ways, so that a collision is all but impossible.
+static void
+shared_tile_key(string_view key, uint64_t hash[2])
+{
+    hash[0] = farmhash::Hash64(key.data(), key.size());
+    hash[1] = farmhash::Hash64WithSeed(key.data(), key.size(), 1771);
+}
+
+
+
+std::shared_ptr<const char>
+SharedTileStore::find(string_view key, size_t size)
+{
+    std::shared_ptr<Segment> seg = segment();
+    if (!seg)
+        return nullptr;
+    uint64_t hash[2];
+    shared_tile_key(key, hash);
+    return seg->find(hash, size);
+}
+
+
+
+std::shared_ptr<const char>
+SharedTileStore::insert(string_view key, const void* data, size_t size)
+{
+    std::shared_ptr<Segment> seg = segment();
+    if (!seg)
+        return nullptr;
+    uint64_t hash[2];
+    shared_tile_key(key, hash);
+    return seg->insert(hash, data, size);
+}
+
+
+
+ImageCacheImpl::ImageCacheImpl()
+    : m_perthread_info(&cleanup_perthread_info)
+{
+    init();
+}
+
+
+
+void
+ImageCacheImpl::set_max_open_files(int max_open_files)
+{
+    // Clamp to somewhat less than the maximum number of files allowed
+    // by the system.
+    int m = int(std::min(Sysutil::max_open_files(),
+                         size_t(std::numeric_limits<int>::max())));
+    m     = std::max(10, m - 5 * int(Sysutil::hardware_concurrency()));
+    m_max_open_files = std::min(max_open_files, m);
+    // std::cout << "clamped max_open_files = " << m_max_open_files << "\n";
+}
+
+
+
+void
+ImageCacheImpl::init()
+{
+    set_max_open_files(100);
+    m_max_memory_bytes     = 1024LL * 1024 * 1024;  // 1 GB default cache size
+    m_autotile             = 0;
+    m_autoscanline         = false;
+    m_automip              = false;
+    m_forcefloat           = false;
+    m_accept_untiled       = true;
+    m_accept_unmipped      = true;
+    m_deduplicate          = true;
+    m_unassociatedalpha    = false;
+    m_failure_retries      = 0;
+    m_latlong_y_up_default = true;
+    m_Mw2c.makeIdentity();
+    m_mem_used                = 0;
+    m_statslevel              = 0;
+    m_max_errors_per_file     = 100;
+    m_stat_tiles_created      = 0;
+    m_stat_tiles_current      = 0;
+    m_stat_tiles_peak         = 0;
+    m_stat_open_files_created = 0;
+    m_stat_open_files_current = 0;
+    m_stat_open_files_peak    = 0;
+
+    // Allow environment variable to override default options
+    const char* options = getenv("OPENIMAGEIO_IMAGECACHE_OPTIONS");
+    if (options)
+        attribute("options", options);
+}
+
+
+
+ImageCacheImpl::~ImageCacheImpl()
+{
+    // Let any queued prefetches (and disk cache cleanups) finish before we
+    // tear down the cache, and don't leave the disk cache over its limit.
+    m_prefetch_pool.reset();
+    if (m_disk_tiles.enabled() && m_disk_tiles.over_limit())
+        m_disk_tiles.cleanup();
+    close_trace();
+    if (m_tile_manifest.size())
+        write_tile_manifest(m_tile_manifest);
+    printstats();
+    erase_perthread_info();
+    // Destroy the tiles now, while the eviction shards, memory tallies and
+    // shared pixel stores that their destructors update still exist.
+    std::vector<TileID> tiles_to_delete;
+    for (TileCache::iterator t = m_tilecache.begin(), e = m_tilecache.end();
+         t != e; ++t)
+        tiles_to_delete.push_back(t->second->id());
+    for (const TileID& id : tiles_to_delete)
+        m_tilecache.erase(id);
+    // Close the files while the open-file list they update still exists.
+    for (FilenameMap::iterator f = m_files.begin(); f != m_files.end(); ++f)
+        f->second->close();
+    OIIO_DASSERT(m_open_files.empty());
+}
+
+
+
+void
+ImageCacheImpl::mergestats(ImageCacheStatistics& stats) const
+{
+    stats.init();
+    spin_lock lock(m_perthread_info_mutex);
+    for (size_t i = 0; i < m_all_perthread_info.size(); ++i)
+        stats.merge(m_all_perthread_info[i]->m_stats);
+}
+
+
+
+std::string
+ImageCacheImpl::onefile_stat_line(const ImageCacheFileRef& file, int i,
+                                  bool includestats) const
+{
+    // FIXME -- make meaningful stat printouts for multi-image textures
+    std::ostringstream out;
+    out.imbue(std::locale::classic());  // Force "C" locale with '.' decimal
+    const ImageSpec& spec(file->spec(0, 0));
+    const char* formatcode = "u8";
+    switch (spec.format.basetype) {
+    case TypeDesc::UINT8: formatcode = "u8 "; break;
+    case TypeDesc::INT8: formatcode = "i8 "; break;
+    case TypeDesc::UINT16: formatcode = "u16"; break;
+    case TypeDesc::INT16: formatcode = "i16"; break;
+    case TypeDesc::UINT: formatcode = "u32"; break;
+    case TypeDesc::INT: formatcode = "i32"; break;
+    case TypeDesc::UINT64: formatcode = "i64"; break;
+    case TypeDesc::INT64: formatcode = "u64"; break;
+    case TypeDesc::HALF: formatcode = "f16"; break;
+    case TypeDesc::FLOAT: formatcode = "f32"; break;
+    case TypeDesc::DOUBLE: formatcode = "f64"; break;
+    default: break;
     }
     if (i >= 0)
         out << Strutil::sprintf("%7d ", i);
@@ -1840,11 +3427,38 @@ ImageCacheImpl::getstats(int level) const
         INTOPT(autoscanline);
         INTOPT(automip);
         INTOPT(forcefloat);
+        BOOLOPT(float_as_half);
         INTOPT(accept_untiled);
         INTOPT(accept_unmipped);
         INTOPT(deduplicate);
         INTOPT(unassociatedalpha);
         INTOPT(failure_retries);
+        if (m_missing_file_retry_time > 0.0f)
+            opt += Strutil::sprintf("missing_file_retry_time=%g ",
+                                    m_missing_file_retry_time);
+        INTOPT(prefetch_threads);
+        INTOPT(readers_per_file);
+        BOOLOPT(mmap_tiles);
+        INTOPT(microcache_size);
+        BOOLOPT(compact_constant_tiles);
+        BOOLOPT(skip_constant_tiles);
+        BOOLOPT(deduplicate_tiles);
+        if (m_tile_pool.hugepages())
+            opt += "tile_hugepages ";
+        if (m_compressed_tiles.enabled())
+            opt += Strutil::sprintf("max_compressed_memory_MB=%0.1f ",
+                                    m_compressed_tiles.max_memory()
+                                        / (1024.0 * 1024.0));
+        if (m_disk_tiles.enabled())
+            opt += Strutil::sprintf("disk_cache=\"%s\" max_disk_cache_MB=%0.1f ",
+                                    m_disk_tiles.directory(),
+                                    m_disk_tiles.max_bytes()
+                                        / (1024.0 * 1024.0));
+        if (m_shared_tiles.enabled())
+            opt += Strutil::sprintf("shared_tiles=\"%s\" ",
+                                    m_shared_tiles.name());
+        if (m_cache_policy == CachePolicyClockPro)
+            opt += "tile_cache_policy=\"clockpro\" ";
 #undef BOOLOPT
 #undef INTOPT
 #undef STROPT
@@ -1902,6 +3516,34 @@ ImageCacheImpl::getstats(int level) const
                 << 100.0 * (double)stats.find_tile_microcache_misses
                        / (double)stats.find_tile_calls
                 << "%)\n";
+            if (stats.find_tile_microcache_assoc_hits)
+                out << "      set-associative micro-cache hits : "
+                    << stats.find_tile_microcache_assoc_hits << " ("
+                    << 100.0 * (double)stats.find_tile_microcache_assoc_hits
+                           / (double)stats.find_tile_calls
+                    << "%)\n";
+            // How well the micro-cache does varies by thread, with the
+            // coherence of what each one is doing.
+            std::vector<double> hitrates;
+            {
+                spin_lock lock(m_perthread_info_mutex);
+                for (auto p : m_all_perthread_info) {
+                    if (p && p->m_stats.find_tile_calls)
+                        hitrates.push_back(
+                            1.0
+                            - double(p->m_stats.find_tile_microcache_misses)
+                                  / double(p->m_stats.find_tile_calls));
+                }
+            }
+            if (hitrates.size() > 1) {
+                std::sort(hitrates.begin(), hitrates.end());
+                out << Strutil::sprintf(
+                    "    micro-cache hit rate per thread : min %.1f%%, "
+                    "median %.1f%%, max %.1f%% (%d threads)\n",
+                    100.0 * hitrates.front(),
+                    100.0 * hitrates[hitrates.size() / 2],
+                    100.0 * hitrates.back(), int(hitrates.size()));
+            }
             out << "    main cache misses : " << stats.find_tile_cache_misses
                 << " ("
                 << 100.0 * (double)stats.find_tile_cache_misses
@@ -1910,9 +3552,40 @@ ImageCacheImpl::getstats(int level) const
             out << "    redundant reads: "
                 << (unsigned long long)total_redundant_tiles << " tiles, "
                 << Strutil::memformat(total_redundant_bytes) << "\n";
+            if (stats.prefetch_tiles)
+                out << "    prefetched : " << stats.prefetch_tiles
+                    << " tiles queued, " << stats.prefetch_preempted
+                    << " needed before their read started\n";
+            if (stats.compressed_tiles_stored || stats.compressed_tiles_hits)
+                out << "    compressed tier : " << stats.compressed_tiles_stored
+                    << " tiles stored, " << stats.compressed_tiles_hits
+                    << " promoted, " << stats.compressed_tiles_misses
+                    << " misses, "
+                    << Strutil::memformat(m_compressed_tiles.mem_used())
+                    << " held\n";
+            if (stats.disk_cache_hits || stats.disk_cache_misses)
+                out << "    disk cache : " << stats.disk_cache_hits
+                    << " hits, " << stats.disk_cache_misses << " misses\n";
+            if (stats.shared_tiles_hits || stats.shared_tiles_misses)
+                out << "    shared tile store : " << stats.shared_tiles_hits
+                    << " hits, " << stats.shared_tiles_misses << " misses, "
+                    << Strutil::memformat(m_shared_tiles.mem_size())
+                    << " segment\n";
+            if (stats.mapped_tiles)
+                out << "    memory-mapped : " << stats.mapped_tiles
+                    << " tiles used in place\n";
+            if (stats.constant_tiles)
+                out << "    constant tiles : " << stats.constant_tiles
+                    << " stored as a single pixel\n";
+            if (stats.dedup_tiles)
+                out << "    deduplicated tiles : " << stats.dedup_tiles
+                    << " (" << Strutil::memformat(stats.dedup_bytes_saved)
+                    << " saved)\n";
         }
         out << "    Peak cache memory : " << Strutil::memformat(m_mem_used)
             << "\n";
+        out << "    Resident tile memory : "
+            << Strutil::memformat(m_tile_pool.resident()) << "\n";
         if (stats.tile_locking_time > 0.001)
             out << "    Tile mutex locking time : "
                 << Strutil::timeintervalformat(stats.tile_locking_time) << "\n";
@@ -2127,6 +3800,61 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
         size = std::max(size, 1.0f);  // But let developers debugging do it
 #endif
         m_max_memory_bytes = (long long)(size * (long long)(1024 * 1024));
+    } else if (name == "max_compressed_memory_MB" && type == TypeDesc::FLOAT) {
+        float size = std::max(*(const float*)val, 0.0f);
+        m_compressed_tiles.max_memory(
+            (long long)(size * (long long)(1024 * 1024)));
+    } else if (name == "max_compressed_memory_MB" && type == TypeDesc::INT) {
+        int size = std::max(*(const int*)val, 0);
+        m_compressed_tiles.max_memory((long long)size * (1024 * 1024));
+    } else if (name == "tile_hugepages" && type == TypeDesc::INT) {
+        m_tile_pool.hugepages(*(const int*)val);
+    } else if (name == "deduplicate_tiles" && type == TypeDesc::INT) {
+        m_deduplicate_tiles = *(const int*)val;
+    } else if (name == "compact_constant_tiles" && type == TypeDesc::INT) {
+        m_compact_constant_tiles = *(const int*)val;
+    } else if (name == "skip_constant_tiles" && type == TypeDesc::INT) {
+        m_skip_constant_tiles = *(const int*)val;
+    } else if (name == "microcache_size" && type == TypeDesc::INT) {
+        int n = clamp(*(const int*)val, 0, 256);
+        if (n != m_microcache_size) {
+            m_microcache_size = n;
+            // Each thread resizes its own microcache when it next sees
+            // the purge flag.
+            purge_perthread_microcaches();
+        }
+    } else if (name == "mmap_tiles" && type == TypeDesc::INT) {
+        m_mmap_tiles = *(const int*)val;
+    } else if (name == "disk_cache" && type == TypeDesc::STRING) {
+        m_disk_tiles.directory(ustring(*(const char**)val));
+    } else if (name == "trace_file" && type == TypeDesc::STRING) {
+        std::string tracefile(*(const char**)val);
+        if (tracefile != m_trace.filename()) {
+            close_trace();
+            if (tracefile.size() && !m_trace.open(tracefile))
+                error("Could not open tile trace file \"{}\"", tracefile);
+        }
+    } else if (name == "tile_manifest" && type == TypeDesc::STRING) {
+        m_tile_manifest = std::string(*(const char**)val);
+    } else if (name == "shared_tiles" && type == TypeDesc::STRING) {
+        ustring shmname(*(const char**)val);
+        if (shmname != m_shared_tiles.name()
+            && !m_shared_tiles.name(shmname))
+            error("Could not attach to shared tile store \"{}\"", shmname);
+    } else if (name == "max_shared_memory_MB" && type == TypeDesc::FLOAT) {
+        float size = std::max(*(const float*)val, 0.0f);
+        m_shared_tiles.max_bytes((long long)(size * (long long)(1024 * 1024)));
+    } else if (name == "max_shared_memory_MB" && type == TypeDesc::INT) {
+        int size = std::max(*(const int*)val, 0);
+        m_shared_tiles.max_bytes((long long)size * (1024 * 1024));
+    } else if (name == "shared_tile_bytes" && type == TypeDesc::INT) {
+        m_shared_tiles.tile_bytes(*(const int*)val);
+    } else if (name == "max_disk_cache_MB" && type == TypeDesc::FLOAT) {
+        float size = std::max(*(const float*)val, 0.0f);
+        m_disk_tiles.max_bytes((long long)(size * (long long)(1024 * 1024)));
+    } else if (name == "max_disk_cache_MB" && type == TypeDesc::INT) {
+        int size = std::max(*(const int*)val, 0);
+        m_disk_tiles.max_bytes((long long)size * (1024 * 1024));
     } else if (name == "searchpath" && type == TypeDesc::STRING) {
         std::string s = std::string(*(const char**)val);
         if (s != m_searchpath) {
@@ -2172,6 +3900,12 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
             m_forcefloat  = a;
             do_invalidate = true;
         }
+    } else if (name == "float_as_half" && type == TypeDesc::INT) {
+        bool a = (*(const int*)val != 0);
+        if (a != m_float_as_half) {
+            m_float_as_half = a;
+            do_invalidate   = true;
+        }
     } else if (name == "accept_untiled" && type == TypeDesc::INT) {
         bool a = (*(const int*)val != 0);
         if (a != m_accept_untiled) {
@@ -2198,6 +3932,8 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
         }
     } else if (name == "failure_retries" && type == TypeDesc::INT) {
         m_failure_retries = *(const int*)val;
+    } else if (name == "missing_file_retry_time" && type == TypeFloat) {
+        m_missing_file_retry_time = std::max(0.0f, *(const float*)val);
     } else if (name == "trust_file_extensions" && type == TypeDesc::INT) {
         m_trust_file_extensions = *(const int*)val;
     } else if (name == "latlong_up" && type == TypeDesc::STRING) {
@@ -2212,6 +3948,36 @@ ImageCacheImpl::attribute(string_view name, TypeDesc type, const void* val)
     } else if (name == "max_mip_res" && type == TypeInt) {
         m_max_mip_res = *(const int*)val;
         do_invalidate = true;
+    } else if (name == "tile_cache_policy" && type == TypeDesc::STRING) {
+        string_view policy(*(const char**)val);
+        if (policy == "clockpro") {
+            if (!m_ghost_tiles) {
+                m_ghost_tiles.reset(
+                    new std::atomic<uint64_t>[ghost_tiles_size]);
+                for (size_t i = 0; i < ghost_tiles_size; ++i)
+                    m_ghost_tiles[i] = 0;
+            }
+            m_cache_policy = CachePolicyClockPro;
+        } else if (policy == "clock") {
+            m_cache_policy = CachePolicyClock;
+        } else {
+            error("Unknown tile_cache_policy \"{}\"", policy);
+            return false;
+        }
+    } else if (name == "readers_per_file" && type == TypeInt) {
+        m_readers_per_file = std::max(1, *(const int*)val);
+    } else if (name == "prefetch_threads" && type == TypeInt) {
+        int n = std::max(0, *(const int*)val);
+        std::unique_ptr<thread_pool> oldpool;
+        {
+            std::lock_guard<std::mutex> lock(m_prefetch_pool_mutex);
+            if (n != m_prefetch_threads) {
+                m_prefetch_threads = n;
+                // The pool will be recreated at the new size upon the
+                // next prefetch(); the old one finishes its queue first.
+                oldpool = std::move(m_prefetch_pool);
+            }
+        }
     } else {
         // Otherwise, unknown name
         return false;
@@ -2242,20 +4008,59 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     ATTR_DECODE("autoscanline", int, m_autoscanline);
     ATTR_DECODE("automip", int, m_automip);
     ATTR_DECODE("forcefloat", int, m_forcefloat);
+    ATTR_DECODE("float_as_half", int, m_float_as_half);
     ATTR_DECODE("accept_untiled", int, m_accept_untiled);
     ATTR_DECODE("accept_unmipped", int, m_accept_unmipped);
     ATTR_DECODE("deduplicate", int, m_deduplicate);
     ATTR_DECODE("unassociatedalpha", int, m_unassociatedalpha);
     ATTR_DECODE("trust_file_extensions", int, m_trust_file_extensions);
     ATTR_DECODE("failure_retries", int, m_failure_retries);
+    ATTR_DECODE("missing_file_retry_time", float, m_missing_file_retry_time);
     ATTR_DECODE("total_files", int, m_files.size());
     ATTR_DECODE("max_mip_res", int, m_max_mip_res);
+    ATTR_DECODE("prefetch_threads", int, m_prefetch_threads);
+    ATTR_DECODE("readers_per_file", int, m_readers_per_file);
+    ATTR_DECODE("mmap_tiles", int, m_mmap_tiles);
+    ATTR_DECODE("microcache_size", int, m_microcache_size);
+    ATTR_DECODE("compact_constant_tiles", int, m_compact_constant_tiles);
+    ATTR_DECODE("skip_constant_tiles", int, m_skip_constant_tiles);
+    ATTR_DECODE("deduplicate_tiles", int, m_deduplicate_tiles);
+    ATTR_DECODE("tile_hugepages", int, m_tile_pool.hugepages());
+    ATTR_DECODE("max_compressed_memory_MB", float,
+                m_compressed_tiles.max_memory() / (1024.0 * 1024.0));
+    ATTR_DECODE("max_compressed_memory_MB", int,
+                m_compressed_tiles.max_memory() / (1024 * 1024));
+    ATTR_DECODE("max_shared_memory_MB", float,
+                m_shared_tiles.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("max_shared_memory_MB", int,
+                m_shared_tiles.max_bytes() / (1024 * 1024));
+    ATTR_DECODE("shared_tile_bytes", int, m_shared_tiles.tile_bytes());
+    ATTR_DECODE("max_disk_cache_MB", float,
+                m_disk_tiles.max_bytes() / (1024.0 * 1024.0));
+    ATTR_DECODE("max_disk_cache_MB", int,
+                m_disk_tiles.max_bytes() / (1024 * 1024));
 
     // The cases that don't fit in the simple ATTR_DECODE scheme
     if (name == "searchpath" && type == TypeDesc::STRING) {
         *(ustring*)val = m_searchpath;
         return true;
     }
+    if (name == "disk_cache" && type == TypeDesc::STRING) {
+        *(ustring*)val = m_disk_tiles.directory();
+        return true;
+    }
+    if (name == "trace_file" && type == TypeDesc::STRING) {
+        *(ustring*)val = ustring(m_trace.filename());
+        return true;
+    }
+    if (name == "tile_manifest" && type == TypeDesc::STRING) {
+        *(ustring*)val = ustring(m_tile_manifest);
+        return true;
+    }
+    if (name == "shared_tiles" && type == TypeDesc::STRING) {
+        *(ustring*)val = m_shared_tiles.name();
+        return true;
+    }
     if (name == "plugin_searchpath" && type == TypeDesc::STRING) {
         *(ustring*)val = m_plugin_searchpath;
         return true;
@@ -2274,6 +4079,13 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         *(const char**)val = ustring(m_latlong_y_up_default ? "y" : "z").c_str();
         return true;
     }
+    if (name == "tile_cache_policy" && type == TypeDesc::STRING) {
+        *(const char**)val
+            = ustring(m_cache_policy == CachePolicyClockPro ? "clockpro"
+                                                            : "clock")
+                  .c_str();
+        return true;
+    }
     if (name == "substitute_image" && type == TypeDesc::STRING) {
         *(const char**)val = m_substitute_image.c_str();
         return true;
@@ -2292,6 +4104,10 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
     if (Strutil::starts_with(name, "stat:")) {
         // Stats we can just grab
         ATTR_DECODE("stat:cache_memory_used", long long, m_mem_used);
+        ATTR_DECODE("stat:cache_memory_resident", long long,
+                    m_tile_pool.resident());
+        ATTR_DECODE("stat:compressed_memory_used", long long,
+                    m_compressed_tiles.mem_used());
         ATTR_DECODE("stat:tiles_created", int, m_stat_tiles_created);
         ATTR_DECODE("stat:tiles_current", int, m_stat_tiles_current);
         ATTR_DECODE("stat:tiles_peak", int, m_stat_tiles_peak);
@@ -2306,6 +4122,8 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:find_tile_calls", long long, stats.find_tile_calls);
         ATTR_DECODE("stat:find_tile_microcache_misses", long long,
                     stats.find_tile_microcache_misses);
+        ATTR_DECODE("stat:find_tile_microcache_assoc_hits", long long,
+                    stats.find_tile_microcache_assoc_hits);
         ATTR_DECODE("stat:find_tile_cache_misses", int,
                     stats.find_tile_cache_misses);
         ATTR_DECODE("stat:files_totalsize", long long,
@@ -2320,6 +4138,24 @@ ImageCacheImpl::getattribute(string_view name, TypeDesc type, void* val) const
         ATTR_DECODE("stat:tile_locking_time", float, stats.tile_locking_time);
         ATTR_DECODE("stat:find_file_time", float, stats.find_file_time);
         ATTR_DECODE("stat:find_tile_time", float, stats.find_tile_time);
+        ATTR_DECODE("stat:prefetch_tiles", int, stats.prefetch_tiles);
+        ATTR_DECODE("stat:prefetch_preempted", int, stats.prefetch_preempted);
+        ATTR_DECODE("stat:compressed_tiles_stored", int,
+                    stats.compressed_tiles_stored);
+        ATTR_DECODE("stat:compressed_tiles_hits", int,
+                    stats.compressed_tiles_hits);
+        ATTR_DECODE("stat:compressed_tiles_misses", int,
+                    stats.compressed_tiles_misses);
+        ATTR_DECODE("stat:disk_cache_hits", int, stats.disk_cache_hits);
+        ATTR_DECODE("stat:shared_tiles_hits", int, stats.shared_tiles_hits);
+        ATTR_DECODE("stat:shared_tiles_misses", int,
+                    stats.shared_tiles_misses);
+        ATTR_DECODE("stat:disk_cache_misses", int, stats.disk_cache_misses);
+        ATTR_DECODE("stat:mapped_tiles", int, stats.mapped_tiles);
+        ATTR_DECODE("stat:constant_tiles", int, stats.constant_tiles);
+        ATTR_DECODE("stat:dedup_tiles", int, stats.dedup_tiles);
+        ATTR_DECODE("stat:dedup_bytes_saved", long long,
+                    stats.dedup_bytes_saved);
         ATTR_DECODE("stat:texture_queries", long long, stats.texture_queries);
         ATTR_DECODE("stat:texture3d_queries", long long,
                     stats.texture3d_queries);
@@ -2360,10 +4196,19 @@ ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
             // released the lock (above) before calling wait_pixels_ready,
             // otherwise we could deadlock if another thread reading the
             // pixels needs to lock the cache because it's doing automip.
+            // If the tile was merely queued by prefetch() and nobody has
+            // started reading it yet, don't wait for the prefetch thread
+            // to get to it -- read it ourselves.
+            if (read_unclaimed_tile(tile.get(), thread_info)) {
+                ++stats.prefetch_preempted;
+                check_max_mem(thread_info);
+            }
             tile->wait_pixels_ready();
             tile->use();
             OIIO_DASSERT(id == tile->id());
             OIIO_DASSERT(tile);
+            if (m_trace.enabled())
+                m_trace.record(id, true, thread_info);
             return true;
         }
     }
@@ -2371,6 +4216,8 @@ ImageCacheImpl::find_tile_main_cache(const TileID& id, ImageCacheTileRef& tile,
     // The tile was not found in cache.
 
     ++stats.find_tile_cache_misses;
+    if (m_trace.enabled())
+        m_trace.record(id, false, thread_info);
 
     // Yes, we're creating and reading a tile with no lock -- this is to
     // prevent all the other threads from blocking because of our
@@ -2399,26 +4246,41 @@ ImageCacheImpl::add_tile_to_cache(ImageCacheTileRef& tile,
     // pixels; and if we found the tile in cache, we may need to wait for
     // somebody else to read the pixels.
     if (ourtile) {
-        if (!tile->pixels_ready()) {
-            Timer timer;
-            tile->read(thread_info);
-            double readtime = timer();
-            thread_info->m_stats.fileio_time += readtime;
-            tile->id().file().iotime() += readtime;
-        }
+        read_unclaimed_tile(tile.get(), thread_info);
         check_max_mem(thread_info);
     } else {
         // Somebody else already added the tile to the cache before we
         // could, so we'll use their reference, but we need to wait until it
-        // has read in the pixels.
+        // has read in the pixels (or read them ourselves, if it was only
+        // queued by a prefetch that hasn't started yet).
+        if (read_unclaimed_tile(tile.get(), thread_info)) {
+            ++thread_info->m_stats.prefetch_preempted;
+            check_max_mem(thread_info);
+        }
         tile->wait_pixels_ready();
     }
 }
 
 
 
+bool
+ImageCacheImpl::read_unclaimed_tile(ImageCacheTile* tile,
+                                    ImageCachePerThreadInfo* thread_info)
+{
+    if (tile->pixels_ready() || !tile->claim_read())
+        return false;
+    Timer timer;
+    tile->read(thread_info);
+    double readtime = timer();
+    thread_info->m_stats.fileio_time += readtime;
+    tile->id().file().iotime() += readtime;
+    return true;
+}
+
+
+
 void
-ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
+ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* thread_info)
 {
     OIIO_DASSERT(m_mem_used < (long long)m_max_memory_bytes * 10);  // sanity
 #if 0
@@ -2433,87 +4295,211 @@ ImageCacheImpl::check_max_mem(ImageCachePerThreadInfo* /*thread_info*/)
     if (m_mem_used < (long long)m_max_memory_bytes)
         return;
 
-    // Try to grab the tile_sweep_mutex lock. If somebody else holds it,
-    // just return -- leave the memory limit enforcement to whomever is
-    // already in this function, no need for two threads to do it at
-    // once.  If this means we may ephemerally be over the memory limit
-    // (because another thread adds a tile before we have freed enough
-    // here), so be it.
-    if (!m_tile_sweep_mutex.try_lock())
-        return;
+    // Reclaim memory from the shards of the tile cache that hold more than
+    // their fair share of the budget, visiting them round-robin. Each
+    // shard has its own clock hand and sweep lock, so every thread that
+    // finds the cache over its limit helps out, in a different shard from
+    // the others, and each call does a bounded amount of work (sweeping a
+    // few shards), rather than one thread sweeping the whole cache while
+    // all the others keep allocating. If a shard's sweep lock is taken,
+    // somebody else is already on it, so move along to the next shard.
+    const int max_shards_per_call = 4;
+    const long long fairshare     = (long long)m_max_memory_bytes
+                                / TILE_CACHE_SHARDS;
+    int swept     = 0;
+    bool any_over = false;
+    for (int i = 0; i < TILE_CACHE_SHARDS && swept < max_shards_per_call;
+         ++i) {
+        if (m_mem_used < (long long)m_max_memory_bytes)
+            break;
+        int s = m_tile_shard_hand++ & (TILE_CACHE_SHARDS - 1);
+        TileShard& shard(m_tile_shards[s]);
+        if (shard.mem_used <= fairshare)
+            continue;
+        any_over = true;
+        if (!shard.sweep_mutex.try_lock())
+            continue;
+        sweep_tile_shard(s, fairshare, thread_info);
+        shard.sweep_mutex.unlock();
+        ++swept;
+    }
+
+    // The excess may be spread out so that no shard is over its fair share
+    // (memory charged to a shard for pixels shared with other tiles, say,
+    // or a few shards of hot tiles). Then take it from the largest shard,
+    // all the way down if need be.
+    if (!any_over && m_mem_used >= (long long)m_max_memory_bytes) {
+        int largest = 0;
+        for (int s = 1; s < TILE_CACHE_SHARDS; ++s)
+            if (m_tile_shards[s].mem_used > m_tile_shards[largest].mem_used)
+                largest = s;
+        TileShard& shard(m_tile_shards[largest]);
+        if (shard.mem_used > 0 && shard.sweep_mutex.try_lock()) {
+            sweep_tile_shard(largest, 0, thread_info);
+            shard.sweep_mutex.unlock();
+        }
+    }
+}
 
-    // Now, what we want to do is have a "clock hand" that sweeps across
-    // the cache, releasing tiles that haven't been used for a long
-    // time.  Because of multi-thread, rather than keep an iterator
-    // around for this (which could be invalidated since the last time
-    // we used it), we just remember the tileID of the next tile to
-    // check, then look it up fresh.  That is m_tile_sweep_id.
+
+
+void
+ImageCacheImpl::sweep_tile_shard(int s, long long floor,
+                                 ImageCachePerThreadInfo* thread_info)
+{
+    // The "clock hand" sweeps across the shard, releasing tiles that
+    // haven't been used for a long time.  Because of multi-thread, rather
+    // than keep an iterator around for this (which could be invalidated
+    // since the last time we used it), we just remember the tileID of the
+    // next tile to check, then look it up fresh.  That is the shard's
+    // sweep_id.
+    TileShard& shard(m_tile_shards[s]);
 
     // Get a (locked) iterator for the next tile to be examined.
     TileCache::iterator sweep;
-    if (!m_tile_sweep_id.empty()) {
+    if (!shard.sweep_id.empty()) {
         // We saved the sweep_id. Find the iterator corresponding to it.
-        sweep = m_tilecache.find(m_tile_sweep_id);
+        sweep = m_tilecache.find(shard.sweep_id);
         // Note: if the sweep_id is no longer in the table, sweep will be an
         // empty iterator. That's ok, it will be fixed early in the main
         // loop below.
     }
 
-    // Loop while we still use too much tile memory.  Also, be careful
-    // of looping for too long, exit the loop if we just keep spinning
-    // uncontrollably.
+    // Loop while we still use too much tile memory. The first full pass
+    // over the shard may only clear "used" flags and the second one frees
+    // those tiles, so there's no point going around more than twice.
     int full_loops = 0;
-    while (m_mem_used >= (long long)m_max_memory_bytes && full_loops < 100) {
-        // If we have fallen off the end of the cache, loop back to the
+    while (m_mem_used >= (long long)m_max_memory_bytes
+           && shard.mem_used > floor) {
+        // If we have fallen off the end of the shard, loop back to its
         // beginning and increment our full_loops count.
         if (!sweep) {
-            sweep = m_tilecache.begin();
-            ++full_loops;
+            if (++full_loops > 2)
+                break;
+            sweep.clear();  // incr_no_lock may have left the bin locked
+            sweep = m_tilecache.begin_bin(s);
         }
-        // If we're STILL at the end, it must be that somehow the entire
-        // cache is empty.  So just declare ourselves done.
+        // If we're STILL at the end, the shard must be empty.
         if (!sweep)
             break;
         OIIO_DASSERT(sweep->second);
 
-        if (!sweep->second->release()) {
+        ImageCacheTile* tile = sweep->second.get();
+        bool keep            = (m_cache_policy == CachePolicyClockPro)
+                                   ? clockpro_keep(tile)
+                                   : tile->release();
+        if (!keep) {
             // This is a tile we should delete.  To keep iterating
             // safely, we have a good trick:
             // 1. remember the TileID of the tile to delete
             TileID todelete = sweep->first;
-            size_t size     = sweep->second->memsize();
-            OIIO_DASSERT(m_mem_used >= (long long)size);
-            // 2. Find the TileID of the NEXT item. We do this by
-            // incrementing the sweep iterator and grabbing its id.
-            ++sweep;
-            m_tile_sweep_id = (sweep ? sweep->first : TileID());
+            OIIO_DASSERT(m_mem_used >= (long long)sweep->second->memsize());
+            // (If there's a compressed tier, hold on to the tile so we can
+            // hand its pixels over once the bin is unlocked.)
+            ImageCacheTileRef victim;
+            if (m_compressed_tiles.enabled())
+                victim = sweep->second;
+            // 2. Find the TileID of the NEXT item in this shard.
+            bool more      = sweep.incr_no_lock();
+            shard.sweep_id = (more ? sweep->first : TileID());
             // 3. Release the bin lock and erase the tile we wish to delete.
-            sweep.unlock();
+            sweep.clear();
             m_tilecache.erase(todelete);
+            if (victim) {
+                demote_tile(victim.get(), thread_info);
+                victim.reset();  // Frees the tile (unless still in use)
+            }
             // 4. Re-establish a locked iterator for the next item, since
             // the old iterator may have been invalidated by the erasure.
-            if (!m_tile_sweep_id.empty())
-                sweep = m_tilecache.find(m_tile_sweep_id);
+            if (!shard.sweep_id.empty())
+                sweep = m_tilecache.find(shard.sweep_id);
         } else {
-            ++sweep;
+            sweep.incr_no_lock();
         }
     }
 
-    // OK, by this point we have either freed enough tiles to be below
-    // the limit again, or the cache is empty, or we've looped over the
-    // cache too many times and are giving up.
-
     // Now we must save the tileid for next time.  Just set it to an
     // empty ID if we don't have a valid iterator at this point.
-    m_tile_sweep_id = (sweep ? sweep->first : TileID());
-    m_tile_sweep_mutex.unlock();
+    shard.sweep_id = (sweep ? sweep->first : TileID());
 
-    // N.B. As we exit, the iterators will go out of scope and we will
+    // N.B. As we exit, the iterator will go out of scope and we will
     // retain no locks on the cache.
 }
 
 
 
+void
+ImageCacheImpl::demote_tile(const ImageCacheTile* tile,
+                            ImageCachePerThreadInfo* thread_info)
+{
+    // Only tiles that were read successfully, and not used in place from
+    // a mapped file, are worth keeping. Constant tiles are already as
+    // small as they get.
+    if (!tile->pixels_ready() || !tile->valid() || tile->mapped()
+        || tile->constant())
+        return;
+    if (m_compressed_tiles.store(tile->id(), tile->data(),
+                                 tile->memsize_needed()))
+        ++thread_info->m_stats.compressed_tiles_stored;
+}
+
+
+
+bool
+ImageCacheImpl::clockpro_keep(ImageCacheTile* tile)
+{
+    // Don't really release invalid or unready tiles
+    if (!tile->pixels_ready() || !tile->valid())
+        return true;
+
+    if (tile->hot()) {
+        // Hot tiles are left entirely alone as long as they don't take up
+        // more than their share of the cache -- that's what keeps a big
+        // one-pass scan from flushing them. Beyond that, they get the
+        // usual second chance, and when unused are demoted to cold (but
+        // not yet freed).
+        if (m_hot_mem <= (long long)m_max_memory_bytes * 3 / 4)
+            return true;
+        if (tile->clear_used())
+            return true;
+        tile->hot(false);
+        m_hot_mem -= tile->memsize();
+        return true;
+    }
+
+    // Cold tile: free it unless it was used since we last came by. If it
+    // was used again after surviving an earlier pass of the hand, it's
+    // evidently part of the working set, so promote it to hot.
+    if (!tile->clear_used()) {
+        // Remember that we evicted it, so that if it's soon needed again
+        // it will come back hot.
+        uint64_t h = uint64_t(tile->id().hash()) | 1;
+        m_ghost_tiles[h & (ghost_tiles_size - 1)] = h;
+        return false;
+    }
+    if (tile->tested()) {
+        tile->hot(true);
+        m_hot_mem += tile->memsize();
+    } else {
+        tile->tested(true);
+    }
+    return true;
+}
+
+
+
+bool
+ImageCacheImpl::admit_hot(const TileID& id)
+{
+    if (m_cache_policy != CachePolicyClockPro)
+        return false;
+    uint64_t h = uint64_t(id.hash()) | 1;
+    std::atomic<uint64_t>& ghost(m_ghost_tiles[h & (ghost_tiles_size - 1)]);
+    return ghost.load() == h && ghost.compare_exchange_strong(h, 0);
+}
+
+
+
 std::string
 ImageCacheImpl::resolve_filename(const std::string& filename) const
 {
@@ -3111,8 +5097,9 @@ ImageCacheImpl::get_pixels(ImageCacheFile* file,
                 continue;
             }
             // int ty = y - ((y - spec.y) % spec.tile_height);
-            char* xptr       = yptr;
-            const char* data = NULL;
+            char* xptr           = yptr;
+            const char* data     = NULL;
+            stride_t data_stride = cache_stride;
             for (int x = xbegin; x < xend;
                  ++x, xptr += xstride, ++npixelsread) {
                 if (x < spec.x || x >= (spec.x + spec.width)) {
@@ -3139,8 +5126,10 @@ ImageCacheImpl::get_pixels(ImageCacheFile* file,
                     OIIO_DASSERT(tile);
                     data = (const char*)tile->data(x, y, z, chbegin);
                     OIIO_DASSERT(data);
+                    // All pixels of a constant tile are the one pixel
+                    data_stride = tile->constant() ? 0 : cache_stride;
                 }
-                if (xcontig) {
+                if (xcontig && data_stride) {
                     // Special case for a contiguous span within one tile
                     int spanend   = std::min(tx + spec.tile_width, xend);
                     stride_t span = spanend - x;
@@ -3152,7 +5141,7 @@ ImageCacheImpl::get_pixels(ImageCacheFile* file,
                     // be from a different tile
                 } else {
                     convert_types(cachetype, data, format, xptr, result_nchans);
-                    data += cache_stride;
+                    data += data_stride;
                 }
             }
         }
@@ -3249,9 +5238,16 @@ ImageCacheImpl::tile_pixels(ImageCache::Tile* tile, TypeDesc& format) const
 {
     if (!tile)
         return NULL;
-    ImageCacheTile* t = (ImageCacheTile*)tile;
-    format            = t->file().datatype(t->id().subimage());
-    return t->data();
+    ImageCacheTile* t  = (ImageCacheTile*)tile;
+    format             = t->file().datatype(t->id().subimage());
+    const void* pixels = t->full_data();
+    if (t->constant()) {
+        // Laying out a constant tile in full may have taken a new buffer,
+        // which counts against the memory limit.
+        ImageCacheImpl& imagecache(t->file().imagecache());
+        imagecache.check_max_mem(imagecache.get_perthread_info());
+    }
+    return pixels;
 }
 
 
@@ -3308,6 +5304,445 @@ ImageCacheImpl::add_tile(ustring filename, int subimage, int miplevel, int x,
 
 
 
+bool
+ImageCacheImpl::prefetch(ustring filename, int subimage, int miplevel,
+                         ROI roi, int chbegin, int chend)
+{
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    ImageCacheFile* file                 = find_file(filename, thread_info);
+    if (!file) {
+        error("Image file \"{}\" not found", filename);
+        return false;
+    }
+    return prefetch(file, thread_info, subimage, miplevel, roi, chbegin,
+                    chend);
+}
+
+
+
+bool
+ImageCacheImpl::prefetch(ImageCacheFile* file,
+                         ImageCachePerThreadInfo* thread_info, int subimage,
+                         int miplevel, ROI roi, int chbegin, int chend)
+{
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    file = verify_file(file, thread_info);
+    if (!file || file->broken()) {
+        if (file && file->errors_should_issue())
+            error("Invalid image file \"{}\": {}", file->filename(),
+                  file->broken_error_message());
+        return false;
+    }
+    if (file->is_udim()) {
+        error("Cannot prefetch() a UDIM-like virtual file");
+        return false;
+    }
+    if (subimage < 0 || subimage >= file->subimages()) {
+        if (file->errors_should_issue())
+            error("prefetch asked for nonexistent subimage {} of \"{}\"",
+                  subimage, file->filename());
+        return false;
+    }
+    if (miplevel < 0 || miplevel >= file->miplevels(subimage)) {
+        if (file->errors_should_issue())
+            error("prefetch asked for nonexistent MIP level {} of \"{}\"",
+                  miplevel, file->filename());
+        return false;
+    }
+
+    const ImageSpec& spec(file->spec(subimage, miplevel));
+    ROI datawin = get_roi(spec);
+    roi         = roi.defined() ? roi_intersection(roi, datawin) : datawin;
+    if (roi.xbegin >= roi.xend || roi.ybegin >= roi.yend
+        || roi.zbegin >= roi.zend)
+        return true;  // Nothing to do
+    if (chend < chbegin) {  // chend < chbegin means "all channels."
+        chbegin = 0;
+        chend   = spec.nchannels;
+    }
+
+    // Put a not-yet-read tile in the cache for each one that isn't there
+    // already, so that lookups will find it (and either wait for it or
+    // read it themselves), then hand the reads to the prefetch threads.
+    int tw = spec.tile_width, th = spec.tile_height;
+    int td = std::max(1, spec.tile_depth);
+    std::vector<ImageCacheTileRef> newtiles;
+    for (int z = spec.z + ((roi.zbegin - spec.z) / td) * td; z < roi.zend;
+         z += td) {
+        for (int y = spec.y + ((roi.ybegin - spec.y) / th) * th; y < roi.yend;
+             y += th) {
+            for (int x = spec.x + ((roi.xbegin - spec.x) / tw) * tw;
+                 x < roi.xend; x += tw) {
+                TileID id(*file, subimage, miplevel, x, y, z, chbegin, chend);
+                if (tile_in_cache(id, thread_info))
+                    continue;
+                ImageCacheTileRef tile = new ImageCacheTile(id);
+                if (m_tilecache.insert_retrieve(id, tile, tile))
+                    newtiles.push_back(tile);
+            }
+        }
+    }
+    read_tiles(newtiles, false, thread_info);
+    return true;
+}
+
+
+
+void
+ImageCacheImpl::read_tiles(const std::vector<ImageCacheTileRef>& tiles,
+                           bool wait, ImageCachePerThreadInfo* thread_info)
+{
+    if (tiles.empty())
+        return;
+    thread_info->m_stats.prefetch_tiles += tiles.size();
+    if (wait) {
+        parallel_for(int64_t(0), int64_t(tiles.size()),
+                     [&](int64_t i) { prefetch_tile_task(tiles[i]); });
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_prefetch_pool_mutex);
+        if (m_prefetch_threads > 0) {
+            if (!m_prefetch_pool)
+                m_prefetch_pool.reset(new thread_pool(m_prefetch_threads));
+            for (auto& tile : tiles)
+                m_prefetch_pool->push(
+                    [this, tile](int /*id*/) { prefetch_tile_task(tile); });
+            return;
+        }
+    }
+    // No prefetch threads -- just read the tiles now.
+    for (auto& tile : tiles)
+        prefetch_tile_task(tile);
+}
+
+
+
+void
+ImageCacheImpl::run_in_background(std::function<void()> task)
+{
+    // Use the prefetch threads, or make one just for this if there aren't
+    // any. Either way, the cache waits for the task when it's destroyed.
+    std::lock_guard<std::mutex> lock(m_prefetch_pool_mutex);
+    if (!m_prefetch_pool)
+        m_prefetch_pool.reset(new thread_pool(std::max(1, m_prefetch_threads)));
+    m_prefetch_pool->push([task](int /*id*/) { task(); });
+}
+
+
+
+bool
+ImageCacheImpl::open_files(cspan<ustring> filenames, bool wait)
+{
+    if (!wait) {
+        // Adding the files to the file cache is quick; it's reading their
+        // headers that is worth handing off.
+        ImageCachePerThreadInfo* thread_info = get_perthread_info();
+        std::vector<ImageCacheFileRef> files;
+        files.reserve(filenames.size());
+        for (ustring filename : filenames) {
+            ImageCacheFile* file = find_file(filename, thread_info);
+            if (!file->validspec() && !file->is_udim())
+                files.emplace_back(file);
+        }
+        std::lock_guard<std::mutex> lock(m_prefetch_pool_mutex);
+        if (m_prefetch_threads > 0) {
+            if (!m_prefetch_pool)
+                m_prefetch_pool.reset(new thread_pool(m_prefetch_threads));
+            for (auto& file : files)
+                m_prefetch_pool->push([this, file](int /*id*/) {
+                    verify_file(file.get(), nullptr, true);
+                });
+            return true;
+        }
+    }
+    std::vector<ImageCacheFile*> files(filenames.size());
+    find_files(filenames, files);
+    bool ok = true;
+    for (auto file : files)
+        ok &= !file->broken();
+    return ok;
+}
+
+
+
+void
+ImageCacheImpl::find_files(cspan<ustring> filenames,
+                           span<ImageCacheFile*> files)
+{
+    OIIO_DASSERT(files.size() >= filenames.size());
+    // Each name's searchpath resolution and header read are independent
+    // of the others. Opening a file that another thread is already
+    // opening just waits for it to finish.
+    parallel_for(int64_t(0), int64_t(filenames.size()), [&](int64_t i) {
+        ImageCachePerThreadInfo* thread_info = get_perthread_info();
+        files[i] = find_file(filenames[i], thread_info);
+        verify_file(files[i], thread_info, true);
+    });
+}
+
+
+
+bool
+ImageCacheImpl::get_image_handles(cspan<ustring> filenames,
+                                  span<ImageCacheFile*> handles,
+                                  ImageCachePerThreadInfo* thread_info)
+{
+    OIIO_ASSERT(handles.size() >= filenames.size());
+    if (!thread_info)
+        thread_info = get_perthread_info();
+    find_files(filenames, handles);
+    bool ok = true;
+    for (size_t i = 0, e = filenames.size(); i < e; ++i) {
+        handles[i] = verify_file(handles[i], thread_info);
+        ok &= good(handles[i]);
+    }
+    return ok;
+}
+
+
+
+void
+ImageCacheImpl::prefetch_tile_task(ImageCacheTileRef tile)
+{
+    // A lookup may have needed the tile before we got to it and read it
+    // already -- or be reading it right now, in which case it's theirs.
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    if (read_unclaimed_tile(tile.get(), thread_info))
+        check_max_mem(thread_info);
+}
+
+
+
+bool
+TileTrace::open(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file)
+        fclose(m_file);
+    m_file_index.clear();
+    m_nthreads = 0;
+    m_start    = std::chrono::steady_clock::now();
+    m_file     = Filesystem::fopen(filename, "wb");
+    if (m_file && fwrite(tile_trace_magic, sizeof(tile_trace_magic), 1, m_file)
+                      != 1) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    m_filename = m_file ? filename : std::string();
+    m_enabled  = (m_file != nullptr);
+    return m_enabled;
+}
+
+
+
+void
+TileTrace::close()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_enabled = false;
+    if (m_file)
+        fclose(m_file);
+    m_file = nullptr;
+    m_filename.clear();
+}
+
+
+
+void
+TileTrace::record(const TileID& id, bool hit,
+                  ImageCachePerThreadInfo* thread_info)
+{
+    TileTraceRecord r;
+    r.time = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - m_start)
+                          .count());
+    r.file     = 0;  // Assigned when written out
+    r.subimage = uint16_t(id.subimage());
+    r.miplevel = uint16_t(id.miplevel());
+    r.x        = id.x();
+    r.y        = id.y();
+    r.z        = id.z();
+    r.chbegin  = int16_t(id.chbegin());
+    r.chend    = int16_t(id.chend());
+    r.flags    = hit ? TileTraceHit : 0;
+    bool full;
+    {
+        spin_lock lock(thread_info->trace_mutex);
+        if (thread_info->trace_thread < 0)
+            thread_info->trace_thread = m_nthreads++;
+        r.thread = uint32_t(thread_info->trace_thread);
+        thread_info->trace.emplace_back(id.file().filename(), r);
+        full = thread_info->trace.size() >= 4096;
+    }
+    if (full)
+        flush(thread_info);
+}
+
+
+
+void
+TileTrace::flush(ImageCachePerThreadInfo* thread_info)
+{
+    std::vector<std::pair<ustring, TileTraceRecord>> trace;
+    {
+        spin_lock lock(thread_info->trace_mutex);
+        trace.swap(thread_info->trace);
+    }
+    if (trace.empty())
+        return;
+    std::vector<TileTraceRecord> records;
+    records.reserve(trace.size());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_file)
+        return;
+    for (auto& t : trace) {
+        auto f = m_file_index.find(t.first);
+        if (f == m_file_index.end()) {
+            // First time we see this file: name it before it's used.
+            uint32_t index = uint32_t(m_file_index.size());
+            f              = m_file_index.emplace(t.first, index).first;
+            string_view name(t.first);
+            uint32_t header[3] = { TileTraceFileTag, index,
+                                   uint32_t(name.size()) };
+            fwrite(header, sizeof(header), 1, m_file);
+            fwrite(name.data(), name.size(), 1, m_file);
+        }
+        records.push_back(t.second);
+        records.back().file = f->second;
+    }
+    uint32_t header[2] = { TileTraceTilesTag, uint32_t(records.size()) };
+    fwrite(header, sizeof(header), 1, m_file);
+    fwrite(records.data(), sizeof(TileTraceRecord), records.size(), m_file);
+}
+
+
+
+// First line of a tile manifest, with its format version.
+static const char* tile_manifest_header = "OpenImageIO tile manifest 1";
+
+
+
+bool
+ImageCacheImpl::write_tile_manifest(string_view filename) const
+{
+    // The manifest is a text file: the header line, then for each file,
+    // a "file <name>" line followed by a "level <subimage> <miplevel>
+    // <bits>" line for each of its MIP levels that had tiles read. The
+    // bits are the level's tiles_read bit field, as 64-bit hex words, with
+    // trailing zero words left out.
+    std::vector<ImageCacheFileRef> files;
+    for (FilenameMap::iterator f = m_files.begin(); f != m_files.end(); ++f)
+        files.push_back(f->second);
+    std::sort(files.begin(), files.end(),
+              [](const ImageCacheFileRef& a, const ImageCacheFileRef& b) {
+                  return a->filename() < b->filename();
+              });
+    std::ostringstream out;
+    out << tile_manifest_header << "\n";
+    for (const ImageCacheFileRef& file : files) {
+        if (file->broken() || file->is_udim() || !file->validspec())
+            continue;
+        bool named = false;
+        for (int s = 0, nsub = file->subimages(); s < nsub; ++s) {
+            for (int m = 0, nmip = file->miplevels(s); m < nmip; ++m) {
+                const ImageCacheFile::LevelInfo& lev(file->levelinfo(s, m));
+                int nwords = round_to_multiple(lev.nxtiles * lev.nytiles
+                                                   * lev.nztiles,
+                                               64)
+                             / 64;
+                while (nwords && !lev.tiles_read[nwords - 1])
+                    --nwords;
+                if (!nwords)
+                    continue;
+                if (!named)
+                    out << "file " << file->filename() << "\n";
+                named = true;
+                out << "level " << s << ' ' << m << ' ';
+                for (int w = 0; w < nwords; ++w)
+                    out << Strutil::fmt::format(
+                        "{:016x}", (unsigned long long)lev.tiles_read[w]);
+                out << "\n";
+            }
+        }
+    }
+    if (!Filesystem::write_text_file(filename, out.str())) {
+        error("Could not write tile manifest \"{}\"", filename);
+        return false;
+    }
+    return true;
+}
+
+
+
+bool
+ImageCacheImpl::preload_tile_manifest(string_view filename, bool wait)
+{
+    std::string manifest;
+    if (!Filesystem::read_text_file(filename, manifest)
+        || !Strutil::starts_with(manifest, tile_manifest_header)) {
+        error("Could not read tile manifest \"{}\"", filename);
+        return false;
+    }
+    // Put a not-yet-read tile in the cache for each one listed, as for
+    // prefetch(), then read them all.
+    ImageCachePerThreadInfo* thread_info = get_perthread_info();
+    std::vector<ImageCacheTileRef> newtiles;
+    ImageCacheFile* file = nullptr;
+    bool ok              = true;
+    for (string_view line : Strutil::splitsv(manifest, "\n")) {
+        if (Strutil::parse_prefix(line, "file ")) {
+            file = find_file(ustring(line), thread_info);
+            if (file)
+                file = verify_file(file, thread_info);
+            if (!file || file->broken() || file->is_udim()) {
+                error("Could not preload tiles of \"{}\"", line);
+                file = nullptr;
+                ok   = false;
+            }
+            continue;
+        }
+        int subimage, miplevel;
+        if (!file || !Strutil::parse_prefix(line, "level ")
+            || !Strutil::parse_int(line, subimage)
+            || !Strutil::parse_int(line, miplevel) || subimage < 0
+            || subimage >= file->subimages() || miplevel < 0
+            || miplevel >= file->miplevels(subimage))
+            continue;
+        Strutil::skip_whitespace(line);
+        const ImageCacheFile::LevelInfo& lev(
+            file->levelinfo(subimage, miplevel));
+        const ImageSpec& spec(lev.spec);
+        int ntiles = lev.nxtiles * lev.nytiles * lev.nztiles;
+        for (int w = 0; (w + 1) * 16 <= int(line.size()); ++w) {
+            std::string word(line.substr(w * 16, 16));
+            uint64_t bits = strtoull(word.c_str(), nullptr, 16);
+            for (int b = 0; b < 64 && w * 64 + b < ntiles; ++b) {
+                if (!(bits & (1ULL << b)))
+                    continue;
+                int t = w * 64 + b;
+                int x = spec.x + (t % lev.nxtiles) * spec.tile_width;
+                int y = spec.y + (t / lev.nxtiles) % lev.nytiles
+                                     * spec.tile_height;
+                int z = spec.z + t / (lev.nxtiles * lev.nytiles)
+                                     * std::max(1, spec.tile_depth);
+                TileID id(*file, subimage, miplevel, x, y, z, 0,
+                          spec.nchannels);
+                if (tile_in_cache(id, thread_info))
+                    continue;
+                ImageCacheTileRef tile = new ImageCacheTile(id);
+                if (m_tilecache.insert_retrieve(id, tile, tile))
+                    newtiles.push_back(tile);
+            }
+        }
+    }
+    read_tiles(newtiles, wait, thread_info);
+    return ok;
+}
+
+
+
 void
 ImageCacheImpl::invalidate(ustring filename, bool force)
 {
@@ -3350,6 +5785,8 @@ ImageCacheImpl::invalidate(ImageHandle* handle, bool force)
     // Safely erase all the tiles we found
     for (const TileID& id : tiles_to_delete)
         m_tilecache.erase(id);
+    // ...and any compressed copies of its tiles
+    m_compressed_tiles.erase(file.get());
 
     const ustring fingerprint = file->fingerprint();
 
@@ -3381,6 +5818,7 @@ ImageCacheImpl::invalidate_all(bool force)
         }
         for (const TileID& id : tiles_to_delete)
             m_tilecache.erase(id);
+        m_compressed_tiles.erase();
         // Invalidate (close and clear spec) all individual files
         for (FilenameMap::iterator fileit = m_files.begin(), e = m_files.end();
              fileit != e; ++fileit) {
@@ -3488,10 +5926,11 @@ ImageCacheFile::udim_setup()
 {
     m_udim_nutiles = 0;  // assume it's not a udim at all
     m_udim_nvtiles = 0;
+    ustring filename = this->filename();
 
     // If it's a literal, existing file, always treat it as a regular
     // texture, even if it has what looks like udim pattern markers.
-    if (Filesystem::exists(m_filename)) {
+    if (Filesystem::exists(filename)) {
         return;
     }
 
@@ -3503,13 +5942,13 @@ ImageCacheFile::udim_setup()
     // Note that we use `rcontains()` here for a little extra speed, knowing
     // that these markers will almost always be close to the end of the
     // full pathname.
-    bool udim1   = (Strutil::rcontains(m_filename, "<UDIM>")
-                  || Strutil::rcontains(m_filename, "%(UDIM)d"));
-    bool udim2_0 = (Strutil::rcontains(m_filename, "<u>")
-                    || Strutil::rcontains(m_filename, "<v>")
-                    || Strutil::rcontains(m_filename, "_u##v##"));
-    bool udim2_1 = (Strutil::rcontains(m_filename, "<U>")
-                    || Strutil::rcontains(m_filename, "<V>"));
+    bool udim1   = (Strutil::rcontains(filename, "<UDIM>")
+                  || Strutil::rcontains(filename, "%(UDIM)d"));
+    bool udim2_0 = (Strutil::rcontains(filename, "<u>")
+                    || Strutil::rcontains(filename, "<v>")
+                    || Strutil::rcontains(filename, "_u##v##"));
+    bool udim2_1 = (Strutil::rcontains(filename, "<U>")
+                    || Strutil::rcontains(filename, "<V>"));
     bool udim2   = udim2_0 | udim2_1;
     bool is_udim = udim1 | udim2;
     if (!is_udim)
@@ -3519,10 +5958,10 @@ ImageCacheFile::udim_setup()
     // directory portion of the pattern, and seeing if they match a regex
     // we derive from the non-directory part of the pattern.
     std::vector<std::string> filenames;
-    std::string dirname = Filesystem::parent_path(m_filename);
+    std::string dirname = Filesystem::parent_path(filename);
     if (dirname.empty())
         dirname = ".";
-    std::string pat = udim_to_wildcard(Filesystem::filename(m_filename));
+    std::string pat = udim_to_wildcard(Filesystem::filename(filename));
     Filesystem::get_directory_entries(dirname, filenames, false /*recurse*/,
                                       pat);
 
@@ -3710,6 +6149,8 @@ ImageCacheImpl::destroy_thread_info(ImageCachePerThreadInfo* thread_info)
 {
     if (!thread_info)
         return;
+    if (m_trace.enabled())
+        m_trace.flush(thread_info);
     spin_lock lock(m_perthread_info_mutex);
     for (size_t i = 0; i < m_all_perthread_info.size(); ++i) {
         if (m_all_perthread_info[i] == thread_info) {
@@ -3729,6 +6170,7 @@ ImageCacheImpl::get_perthread_info(ImageCachePerThreadInfo* p)
         p = m_perthread_info.get();
     if (!p) {
         p = new ImageCachePerThreadInfo;
+        p->clear_microcache(m_microcache_size);
         m_perthread_info.reset(p);
         // printf ("New perthread %p\n", (void *)p);
         spin_lock lock(m_perthread_info_mutex);
@@ -3738,9 +6180,8 @@ ImageCacheImpl::get_perthread_info(ImageCachePerThreadInfo* p)
     if (p->purge) {  // has somebody requested a tile purge?
         // This is safe, because it's our thread.
         spin_lock lock(m_perthread_info_mutex);
-        p->tile     = NULL;
-        p->lasttile = NULL;
-        p->purge    = 0;
+        p->clear_microcache(m_microcache_size);
+        p->purge = 0;
         p->m_thread_files.clear();
     }
     return p;
@@ -3756,8 +6197,7 @@ ImageCacheImpl::erase_perthread_info()
         ImageCachePerThreadInfo* p = m_all_perthread_info[i];
         if (p) {
             // Clear the microcache.
-            p->tile     = NULL;
-            p->lasttile = NULL;
+            p->clear_microcache();
             if (p->shared) {
                 // Pointed to by both thread-specific-ptr and our list.
                 // Just remove from out list, then ownership is only
@@ -3780,8 +6220,7 @@ ImageCacheImpl::cleanup_perthread_info(ImageCachePerThreadInfo* p)
     spin_lock lock(m_perthread_info_mutex);
     if (p) {
         // Clear the microcache.
-        p->tile     = NULL;
-        p->lasttile = NULL;
+        p->clear_microcache();
         if (!p->shared)  // If we own it, delete it
             delete p;
         else
@@ -3791,6 +6230,22 @@ ImageCacheImpl::cleanup_perthread_info(ImageCachePerThreadInfo* p)
 
 
 
+void
+ImageCacheImpl::close_trace()
+{
+    if (!m_trace.enabled())
+        return;
+    {
+        spin_lock lock(m_perthread_info_mutex);
+        for (auto p : m_all_perthread_info)
+            if (p)
+                m_trace.flush(p);
+    }
+    m_trace.close();
+}
+
+
+
 void
 ImageCacheImpl::purge_perthread_microcaches()
 {
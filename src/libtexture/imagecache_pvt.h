@@ -10,19 +10,28 @@
 #ifndef OPENIMAGEIO_IMAGECACHE_PVT_H
 #define OPENIMAGEIO_IMAGECACHE_PVT_H
 
+#include <chrono>
+#include <deque>
+#include <map>
+#include <unordered_map>
+
 #include <tsl/robin_map.h>
 
 #include <boost/container/flat_map.hpp>
 #include <boost/thread/tss.hpp>
 
 #include <OpenImageIO/export.h>
+#include <OpenImageIO/fmath.h>
 #include <OpenImageIO/hash.h>
 #include <OpenImageIO/imagebuf.h>
 #include <OpenImageIO/refcnt.h>
 #include <OpenImageIO/texture.h>
+#include <OpenImageIO/thread.h>
 #include <OpenImageIO/timer.h>
 #include <OpenImageIO/unordered_map_concurrent.h>
 
+#include "tiletrace.h"
+
 
 OIIO_NAMESPACE_BEGIN
 
@@ -45,6 +54,7 @@ using boost::thread_specific_ptr;
 
 class ImageCacheImpl;
 class ImageCachePerThreadInfo;
+struct TileID;
 
 const char*
 texture_format_name(TexFormat f);
@@ -62,6 +72,7 @@ struct ImageCacheStatistics {
     // First, the ImageCache-specific fields:
     long long find_tile_calls;
     long long find_tile_microcache_misses;
+    long long find_tile_microcache_assoc_hits;
     int find_tile_cache_misses;
     long long files_totalsize;
     long long files_totalsize_ondisk;
@@ -81,6 +92,19 @@ struct ImageCacheStatistics {
     double tile_locking_time;
     double find_file_time;
     double find_tile_time;
+    long long prefetch_tiles;
+    long long prefetch_preempted;
+    long long compressed_tiles_stored;
+    long long compressed_tiles_hits;
+    long long compressed_tiles_misses;
+    long long disk_cache_hits;
+    long long disk_cache_misses;
+    long long mapped_tiles;
+    long long constant_tiles;
+    long long dedup_tiles;
+    long long shared_tiles_hits;
+    long long shared_tiles_misses;
+    long long dedup_bytes_saved;
 
     // TextureSystem-specific fields below:
     long long texture_queries;
@@ -165,7 +189,12 @@ public:
     {
         return levelinfo(subimage, miplevel).nativespec;
     }
-    ustring filename(void) const { return m_filename; }
+    /// The file's name, as resolved through the searchpath. Safe to call
+    /// from any thread, even while the file is being (re)opened.
+    ustring filename(void) const
+    {
+        return ustring::from_unique(m_filename.load(std::memory_order_acquire));
+    }
     ustring fileformat(void) const { return m_fileformat; }
     TexFormat textureformat() const { return m_texformat; }
     TextureOpt::Wrap swrap() const { return m_swrap; }
@@ -186,11 +215,10 @@ public:
 
     /// Mark the file as recently used.
     ///
-    void use(void) { m_used = true; }
+    void use(void);
 
-    /// Try to release resources for this file -- if recently used, mark
-    /// as not recently used; if already not recently used, close the
-    /// file and return true.
+    /// Close the file to free up its handle, unless it's one that can't
+    /// be reopened. It will be reopened if it's needed again.
     void release(void);
 
     size_t channelsize(int subimage) const
@@ -230,8 +258,33 @@ public:
         m_redundant_bytesread += (long long)bytesread;
     }
 
+    /// Note that the tile has been read into the cache (this is what
+    /// write_tile_manifest() records). Return true if it had been already.
+    bool mark_tile_read(const TileID& id);
+
     std::time_t mod_time() const { return m_mod_time; }
     ustring fingerprint() const { return m_fingerprint; }
+
+    /// The key identifying the decoded pixels of a tile of this file in
+    /// the on-disk tile cache, or an empty string if tiles of this file
+    /// can't be cached on disk (e.g., custom ImageInputs, IOProxy input).
+    std::string disk_cache_key(const TileID& id) const;
+
+    /// For the "mmap_tiles" mode: if the tile's pixels are stored in the
+    /// file exactly as the cache would hold them, map the file into memory
+    /// (if not done already) and return a pointer to the pixels, setting
+    /// mapping to a reference that keeps the mapping alive for as long as
+    /// the pixels are in use. Otherwise, return nullptr.
+    const char* mapped_tile(const TileID& id,
+                            ImageCachePerThreadInfo* thread_info,
+                            std::shared_ptr<const char>& mapping);
+
+    /// If the file's reader knows, without reading it, that the tile has
+    /// the same value in every pixel, store that pixel (the tile's
+    /// channels, in the cache's data type for the subimage) in pixel and
+    /// return true. Otherwise return false.
+    bool constant_tile(const TileID& id, ImageCachePerThreadInfo* thread_info,
+                       void* pixel);
     void duplicate(ImageCacheFile* dup) { m_duplicate = dup; }
     ImageCacheFile* duplicate() const { return m_duplicate; }
 
@@ -344,6 +397,17 @@ public:
     /// Return the error message that explains why the file is broken.
     string_view broken_error_message() const { return m_broken_message; }
 
+    /// Note that opening the file failed, remembering whether that was
+    /// because it doesn't exist.
+    void mark_open_failed();
+
+    /// If the file was broken because it didn't exist, and it's been at
+    /// least `retry_time` seconds since we last looked for it, look again
+    /// (through the searchpath). If it's there now, clear the broken state
+    /// so that it can be opened, and return true. The caller must hold
+    /// m_input_mutex.
+    bool retry_missing(float retry_time);
+
     // For udim only, turn the udim spec filename into a concrete filename
     // for the given u and v tile indices.
     std::string udim_to_concrete(int utile, int vtile);
@@ -353,16 +417,31 @@ public:
 
 private:
     ustring m_filename_original;   ///< original filename before search path
-    ustring m_filename;            ///< Filename
-    bool m_used;                   ///< Recently used (in the LRU sense)
+    // The filename resolved through the searchpath, as the characters of
+    // a ustring. Those never change or go away, so re-resolving the name
+    // just swaps the pointer, and readers don't need a lock.
+    std::atomic<const char*> m_filename { nullptr };
+    atomic_ll m_last_used { 0 };   ///< File open clock when last used
+    int m_open_index = -1;         ///< Index in ImageCacheImpl::m_open_files
     bool m_broken;                 ///< has errors; can't be used properly
     bool m_allow_release = true;   ///< Allow the file to release()?
     std::string m_broken_message;  ///< Error message for why it's broken
+    bool m_missing = false;        ///< Broken because it didn't exist
+    std::chrono::steady_clock::time_point m_missing_time;  ///< Last looked
     std::shared_ptr<ImageInput> m_input;  ///< Open ImageInput, NULL if closed
         // Note that m_input, the shared pointer itself, is NOT safe to
         // access directly. ALWAYS retrieve its value with get_imageinput
         // (it's thread-safe to use that result) and set its value with
         // get_imageinput -- those are guaranteed thread-safe.
+    // Additional open ImageInputs so that several threads can read pixels
+    // from the file concurrently (see lock_reader).
+    std::vector<std::shared_ptr<ImageInput>> m_extra_readers;
+    mutex m_extra_readers_mutex;  ///< Protects m_extra_readers
+    std::shared_ptr<const char> m_mapping;  ///< Whole file mapped in memory
+    size_t m_mapping_size  = 0;             ///< Size of m_mapping
+    bool m_mapping_failed  = false;         ///< Don't try mapping again
+    spin_mutex m_mapping_mutex;             ///< Protects m_mapping*
+    bool m_reports_constant_tiles = false;  ///< Reader finds constant tiles
     std::vector<SubimageInfo> m_subimages;  ///< Info on each subimage
     TexFormat m_texformat;                  ///< Which texture format
     TextureOpt::Wrap m_swrap;               ///< Default wrap modes
@@ -414,6 +493,20 @@ private:
     /// requires no external lock.
     std::shared_ptr<ImageInput> open(ImageCachePerThreadInfo* thread_info);
 
+    /// Retrieve an open ImageInput for reading pixels, already locked for
+    /// the caller's exclusive use (the caller must unlock() it when done).
+    /// If the primary ImageInput is busy, use (or, budget permitting,
+    /// open) one of the extra readers so that several threads may read
+    /// from the file at once; if they are all busy too, wait for the
+    /// primary one. For a broken file, return an empty shared ptr.
+    std::shared_ptr<ImageInput>
+    lock_reader(ImageCachePerThreadInfo* thread_info);
+
+    /// Open an additional ImageInput for the (already opened) file, or
+    /// return an empty shared ptr if that is not possible.
+    std::shared_ptr<ImageInput>
+    open_extra_reader(ImageCachePerThreadInfo* thread_info);
+
     /// Release the ImageInput, if currently open. It will close and destroy
     /// when the last thread holding it is done with its shared ptr. This
     /// is thread-safe, no need to hold a lock to call it. It will close the
@@ -602,8 +695,34 @@ public:
     /// Return pointer to the raw pixel data
     const void* data(void) const { return &m_pixels[0]; }
 
+    /// Are the pixels used in place from memory we don't own (a mapped
+    /// file or the shared tile store)?
+    bool mapped() const
+    {
+        return m_shared_pixels && !m_constant && !m_deduped;
+    }
+
+    /// Are all the pixels of the tile the same? If so, it holds just that
+    /// one pixel (plus the SIMD padding), and is charged only for that
+    /// much memory. Code that indexes the pixels itself, rather than going
+    /// through data(x,y,z,c), must use the first pixel for every pixel of
+    /// a constant tile.
+    bool constant() const { return m_constant; }
+
+    /// Return a pointer to all the pixels of the tile laid out as usual,
+    /// even if it is constant (in which case a buffer of the whole tile
+    /// filled with its pixel is made the first time, and shared with all
+    /// other constant tiles of the same size and value).
+    const void* full_data() const;
+
+    /// Does the tile share its pixel buffer with every other tile of the
+    /// same contents (see TileDedupCache)? If so, the buffer rather than
+    /// the tile is charged for the memory.
+    bool deduped() const { return m_deduped; }
+
     /// Return pointer to the pixel data for a particular pixel.  Be
-    /// extremely sure the pixel is within this tile!
+    /// extremely sure the pixel is within this tile! For a constant tile,
+    /// it's the same pixel for all x, y, z.
     const void* data(int x, int y, int z, int c) const;
 
     /// Return pointer to the floating-point pixel data
@@ -658,6 +777,20 @@ public:
     ///
     int used(void) const { return m_used; }
 
+    /// Clear the used flag, returning whether it was set.
+    bool clear_used() { return m_used.exchange(0) != 0; }
+
+    /// For the "clockpro" cache policy: is the tile in the "hot" set of
+    /// tiles used repeatedly, as opposed to "cold" (used just once, as
+    /// far as we know)?
+    bool hot() const { return m_hot; }
+    void hot(bool h) { m_hot = h; }
+
+    /// For the "clockpro" cache policy: has the clock hand already passed
+    /// over this tile once, so that a subsequent use makes it hot?
+    bool tested() const { return m_tested; }
+    void tested(bool t) { m_tested = t; }
+
     bool valid(void) const { return m_valid; }
 
     /// Are the pixels ready for use?  If false, they're still being
@@ -668,21 +801,44 @@ public:
     ///
     void wait_pixels_ready() const;
 
+    /// Claim the job of reading the pixels. Returns true for exactly one
+    /// caller, which is then responsible for calling read(); everybody
+    /// else should just wait_pixels_ready().
+    bool claim_read()
+    {
+        bool claimed = false;
+        return m_read_claimed.compare_exchange_strong(claimed, true);
+    }
+
     int channelsize() const { return m_channelsize; }
     int pixelsize() const { return m_pixelsize; }
 
+    /// Which shard of the tile cache holds this tile?
+    int shard() const { return m_shard; }
+
 private:
     TileID m_id;                       ///< ID of this tile
+    int m_shard;                       ///< Tile cache shard for the id
     std::unique_ptr<char[]> m_pixels;  ///< The pixel data
+    std::shared_ptr<const char> m_shared_pixels;  ///< Owner of the pixels
+                                                  ///<   if we share them
     size_t m_pixels_size { 0 };        ///< How much m_pixels has allocated
     int m_channelsize { 0 };           ///< How big is each channel (bytes)
     int m_pixelsize { 0 };             ///< How big is each pixel (bytes)
     bool m_valid { false };            ///< Valid pixels
     bool m_nofree { false };  ///< We do NOT own the pixels, do not free!
+    bool m_constant { false };  ///< All pixels are the same
+    bool m_deduped { false };   ///< Pixels shared with identical tiles
+    mutable spin_mutex m_full_mutex;  ///< Protects m_full_pixels
+    // All the pixels of a constant tile, once somebody asked for them
+    mutable std::shared_ptr<const char> m_full_pixels;
     volatile bool m_pixels_ready {
         false
     };                        ///< The pixels have been read from disk
-    atomic_int m_used { 1 };  ///< Used recently
+    std::atomic<bool> m_read_claimed { false };  ///< Somebody is reading
+    atomic_int m_used { 1 };                     ///< Used recently
+    bool m_hot    = false;  ///< In the hot set (clockpro policy only)
+    bool m_tested = false;  ///< Swept once since it was cold
 };
 
 
@@ -701,6 +857,325 @@ typedef unordered_map_concurrent<
     TileCache;
 
 
+
+/// Second tier of the tile cache: pixels of tiles evicted from the main
+/// tile cache, kept zlib-compressed in memory, so that if a tile is
+/// needed again it can be decompressed rather than re-read (and
+/// re-decoded) from disk. Tiles are discarded in the order they were
+/// stored when the compressed data outgrows its memory budget. A budget
+/// of 0 disables the tier. All methods are thread-safe.
+class CompressedTileCache {
+public:
+    /// Set the memory budget (in bytes of compressed data), discarding
+    /// tiles if the cache holds more than that.
+    void max_memory(long long bytes);
+    long long max_memory() const { return m_max_memory; }
+    bool enabled() const { return m_max_memory > 0; }
+
+    /// Memory currently held by compressed tiles.
+    long long mem_used() const { return m_mem_used; }
+
+    /// Compress and store the pixels of the tile, replacing any previous
+    /// version. Return true if the tile was stored.
+    bool store(const TileID& id, const void* data, size_t size);
+
+    /// If the tile is in the cache and its uncompressed pixels are exactly
+    /// size bytes, decompress them into data, remove the tile from the
+    /// cache (it's about to go back into the main cache), and return true.
+    bool fetch(const TileID& id, void* data, size_t size);
+
+    /// Discard all the tiles of the given file, or all tiles in the cache
+    /// if file is nullptr.
+    void erase(const ImageCacheFile* file = nullptr);
+
+private:
+    struct Entry {
+        std::unique_ptr<char[]> data;  ///< The compressed pixels
+        size_t compressed_size = 0;    ///< Bytes of compressed data
+        size_t size            = 0;    ///< Bytes of uncompressed data
+        uint64_t serial        = 0;    ///< Matches our entry in m_order
+    };
+    // Discard the oldest tiles until we're within our budget. The caller
+    // must hold m_mutex.
+    void trim();
+
+    spin_mutex m_mutex;  ///< Guards m_tiles, m_order, m_serial
+    tsl::robin_map<TileID, Entry, TileID::Hasher> m_tiles;
+    // Tiles in the order they were stored, for discarding the oldest. An
+    // entry whose serial doesn't match the tile's current Entry is stale
+    // (the tile was fetched or re-stored since) and is just skipped.
+    std::deque<std::pair<TileID, uint64_t>> m_order;
+    uint64_t m_serial = 0;           ///< Serial number of the next store
+    atomic_ll m_max_memory { 0 };    ///< Budget for compressed data
+    atomic_ll m_mem_used { 0 };      ///< Compressed data being held
+};
+
+
+
+/// Pool allocator for the pixel memory of tiles. Buffers are carved out of
+/// large slabs, one set of slabs per size class (tiles of a cache mostly
+/// come in just a few sizes), and are recycled as tiles are evicted and
+/// new ones read, rather than churning the global allocator with a
+/// malloc/free for every tile. A slab whose buffers are all free is given
+/// back to the system (keeping one spare per size class), so the resident
+/// memory tracks the cache's actual use. Buffers too big to share a slab
+/// are allocated individually. All methods are thread-safe.
+class TilePixelPool {
+public:
+    TilePixelPool() = default;
+    TilePixelPool(const TilePixelPool&) = delete;
+    ~TilePixelPool();
+
+    /// Allocate a buffer of at least size bytes.
+    char* allocate(size_t size);
+
+    /// Return to the pool a buffer from allocate(size).
+    void deallocate(char* buf, size_t size);
+
+    /// Back new slabs with huge pages, if the system supports it?
+    void hugepages(bool on) { m_hugepages = on; }
+    bool hugepages() const { return m_hugepages; }
+
+    /// Bytes of memory obtained from the system, including the free
+    /// buffers held in reserve.
+    long long resident() const { return m_resident; }
+
+    static const size_t slab_size = 2 << 20;  ///< Also the huge page size
+
+private:
+    struct Slab {
+        char* base = nullptr;
+        std::vector<int> free;  ///< Indices of the free buffers
+    };
+    struct SizeClass {
+        size_t bufsize = 0;  ///< Size of each buffer
+        int nbufs      = 0;  ///< Buffers per slab
+        spin_mutex mutex;    ///< Protects slabs and partial
+        std::map<const char*, std::unique_ptr<Slab>> slabs;  ///< By address
+        std::vector<Slab*> partial;  ///< Slabs that have free buffers
+    };
+    SizeClass& size_class(size_t bufsize);
+    char* new_slab();
+    void free_slab(char* base);
+
+    std::vector<std::unique_ptr<SizeClass>> m_classes;
+    spin_rw_mutex m_classes_mutex;  ///< Protects m_classes
+    atomic_ll m_resident { 0 };
+    std::atomic<bool> m_hugepages { false };
+};
+
+
+
+/// Shared whole-tile pixel buffers for constant tiles (those whose pixels
+/// are all the same), for the few callers that need the tile laid out in
+/// full, like ImageCache::tile_pixels(). The tiles themselves only hold
+/// their one pixel; all those of the same size and pixel value that are
+/// asked for their full pixels point to one buffer filled with that value.
+/// Each buffer is charged to the cache's memory once, for as long as it
+/// lives, and is freed when the last tile using it goes away. Thread-safe.
+class ConstantTileCache {
+public:
+    /// Return a tile buffer of size bytes (including the SIMD padding at
+    /// the end, which is zeroed) filled with copies of the pixelsize bytes
+    /// of pixel. A new buffer is allocated from, and charged to, the
+    /// memory of imagecache's shard.
+    std::shared_ptr<const char> get(ImageCacheImpl& imagecache,
+                                    const char* pixel, size_t pixelsize,
+                                    size_t size, int shard);
+
+private:
+    spin_mutex m_mutex;  ///< Protects m_buffers
+    // Buffers by key (the size, then the pixel value). Entries whose
+    // buffers are gone are cleaned out when the map has grown enough.
+    std::unordered_map<std::string, std::weak_ptr<const char>> m_buffers;
+    size_t m_prune_size = 64;  ///< Clean out the map at this size
+};
+
+
+
+/// Pixel buffers shared by tiles with identical contents, found by hashing
+/// the pixels of each tile read. Unlike the file-level "deduplicate", this
+/// catches tiles repeated across otherwise different files (variants,
+/// re-exports, the padding of UDIM tiles). The buffers are owned by the
+/// tiles that use them; the table only remembers them while they live.
+/// Thread-safe.
+class TileDedupCache {
+public:
+    /// If a live buffer with the given hash and the same size bytes of
+    /// pixels as buf is known, return it. Otherwise remember buf for
+    /// future lookups, and return it.
+    std::shared_ptr<const char> share(uint64_t hash,
+                                      const std::shared_ptr<const char>& buf,
+                                      size_t size);
+
+private:
+    struct Entry {
+        std::weak_ptr<const char> buffer;
+        size_t size;
+    };
+    spin_mutex m_mutex;  ///< Protects m_buffers
+    // Buffers by hash of their contents. Entries whose buffers are gone
+    // are cleaned out when the map has grown enough.
+    std::unordered_map<uint64_t, Entry> m_buffers;
+    size_t m_prune_size = 256;  ///< Clean out the map at this size
+};
+
+
+
+/// Persistent on-disk cache of decoded tiles, shared across process runs
+/// (and by processes running at the same time). Each tile is a file in
+/// the cache directory, named for the hash of its key (see
+/// ImageCacheFile::disk_cache_key()) and holding the key itself, so that a
+/// hash collision is detected rather than returning the wrong pixels.
+/// Files are written under a temporary name and renamed into place, so
+/// readers never see a partial tile. When the cache grows past its size
+/// limit, the least recently used tiles (by file modification time, which
+/// is refreshed on every hit) are deleted. All methods are thread-safe.
+class DiskTileCache {
+public:
+    /// Set the cache directory; an empty string disables the cache.
+    void directory(ustring dir);
+    ustring directory() const { return m_dir; }
+    bool enabled() const { return !m_dir.empty(); }
+
+    /// Set the size limit (in bytes) of the cache directory.
+    void max_bytes(long long bytes) { m_max_bytes = std::max(bytes, 0LL); }
+    long long max_bytes() const { return m_max_bytes; }
+
+    /// If the tile with the given key is in the cache and holds exactly
+    /// size bytes, read it into data and return true.
+    bool read(string_view key, void* data, size_t size);
+
+    /// Write the tile with the given key to the cache. Return true if it
+    /// was written.
+    bool write(string_view key, const void* data, size_t size);
+
+    /// Return true if the cache needs a cleanup(): its size isn't known
+    /// yet, or is over the limit. Only one caller is told so until that
+    /// cleanup() is done. Since cleanup() scans the whole directory, the
+    /// caller should run it in the background.
+    bool cleanup_due();
+
+    /// Delete the least recently used tiles until the cache is comfortably
+    /// under its size limit.
+    void cleanup();
+
+    /// Is the cache estimated to be over its size limit?
+    bool over_limit() const { return m_bytes_used > m_max_bytes; }
+
+private:
+    // Path of the tile file for the given key.
+    std::string path(string_view key) const;
+
+    ustring m_dir;                          ///< Cache directory
+    atomic_ll m_max_bytes { 8192LL << 20 };  ///< Size limit
+    atomic_ll m_bytes_used { -1 };  ///< Estimated size (-1 = not known)
+    atomic_ll m_bytes_written { 0 };  ///< Total written by us, ever
+    std::atomic<bool> m_cleanup_due { false };  ///< A cleanup is on its way
+    std::mutex m_cleanup_mutex;     ///< One cleanup at a time
+};
+
+
+/// Tile pixels kept in a named POSIX shared memory segment, so that all
+/// the processes on a host that use the same segment (say, several renders
+/// running at once) share the tiles they read, instead of each holding its
+/// own copy. Tiles are identified as for the DiskTileCache. The segment is
+/// a table of fixed-size slots (sized when the segment is created), a hash
+/// index of them and a robust mutex, all shared by the processes. Each slot
+/// records which of the attached processes hold references to it, and
+/// unreferenced slots are recycled by a "clock" sweep when the segment is
+/// full. The references of processes that died without detaching are
+/// dropped when another one finds them gone, and the index is rebuilt if
+/// one died holding the lock. The segment goes away when the last live
+/// process detaches from it. Only available on Linux.
+class SharedTileStore {
+public:
+    /// Attach to the segment of the given name (such as "/oiio_tiles"),
+    /// creating it if it doesn't exist yet. An empty name detaches from
+    /// the current segment and disables the store. Tiles using the old
+    /// segment keep it mapped until they are freed. Return false if the
+    /// segment couldn't be created or attached to.
+    bool name(ustring name);
+    ustring name() const
+    {
+        spin_lock lock(m_mutex);
+        return m_name;
+    }
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    /// Set the size of the segment, and the size (in bytes) of the pixels
+    /// of the largest tile it can hold. These only take effect if this
+    /// process is the one creating the segment.
+    void max_bytes(long long bytes) { m_max_bytes = std::max(bytes, 0LL); }
+    long long max_bytes() const { return m_max_bytes; }
+    void tile_bytes(long long bytes) { m_tile_bytes = std::max(bytes, 0LL); }
+    long long tile_bytes() const { return m_tile_bytes; }
+
+    /// Size of the segment we're attached to (0 if none).
+    long long mem_size() const;
+
+    /// If the tile with the given key is in the store and holds exactly
+    /// size bytes, return its pixels. The tile stays in the store at least
+    /// as long as the returned pointer (or a copy of it) is around.
+    std::shared_ptr<const char> find(string_view key, size_t size);
+
+    /// Copy size bytes of tile pixels into the store under the given key,
+    /// and return them as find() would. Return an empty pointer if the
+    /// tile is too big for the store's slots, or every slot is in use.
+    std::shared_ptr<const char> insert(string_view key, const void* data,
+                                       size_t size);
+
+    class Segment;
+
+private:
+    std::shared_ptr<Segment> segment() const;
+
+    ustring m_name;                          ///< Segment name
+    std::atomic<bool> m_enabled { false };   ///< Attached to a segment?
+    atomic_ll m_max_bytes { 4096LL << 20 };  ///< Size of a new segment
+    atomic_ll m_tile_bytes { 65536 };        ///< Tile size of a new segment
+    mutable spin_mutex m_mutex;  ///< Protects m_segment and m_name
+    std::shared_ptr<Segment> m_segment;      ///< The attached segment
+};
+
+
+
+/// An optional trace of the tile lookups that reach the main tile cache
+/// (see the "trace_file" attribute and tiletrace.h), to be replayed with
+/// different cache settings by the tilereplay tool. Each thread buffers
+/// its records, which are written out in batches.
+class TileTrace {
+public:
+    ~TileTrace() { close(); }
+
+    /// Start writing a new trace to the named file, ending any previous
+    /// one (whose threads' records must have been flushed already).
+    /// Return false if the file couldn't be opened.
+    bool open(const std::string& filename);
+    /// Finish writing the trace (after flushing all threads' records).
+    void close();
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    const std::string& filename() const { return m_filename; }
+
+    /// Record a lookup of the tile, which was found in the main cache or
+    /// not, in the thread's buffer, writing it out if it's full.
+    void record(const TileID& id, bool hit,
+                ImageCachePerThreadInfo* thread_info);
+    /// Write out the records buffered by the thread.
+    void flush(ImageCachePerThreadInfo* thread_info);
+
+private:
+    std::mutex m_mutex;  ///< Protects everything below, and writing
+    FILE* m_file = nullptr;
+    std::string m_filename;
+    std::atomic<bool> m_enabled { false };
+    std::unordered_map<ustring, uint32_t, ustringHash> m_file_index;
+    std::chrono::steady_clock::time_point m_start;
+    atomic_int m_nthreads { 0 };  ///< Threads that have recorded anything
+};
+
+
+
 /// A very small amount of per-thread data that saves us from locking
 /// the mutex quite as often.  We store things here used by both
 /// ImageCache and TextureSystem, so they don't each need a costly
@@ -718,9 +1193,21 @@ public:
 
     // We have a two-tile "microcache", storing the last two tiles needed.
     ImageCacheTileRef tile, lasttile;
+    // Behind those, a small set-associative cache of the tiles most
+    // recently displaced from them ("microcache_size" tiles in sets of
+    // microcache_ways), to catch lookups that cycle among a few more tiles
+    // (e.g., bicubic or anisotropic filters near tile corners).
+    std::vector<ImageCacheTileRef> microcache;
+    static const int microcache_ways = 2;
     atomic_int purge;  // If set, tile ptrs need purging!
     ImageCacheStatistics m_stats;
     bool shared = false;  // Pointed to by the IC and thread_specific_ptr
+    // Records for the tile trace (with the names of the files they refer
+    // to, which unlike the files themselves can't go away before the
+    // records are written out), waiting to be written out.
+    spin_mutex trace_mutex;
+    std::vector<std::pair<ustring, TileTraceRecord>> trace;
+    int trace_thread = -1;  // Thread number in the trace
 
     ImageCachePerThreadInfo()
     {
@@ -745,6 +1232,56 @@ public:
         auto f = m_thread_files.find(n);
         return f == m_thread_files.end() ? nullptr : f->second;
     }
+
+    // Clear all the tile refs of the microcache, and size the
+    // set-associative part to hold n tiles (rounded up to a whole number
+    // of sets, which must be a power of 2).
+    void clear_microcache(int n = -1)
+    {
+        tile     = nullptr;
+        lasttile = nullptr;
+        if (n >= 0) {
+            int nsets = n ? (int)ceil2((n + microcache_ways - 1)
+                                       / microcache_ways)
+                          : 0;
+            microcache.resize(size_t(nsets * microcache_ways));
+        }
+        for (auto& t : microcache)
+            t = nullptr;
+    }
+
+    // Look up id in the set-associative microcache. If it's there, move
+    // it into t and return true.
+    bool microcache_take(const TileID& id, ImageCacheTileRef& t)
+    {
+        ImageCacheTileRef* set = microcache_set(id);
+        for (int w = 0; w < microcache_ways; ++w) {
+            if (set[w] && set[w]->id() == id) {
+                t.swap(set[w]);
+                set[w] = nullptr;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Move t into its set of the set-associative microcache, as the most
+    // recent entry, dropping the oldest one of the set.
+    void microcache_put(ImageCacheTileRef& t)
+    {
+        ImageCacheTileRef* set = microcache_set(t->id());
+        for (int w = microcache_ways - 1; w > 0; --w)
+            set[w].swap(set[w - 1]);
+        set[0].swap(t);
+        t = nullptr;
+    }
+
+private:
+    ImageCacheTileRef* microcache_set(const TileID& id)
+    {
+        size_t nsets = microcache.size() / microcache_ways;
+        return &microcache[(id.hash() & (nsets - 1)) * microcache_ways];
+    }
 };
 
 
@@ -818,6 +1355,7 @@ public:
     bool autoscanline() const { return m_autoscanline; }
     bool automip() const { return m_automip; }
     bool forcefloat() const { return m_forcefloat; }
+    bool float_as_half() const { return m_float_as_half; }
     bool accept_untiled() const { return m_accept_untiled; }
     bool accept_unmipped() const { return m_accept_unmipped; }
     bool unassociatedalpha() const { return m_unassociatedalpha; }
@@ -832,6 +1370,16 @@ public:
     // Set m_max_open_files, with logic to try to clamp reasonably.
     void set_max_open_files(int m);
 
+    /// Add the file to, or remove it from, the list of files with an open
+    /// ImageInput (from which check_max_files closes the least recently
+    /// used), to match whether it has one now.
+    void update_open_file(ImageCacheFile* file);
+
+    /// The file open clock: the number of times any file has been opened.
+    /// A file's last use at an earlier time than another's is a use
+    /// longer ago.
+    long long file_open_clock() const { return m_file_open_clock; }
+
     /// Get information about the given image.
     ///
     virtual bool get_image_info(ustring filename, int subimage, int miplevel,
@@ -928,6 +1476,11 @@ public:
                                 ImageCachePerThreadInfo* thread_info,
                                 bool header_only = false);
 
+    /// Find (adding if needed) the files of all the given names, and open
+    /// them, in parallel. Set files[i] to the ImageCacheFile of
+    /// filenames[i], as find_file would, before any switch to a duplicate.
+    void find_files(cspan<ustring> filenames, span<ImageCacheFile*> files);
+
     virtual ImageCacheFile*
     get_image_handle(ustring filename,
                      ImageCachePerThreadInfo* thread_info = NULL)
@@ -938,6 +1491,10 @@ public:
         return verify_file(file, thread_info);
     }
 
+    virtual bool get_image_handles(cspan<ustring> filenames,
+                                   span<ImageCacheFile*> handles,
+                                   ImageCachePerThreadInfo* thread_info);
+
     virtual bool good(ImageCacheFile* handle)
     {
         return handle && !handle->broken();
@@ -988,6 +1545,21 @@ public:
                 tile->use();
                 return true;
             }
+            // Still no match. Before going to the main cache, try the
+            // set-associative part of the microcache, which also takes
+            // the tile we're about to displace.
+            if (thread_info->microcache.size()) {
+                ImageCacheTileRef displaced;
+                displaced.swap(tile);
+                bool found = thread_info->microcache_take(id, tile);
+                if (displaced)
+                    thread_info->microcache_put(displaced);
+                if (found) {
+                    ++thread_info->m_stats.find_tile_microcache_assoc_hits;
+                    tile->use();
+                    return true;
+                }
+            }
         }
         return find_tile_main_cache(id, tile, thread_info);
         // N.B. find_tile_main_cache marks the tile as used
@@ -1008,6 +1580,14 @@ public:
                           int y, int z, int chbegin, int chend, TypeDesc format,
                           const void* buffer, stride_t xstride,
                           stride_t ystride, stride_t zstride, bool copy);
+    virtual bool prefetch(ustring filename, int subimage, int miplevel,
+                          ROI roi, int chbegin, int chend);
+    virtual bool prefetch(ImageHandle* file, Perthread* thread_info,
+                          int subimage, int miplevel, ROI roi, int chbegin,
+                          int chend);
+    virtual bool write_tile_manifest(string_view filename) const;
+    virtual bool preload_tile_manifest(string_view filename, bool wait);
+    virtual bool open_files(cspan<ustring> filenames, bool wait);
 
     /// Return the numerical subimage index for the given subimage name,
     /// as stored in the "oiio:subimagename" metadata.  Return -1 if no
@@ -1044,26 +1624,58 @@ public:
 
     /// Called when a new tile is created, to update all the stats.
     ///
-    void incr_tiles(size_t size)
+    void incr_tiles(size_t size, int shard, bool hot)
     {
         ++m_stat_tiles_created;
         atomic_max(m_stat_tiles_peak, ++m_stat_tiles_current);
-        m_mem_used += size;
+        incr_mem(size, shard, hot);
     }
 
     /// Called when a tile's pixel memory is allocated, but a new tile
     /// is not created.
-    void incr_mem(size_t size) { m_mem_used += size; }
+    void incr_mem(size_t size, int shard, bool hot)
+    {
+        m_mem_used += size;
+        m_tile_shards[shard].mem_used += size;
+        if (hot)
+            m_hot_mem += size;
+    }
+
+    /// Called when tile pixel memory is freed, but no tile is destroyed.
+    void decr_mem(size_t size, int shard)
+    {
+        m_mem_used -= size;
+        m_tile_shards[shard].mem_used -= size;
+        OIIO_DASSERT(m_mem_used >= 0);
+    }
 
     /// Called when a tile is destroyed, to update all the stats.
     ///
-    void decr_tiles(size_t size)
+    void decr_tiles(size_t size, int shard, bool hot)
     {
         --m_stat_tiles_current;
         m_mem_used -= size;
+        m_tile_shards[shard].mem_used -= size;
+        if (hot)
+            m_hot_mem -= size;
         OIIO_DASSERT(m_mem_used >= 0);
     }
 
+    /// Tile eviction policies.
+    enum CachePolicy {
+        CachePolicyClock,    ///< Plain "clock" (second chance)
+        CachePolicyClockPro  ///< Scan-resistant, CLOCK-Pro-like hot/cold
+    };
+
+    /// Should a tile with this id, about to be created, start out hot?
+    /// With the clockpro policy, that's the case if it was recently
+    /// evicted (it's being reused, just not quite often enough to have
+    /// survived in the cold set).
+    bool admit_hot(const TileID& id);
+
+    /// Which shard of the tile cache does the tile id belong to?
+    int tile_shard(const TileID& id) { return int(m_tilecache.bin_of(id)); }
+
     /// Internal error reporting routine, with std::format-like arguments.
     template<typename... Args>
     void error(const char* fmt, const Args&... args) const
@@ -1100,6 +1712,51 @@ public:
     void check_max_files(ImageCachePerThreadInfo* thread_info);
 
     int max_mip_res() const noexcept { return m_max_mip_res; }
+    int readers_per_file() const noexcept { return m_readers_per_file; }
+    bool mmap_tiles() const noexcept { return m_mmap_tiles; }
+    int microcache_size() const noexcept { return m_microcache_size; }
+
+    /// Is there room under max_open_files to open another file handle
+    /// without having to close any?
+    bool open_files_headroom() const
+    {
+        return m_stat_open_files_current < m_max_open_files;
+    }
+
+    /// The second-tier cache of compressed tiles evicted from the main
+    /// tile cache.
+    CompressedTileCache& compressed_tiles() { return m_compressed_tiles; }
+
+    /// The persistent on-disk cache of decoded tiles.
+    DiskTileCache& disk_tiles() { return m_disk_tiles; }
+
+    /// Run the task on a background thread (one of the prefetch threads)
+    /// and return without waiting for it.
+    void run_in_background(std::function<void()> task);
+
+    /// The cross-process shared memory tile store.
+    SharedTileStore& shared_tiles() { return m_shared_tiles; }
+
+    /// The allocator for tile pixel memory.
+    TilePixelPool& tile_pool() { return m_tile_pool; }
+
+    /// The shared buffers for constant tiles.
+    ConstantTileCache& constant_tiles() { return m_constant_tiles; }
+    bool compact_constant_tiles() const noexcept
+    {
+        return m_compact_constant_tiles;
+    }
+    bool skip_constant_tiles() const noexcept { return m_skip_constant_tiles; }
+
+    /// The shared buffers of tiles with identical contents.
+    TileDedupCache& dedup_tiles() { return m_dedup_tiles; }
+    bool deduplicate_tiles() const noexcept { return m_deduplicate_tiles; }
+
+    /// Make a shared buffer of the size bytes of tile pixels (allocated
+    /// from the tile pool), taking them over. The buffer is charged to the
+    /// cache (to the given shard) for as long as it lives.
+    std::shared_ptr<const char> share_tile_pixels(char* pixels, size_t size,
+                                                  int shard);
 
 private:
     void init();
@@ -1113,6 +1770,39 @@ private:
     /// Enforce the max memory for tile data.
     void check_max_mem(ImageCachePerThreadInfo* thread_info);
 
+    /// Clockpro policy: decide the fate of a tile the clock hand is
+    /// passing over, possibly moving it between the hot and cold sets.
+    /// Return true if the tile should be kept, false to evict it.
+    bool clockpro_keep(ImageCacheTile* tile);
+
+    /// Run the clock hand of one tile cache shard, freeing unused tiles
+    /// until the cache is under its memory limit, the shard is down to
+    /// floor bytes, or we've made two full passes over the shard. The
+    /// caller must hold the shard's sweep_mutex. Freed tiles are handed
+    /// to the compressed tier, if it's enabled.
+    void sweep_tile_shard(int shard, long long floor,
+                          ImageCachePerThreadInfo* thread_info);
+
+    /// Pass the pixels of a tile that is being evicted from the main tile
+    /// cache on to the compressed tier.
+    void demote_tile(const ImageCacheTile* tile,
+                     ImageCachePerThreadInfo* thread_info);
+
+    /// If nobody has started reading the tile's pixels yet (for example,
+    /// it was queued by prefetch() but not yet serviced), read them now
+    /// with the calling thread. Return true if we did the read.
+    bool read_unclaimed_tile(ImageCacheTile* tile,
+                             ImageCachePerThreadInfo* thread_info);
+
+    /// Background task that reads a tile queued by prefetch().
+    void prefetch_tile_task(ImageCacheTileRef tile);
+
+    /// Read the (not yet read) tiles, which are already in the tile cache:
+    /// hand them to the prefetch threads and return, or if wait is true,
+    /// read them in parallel and return when they're all done.
+    void read_tiles(const std::vector<ImageCacheTileRef>& tiles, bool wait,
+                    ImageCachePerThreadInfo* thread_info);
+
     /// Internal statistics printing routine
     ///
     void printstats() const;
@@ -1133,6 +1823,9 @@ private:
     /// Clear all the per-thread microcaches.
     void purge_perthread_microcaches();
 
+    /// Write out all threads' buffered trace records, and end the trace.
+    void close_trace();
+
     /// Clear the fingerprint list, thread-safe.
     void clear_fingerprints();
 
@@ -1148,6 +1841,7 @@ private:
     bool m_autoscanline;       ///< autotile using full width tiles
     bool m_automip;            ///< auto-mipmap on demand?
     bool m_forcefloat;         ///< force all cache tiles to be float
+    bool m_float_as_half = false;  ///< cache float images as half
     bool m_accept_untiled;     ///< Accept untiled images?
     bool m_accept_unmipped;    ///< Accept unmipped images?
     bool m_deduplicate;        ///< Detect duplicate files?
@@ -1155,21 +1849,60 @@ private:
     bool m_latlong_y_up_default;  ///< Is +y the default "up" for latlong?
     bool m_trust_file_extensions = false;  ///< Assume file extensions don't lie?
     int m_failure_retries;                 ///< Times to re-try disk failures
+    float m_missing_file_retry_time = 0.0f;  ///< Secs before re-seeking files
     int m_max_mip_res = 1 << 30;  ///< Don't use MIP levels higher than this
+    int m_prefetch_threads = 4;   ///< Threads for servicing prefetch()
+    int m_readers_per_file = 1;   ///< Max open ImageInputs for each file
+    bool m_mmap_tiles      = false;  ///< Use pixels in place when we can
+    int m_microcache_size  = 8;  ///< Per-thread set-associative tiles
+    bool m_compact_constant_tiles = false;  ///< Share constant tiles' pixels
+    bool m_skip_constant_tiles = true;  ///< Don't read tiles known constant
+    bool m_deduplicate_tiles = false;  ///< Share identical tiles' pixels
+    std::string m_tile_manifest;  ///< Write a tile manifest here at the end
+    TileTrace m_trace;            ///< Trace of tile lookups
     Imath::M44f m_Mw2c;           ///< world-to-"common" matrix
     Imath::M44f m_Mc2w;           ///< common-to-world matrix
     ustring m_substitute_image;   ///< Substitute this image for all others
 
+    // The open-file list is declared before m_files so that it outlives
+    // the files, whose close() updates it.
+    std::mutex m_open_files_mutex;  ///< Guards m_open_files
+    std::vector<ImageCacheFile*> m_open_files;  ///< Files with an ImageInput
+    atomic_ll m_file_open_clock { 0 };  ///< Counts opens, to order file use
     mutable FilenameMap m_files;    ///< Map file names to ImageCacheFile's
-    ustring m_file_sweep_name;      ///< Sweeper for "clock" paging algorithm
     spin_mutex m_file_sweep_mutex;  ///< Ensure only one in check_max_files
 
     spin_mutex m_fingerprints_mutex;  ///< Protect m_fingerprints
     FingerprintMap m_fingerprints;    ///< Map fingerprints to files
 
-    TileCache m_tilecache;          ///< Our in-memory tile cache
-    TileID m_tile_sweep_id;         ///< Sweeper for "clock" paging algorithm
-    spin_mutex m_tile_sweep_mutex;  ///< Ensure only one in check_max_mem
+    // Eviction state for each shard (bin) of m_tilecache. Every shard has
+    // its own "clock" paging hand and tally of tile memory, so that
+    // threads over the memory limit can reclaim from different shards at
+    // the same time. Declared before m_tilecache so that it outlives the
+    // tiles, whose destructors update it.
+    struct TileShard {
+        OIIO_CACHE_ALIGN spin_mutex sweep_mutex;  ///< One sweeper at a time
+        TileID sweep_id;            ///< Clock hand: next tile to examine
+        atomic_ll mem_used { 0 };   ///< Memory used by this shard's tiles
+    };
+    TileShard m_tile_shards[TILE_CACHE_SHARDS];
+    atomic_int m_tile_shard_hand { 0 };  ///< Next shard to reclaim from
+
+    TilePixelPool m_tile_pool;  ///< Tile pixel memory (outlives the tiles)
+    TileCache m_tilecache;      ///< Our in-memory tile cache
+
+    int m_cache_policy = CachePolicyClock;  ///< Tile eviction policy
+    atomic_ll m_hot_mem { 0 };  ///< Clockpro: memory used by hot tiles
+    // Clockpro: hashes of recently evicted cold tiles, direct mapped (so
+    // an entry is forgotten when another hash lands in its slot).
+    std::unique_ptr<std::atomic<uint64_t>[]> m_ghost_tiles;
+    static const size_t ghost_tiles_size = 16384;
+
+    CompressedTileCache m_compressed_tiles;  ///< Tiles evicted from RAM
+    DiskTileCache m_disk_tiles;              ///< Tiles kept across runs
+    SharedTileStore m_shared_tiles;          ///< Tiles shared by processes
+    ConstantTileCache m_constant_tiles;      ///< Buffers of constant tiles
+    TileDedupCache m_dedup_tiles;            ///< Buffers of identical tiles
 
     atomic_ll m_mem_used;       ///< Memory being used for tiles
     int m_statslevel;           ///< Statistics level
@@ -1179,6 +1912,9 @@ private:
     ///
     mutable thread_specific_ptr<std::string> m_errormessage;
 
+    std::unique_ptr<thread_pool> m_prefetch_pool;  ///< Services prefetch()
+    std::mutex m_prefetch_pool_mutex;  ///< Guards creation of the pool
+
     // For debugging -- keep track of who holds the tile and file mutex
 
 private:
@@ -1214,6 +1950,18 @@ private:
 
 
 
+inline void
+ImageCacheFile::use()
+{
+    // Only write when it changes, so that the many lookups of a popular
+    // file don't keep dirtying its cache line.
+    long long now = imagecache().file_open_clock();
+    if (m_last_used.load(std::memory_order_relaxed) != now)
+        m_last_used.store(now, std::memory_order_relaxed);
+}
+
+
+
 }  // end namespace pvt
 
 OIIO_NAMESPACE_END
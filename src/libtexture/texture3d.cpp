@@ -283,6 +283,7 @@ TextureSystemImpl::texture3d_lookup_nomip(
         &TextureSystemImpl::accum3d_sample_bilinear,
         &TextureSystemImpl::accum3d_sample_bilinear,  // FIXME: bicubic,
         &TextureSystemImpl::accum3d_sample_bilinear,
+        &TextureSystemImpl::accum3d_sample_bilinear,  // not stochastic in 3D
     };
     accum3d_prototype accumer = accum_functions[(int)options.interpmode];
     bool ok = (this->*accumer)(P, 0, texturefile, thread_info, options,
@@ -298,6 +299,7 @@ TextureSystemImpl::texture3d_lookup_nomip(
     case TextureOpt::InterpBilinear: ++stats.bilinear_interps; break;
     case TextureOpt::InterpBicubic: ++stats.cubic_interps; break;
     case TextureOpt::InterpSmartBicubic: ++stats.bilinear_interps; break;
+    case TextureOpt::InterpStochasticBilinear: ++stats.bilinear_interps; break;
     }
     return ok;
 }
@@ -362,7 +364,9 @@ TextureSystemImpl::accum3d_sample_closest(
     int tilepel = (tile_r * spec.tile_height + tile_t) * spec.tile_width
                   + tile_s;
     int startchan_in_tile = options.firstchannel - id.chbegin();
-    int offset            = spec.nchannels * tilepel + startchan_in_tile;
+    int offset            = startchan_in_tile;
+    if (!tile->constant())  // A constant tile holds just its one pixel
+        offset += spec.nchannels * tilepel;
     OIIO_DASSERT((size_t)offset < spec.nchannels * spec.tile_pixels());
     if (pixeltype == TypeDesc::UINT8) {
         const unsigned char* texel = tile->bytedata() + offset;
@@ -508,23 +512,34 @@ TextureSystemImpl::accum3d_sample_bilinear(
         TileRef& tile(thread_info->tile);
         if (!tile->valid())
             return false;
-        size_t tilepel = (tile_r * spec.tile_height + tile_t) * spec.tile_width
-                         + tile_s;
-        size_t offset = (spec.nchannels * tilepel + startchan_in_tile)
-                        * channelsize;
-        OIIO_DASSERT((size_t)offset < spec.tile_width * spec.tile_height
-                                          * spec.tile_depth * pixelsize);
-
-        const unsigned char* b = tile->bytedata() + offset;
-        texel[0][0][0]         = b;
-        texel[0][0][1]         = b + pixelsize;
-        texel[0][1][0]         = b + pixelsize * spec.tile_width;
-        texel[0][1][1]         = b + pixelsize * spec.tile_width + pixelsize;
-        b += pixelsize * spec.tile_width * spec.tile_height;
-        texel[1][0][0] = b;
-        texel[1][0][1] = b + pixelsize;
-        texel[1][1][0] = b + pixelsize * spec.tile_width;
-        texel[1][1][1] = b + pixelsize * spec.tile_width + pixelsize;
+        if (tile->constant()) {
+            // All eight texels are the tile's one pixel
+            const unsigned char* b = tile->bytedata()
+                                     + startchan_in_tile * channelsize;
+            for (int k = 0; k < 2; ++k)
+                for (int j = 0; j < 2; ++j)
+                    for (int i = 0; i < 2; ++i)
+                        texel[k][j][i] = b;
+        } else {
+            size_t tilepel = (tile_r * spec.tile_height + tile_t)
+                                 * spec.tile_width
+                             + tile_s;
+            size_t offset = (spec.nchannels * tilepel + startchan_in_tile)
+                            * channelsize;
+            OIIO_DASSERT((size_t)offset < spec.tile_width * spec.tile_height
+                                              * spec.tile_depth * pixelsize);
+
+            const unsigned char* b = tile->bytedata() + offset;
+            texel[0][0][0]         = b;
+            texel[0][0][1]         = b + pixelsize;
+            texel[0][1][0]         = b + pixelsize * spec.tile_width;
+            texel[0][1][1] = b + pixelsize * spec.tile_width + pixelsize;
+            b += pixelsize * spec.tile_width * spec.tile_height;
+            texel[1][0][0] = b;
+            texel[1][0][1] = b + pixelsize;
+            texel[1][1][0] = b + pixelsize * spec.tile_width;
+            texel[1][1][1] = b + pixelsize * spec.tile_width + pixelsize;
+        }
     } else {
         bool firstsample = true;
         for (int k = 0; k < 2; ++k) {
@@ -553,6 +568,8 @@ TextureSystemImpl::accum3d_sample_bilinear(
                     size_t offset = (spec.nchannels * tilepel
                                      + startchan_in_tile)
                                     * channelsize;
+                    if (tile->constant())  // It holds just its one pixel
+                        offset = startchan_in_tile * channelsize;
 #ifndef NDEBUG
                     if ((size_t)offset >= spec.tile_width * spec.tile_height
                                               * spec.tile_depth * pixelsize)
@@ -802,15 +819,269 @@ TextureSystemImpl::accum3d_sample_bilinear(
 
 
 bool
-TextureSystemImpl::texture3d(TextureHandle* texture_handle,
-                             Perthread* thread_info, TextureOptBatch& options,
-                             Tex::RunMask mask, const float* P,
+TextureSystemImpl::accum3d_sample_batch(
+    const Tex::FloatWide* P, int miplevel, Tex::RunMask lanes,
+    TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& options,
+    int nchannels_result, int actualchannels, Tex::FloatWide* accum,
+    Tex::FloatWide* daccumds, Tex::FloatWide* daccumdt,
+    Tex::FloatWide* daccumdr)
+{
+    using Tex::FloatWide;
+    using Tex::IntWide;
+    typedef FloatWide::vbool_t BoolWide;
+
+    const ImageSpec& spec(texturefile.spec(options.subimage, miplevel));
+    const ImageCacheFile::LevelInfo& levelinfo(
+        texturefile.levelinfo(options.subimage, miplevel));
+    TypeDesc::BASETYPE pixeltype = texturefile.pixeltype(options.subimage);
+    wrap_impl_wide swrap_func    = wrap_functions_wide[(int)options.swrap];
+    wrap_impl_wide twrap_func    = wrap_functions_wide[(int)options.twrap];
+    wrap_impl_wide rwrap_func    = wrap_functions_wide[(int)options.rwrap];
+    bool closest  = (options.interpmode == TextureOpt::InterpClosest);
+    bool use_fill = (nchannels_result > actualchannels && options.fill);
+    bool tilepow2 = ispow2(spec.tile_width) && ispow2(spec.tile_height)
+                    && ispow2(spec.tile_depth);
+    int tile_chbegin = 0, tile_chend = spec.nchannels;
+    if (spec.nchannels > m_max_tile_channels) {
+        // For files with many channels, narrow the range we cache
+        tile_chbegin = options.firstchannel;
+        tile_chend   = options.firstchannel + actualchannels;
+    }
+    TileID id(texturefile, options.subimage, miplevel, 0, 0, 0, tile_chbegin,
+              tile_chend);
+    int channelsize = int(texturefile.channelsize(options.subimage));
+    int pixelsize   = channelsize * id.nchannels();
+    int chanoffset  = channelsize * (options.firstchannel - id.chbegin());
+
+    // As passed in, (s,t,r) map the texture to (0,1).  Remap to texel
+    // coords, and for trilinear interpolation subtract 0.5 because samples
+    // are at texel centers.
+    float center = closest ? 0.0f : 0.5f;
+    FloatWide s  = P[0] * float(spec.full_width) + float(spec.full_x) - center;
+    FloatWide t  = P[1] * float(spec.full_height) + float(spec.full_y)
+                  - center;
+    FloatWide r  = P[2] * float(spec.full_depth) + float(spec.full_z) - center;
+    IntWide sint, tint, rint;
+    FloatWide sfrac = floorfrac(s, &sint);
+    FloatWide tfrac = floorfrac(t, &tint);
+    FloatWide rfrac = floorfrac(r, &rint);
+
+    // The voxels [0..1] along each axis that we need, wrapped, and which
+    // of them are valid (false means black border). Closest interpolation
+    // only needs voxel 0 of each axis.
+    int ntexels = closest ? 1 : 2;
+    IntWide stex[2] = { sint, sint + 1 };
+    IntWide ttex[2] = { tint, tint + 1 };
+    IntWide rtex[2] = { rint, rint + 1 };
+    IntWide x(spec.x), y(spec.y), z(spec.z);
+    IntWide width(spec.width), height(spec.height), depth(spec.depth);
+    BoolWide svalid[2], tvalid[2], rvalid[2];
+    IntWide tile_x[2], tile_y[2], tile_z[2];  // coordinates of tile origins
+    IntWide colbytes[2], rowbytes[2], slicebytes[2];  // offsets within tile
+    for (int i = 0; i < ntexels; ++i) {
+        svalid[i] = swrap_func(stex[i], x, width);
+        tvalid[i] = twrap_func(ttex[i], y, height);
+        rvalid[i] = rwrap_func(rtex[i], z, depth);
+        if (!levelinfo.full_pixel_range) {
+            // Account for crop windows
+            svalid[i] &= (stex[i] >= x) & (stex[i] < (x + width));
+            tvalid[i] &= (ttex[i] >= y) & (ttex[i] < (y + height));
+            rvalid[i] &= (rtex[i] >= z) & (rtex[i] < (z + depth));
+        }
+        IntWide tile_s = stex[i] - x;
+        IntWide tile_t = ttex[i] - y;
+        IntWide tile_r = rtex[i] - z;
+        if (tilepow2) {
+            tile_s &= (spec.tile_width - 1);
+            tile_t &= (spec.tile_height - 1);
+            tile_r &= (spec.tile_depth - 1);
+        } else {
+            tile_s = tile_s % spec.tile_width;
+            tile_t = tile_t % spec.tile_height;
+            tile_r = tile_r % spec.tile_depth;
+        }
+        tile_x[i]     = stex[i] - tile_s;
+        tile_y[i]     = ttex[i] - tile_t;
+        tile_z[i]     = rtex[i] - tile_r;
+        colbytes[i]   = tile_s * pixelsize + chanoffset;
+        rowbytes[i]   = tile_t * (spec.tile_width * pixelsize);
+        slicebytes[i] = tile_r * (spec.tile_width * spec.tile_height
+                                  * pixelsize);
+    }
+
+    // Gather the voxels, laid out like the batch results, [channel][lane]
+    // for each of the 2x2x2 corners. Coherent lanes mostly land on the same
+    // tile, so we only go back to the cache when a voxel is on a different
+    // tile than the previous one.
+    alignas(Tex::BatchAlign) float texels[2][2][2][4][Tex::BatchWidth];
+    BoolWide texelvalid[2][2][2];
+    int lanesok                 = int(lanes);
+    const unsigned char* pixels = nullptr;
+    bool constant               = false;  // Is the current tile constant?
+    int curtile_x = 0, curtile_y = 0, curtile_z = 0;
+    bool firstsample = true;
+    for (int k = 0; k < ntexels; ++k) {
+        for (int j = 0; j < ntexels; ++j) {
+            for (int i = 0; i < ntexels; ++i) {
+                texelvalid[k][j][i] = svalid[i] & tvalid[j] & rvalid[k]
+                                      & BoolWide::from_bitmask(lanesok);
+                int todo = texelvalid[k][j][i].bitmask();
+                for (int lane = 0; todo; ++lane, todo >>= 1) {
+                    if (!(todo & 1))
+                        continue;
+                    if (!pixels || tile_x[i][lane] != curtile_x
+                        || tile_y[j][lane] != curtile_y
+                        || tile_z[k][lane] != curtile_z) {
+                        curtile_x = tile_x[i][lane];
+                        curtile_y = tile_y[j][lane];
+                        curtile_z = tile_z[k][lane];
+                        id.xyz(curtile_x, curtile_y, curtile_z);
+                        bool ok = find_tile(id, thread_info, firstsample);
+                        firstsample = false;
+                        if (!ok)
+                            error("{}", m_imagecache->geterror());
+                        TileRef& tile(thread_info->tile);
+                        if (!ok || !tile || !tile->valid()) {
+                            pixels = nullptr;
+                            lanesok &= ~(1 << lane);
+                            continue;
+                        }
+                        pixels   = tile->bytedata();
+                        constant = tile->constant();
+                    }
+                    // A constant tile holds just its one pixel
+                    const unsigned char* texel
+                        = constant ? pixels + chanoffset
+                                   : pixels + slicebytes[k][lane]
+                                         + rowbytes[j][lane]
+                                         + colbytes[i][lane];
+                    float* dst = &texels[k][j][i][0][lane];
+                    if (pixeltype == TypeDesc::UINT8) {
+                        for (int c = 0; c < actualchannels; ++c)
+                            dst[c * Tex::BatchWidth] = uchar2float(texel[c]);
+                    } else if (pixeltype == TypeDesc::UINT16) {
+                        for (int c = 0; c < actualchannels; ++c)
+                            dst[c * Tex::BatchWidth] = ushort2float(
+                                ((const uint16_t*)texel)[c]);
+                    } else if (pixeltype == TypeDesc::HALF) {
+                        for (int c = 0; c < actualchannels; ++c)
+                            dst[c * Tex::BatchWidth] = half2float(
+                                ((const half*)texel)[c]);
+                    } else {
+                        OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
+                        for (int c = 0; c < actualchannels; ++c)
+                            dst[c * Tex::BatchWidth] = ((const float*)texel)[c];
+                    }
+                }
+            }
+        }
+    }
+    // Lanes that couldn't get at one of their tiles contribute nothing
+    BoolWide okmask  = BoolWide::from_bitmask(lanesok);
+    FloatWide weight = blend0(FloatWide::One(), okmask);
+
+    if (closest) {
+        BoolWide valid = texelvalid[0][0][0] & okmask;
+        for (int c = 0; c < actualchannels; ++c)
+            accum[c] += weight
+                        * blend0(FloatWide(texels[0][0][0][c]), valid);
+        // Add appropriate amount of "fill" color to extra channels in
+        // non-"black"-wrapped regions.
+        if (use_fill)
+            for (int c = actualchannels; c < nchannels_result; ++c)
+                accum[c] += blend0(weight * options.fill, valid);
+        return lanesok == int(lanes);
+    }
+
+    FloatWide v[2][2][2];
+    for (int c = 0; c < actualchannels; ++c) {
+        for (int k = 0; k < 2; ++k)
+            for (int j = 0; j < 2; ++j)
+                for (int i = 0; i < 2; ++i)
+                    v[k][j][i] = blend0(FloatWide(texels[k][j][i][c]),
+                                        texelvalid[k][j][i]);
+        accum[c] += weight
+                    * trilerp(v[0][0][0], v[0][0][1], v[0][1][0], v[0][1][1],
+                              v[1][0][0], v[1][0][1], v[1][1][0], v[1][1][1],
+                              sfrac, tfrac, rfrac);
+        if (daccumds) {
+            FloatWide scalex = weight * float(spec.full_width);
+            FloatWide scaley = weight * float(spec.full_height);
+            FloatWide scalez = weight * float(spec.full_depth);
+            daccumds[c] += scalex
+                           * bilerp(v[0][0][1] - v[0][0][0],
+                                    v[0][1][1] - v[0][1][0],
+                                    v[1][0][1] - v[1][0][0],
+                                    v[1][1][1] - v[1][1][0], tfrac, rfrac);
+            daccumdt[c] += scaley
+                           * bilerp(v[0][1][0] - v[0][0][0],
+                                    v[0][1][1] - v[0][0][1],
+                                    v[1][1][0] - v[1][0][0],
+                                    v[1][1][1] - v[1][0][1], sfrac, rfrac);
+            // N.B. Same r derivative as accum3d_sample_bilinear, so that
+            // batched and single point lookups agree.
+            daccumdr[c] += scalez
+                           * bilerp(v[0][1][0] - v[1][1][0],
+                                    v[0][1][1] - v[1][1][1],
+                                    v[0][0][1] - v[1][0][0],
+                                    v[0][1][1] - v[1][1][1], sfrac, tfrac);
+        }
+    }
+
+    // Add appropriate amount of "fill" color to extra channels in
+    // non-"black"-wrapped regions.
+    if (use_fill) {
+        FloatWide f[2][2][2];
+        for (int k = 0; k < 2; ++k)
+            for (int j = 0; j < 2; ++j)
+                for (int i = 0; i < 2; ++i)
+                    f[k][j][i] = blend0(FloatWide::One(), texelvalid[k][j][i]);
+        FloatWide fill = trilerp(f[0][0][0], f[0][0][1], f[0][1][0],
+                                 f[0][1][1], f[1][0][0], f[1][0][1],
+                                 f[1][1][0], f[1][1][1], sfrac, tfrac, rfrac)
+                         * (weight * options.fill);
+        for (int c = actualchannels; c < nchannels_result; ++c)
+            accum[c] += fill;
+    }
+    return lanesok == int(lanes);
+}
+
+
+
+bool
+TextureSystemImpl::texture3d(TextureHandle* texture_handle_,
+                             Perthread* thread_info_, TextureOptBatch& options,
+                             Tex::RunMask mask, const float* P_,
                              const float* dPdx, const float* dPdy,
                              const float* dPdz, int nchannels, float* result,
                              float* dresultds, float* dresultdt,
                              float* dresultdr)
 {
-    // (FIXME) CHEAT! Texture points individually
+    using Tex::FloatWide;
+
+    // Handle >4 channel lookups by recursion.
+    if (nchannels > 4) {
+        int save_firstchannel = options.firstchannel;
+        bool ok               = true;
+        while (nchannels) {
+            int n = std::min(nchannels, 4);
+            ok &= texture3d(texture_handle_, thread_info_, options, mask, P_,
+                            dPdx, dPdy, dPdz, n, result, dresultds, dresultdt,
+                            dresultdr);
+            result += n * Tex::BatchWidth;
+            if (dresultds)
+                dresultds += n * Tex::BatchWidth;
+            if (dresultdt)
+                dresultdt += n * Tex::BatchWidth;
+            if (dresultdr)
+                dresultdr += n * Tex::BatchWidth;
+            options.firstchannel += n;
+            nchannels -= n;
+        }
+        options.firstchannel = save_firstchannel;  // restore what we changed
+        return ok;
+    }
+
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
@@ -825,42 +1096,121 @@ TextureSystemImpl::texture3d(TextureHandle* texture_handle,
     opt.missingcolor        = options.missingcolor;
     opt.rwrap               = (TextureOpt::Wrap)options.rwrap;
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        float r[4], drds[4], drdt[4], drdr[4];  // temp result
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.rblur  = options.rblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rwidth = options.rwidth[i];
-            Imath::V3f P_(P[i], P[i + Tex::BatchWidth],
-                          P[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdx_(dPdx[i], dPdx[i + Tex::BatchWidth],
-                             dPdx[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdy_(dPdy[i], dPdy[i + Tex::BatchWidth],
-                             dPdy[i + 2 * Tex::BatchWidth]);
-            Imath::V3f dPdz_(dPdz[i], dPdz[i + Tex::BatchWidth],
-                             dPdz[i + 2 * Tex::BatchWidth]);
-            if (dresultds) {
-                ok &= texture3d(texture_handle, thread_info, opt, P_, dPdx_,
-                                dPdy_, dPdz_, nchannels, r, drds, drdt, drdr);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
-                    dresultdr[c * Tex::BatchWidth + i] = drdr[c];
-                }
-            } else {
-                ok &= texture3d(texture_handle, thread_info, opt, P_, dPdx_,
-                                dPdy_, dPdz_, nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
-                }
-            }
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    TextureFile* texturefile = verify_texturefile((TextureFile*)texture_handle_,
+                                                  thread_info);
+    int nlanes = 0;
+    for (Tex::RunMask m = mask; m; m &= m - 1)
+        ++nlanes;
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.texture3d_batches;
+    stats.texture3d_queries += nlanes;
+
+    if (!texturefile || texturefile->broken())
+        return missing_texture(options, mask, nchannels, result, dresultds,
+                               dresultdt, dresultdr);
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int s = m_imagecache->subimage_from_name(texturefile, opt.subimagename);
+        if (s < 0) {
+            error("Unknown subimage \"{}\" in texture \"{}\"",
+                  opt.subimagename, texturefile->filename());
+            return missing_texture(options, mask, nchannels, result,
+                                   dresultds, dresultdt, dresultdr);
         }
+        opt.subimage = s;
+        opt.subimagename.clear();
+    }
+    if (opt.subimage < 0 || opt.subimage >= texturefile->subimages()) {
+        error("Unknown subimage \"{}\" in texture \"{}\"", opt.subimagename,
+              texturefile->filename());
+        return missing_texture(options, mask, nchannels, result, dresultds,
+                               dresultdt, dresultdr);
+    }
+
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    // Figure out the wrap functions
+    if (opt.swrap == TextureOpt::WrapDefault)
+        opt.swrap = (TextureOpt::Wrap)texturefile->swrap();
+    if (opt.swrap == TextureOpt::WrapPeriodic && ispow2(spec.width))
+        opt.swrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.twrap == TextureOpt::WrapDefault)
+        opt.twrap = (TextureOpt::Wrap)texturefile->twrap();
+    if (opt.twrap == TextureOpt::WrapPeriodic && ispow2(spec.height))
+        opt.twrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.rwrap == TextureOpt::WrapDefault)
+        opt.rwrap = (TextureOpt::Wrap)texturefile->rwrap();
+    if (opt.rwrap == TextureOpt::WrapPeriodic && ispow2(spec.depth))
+        opt.rwrap = TextureOpt::WrapPeriodicPow2;
+
+    int actualchannels = OIIO::clamp(spec.nchannels - opt.firstchannel, 0,
+                                     nchannels);
+
+    // Do the volume lookup in local space, transforming all lanes at once
+    // the same way multVecMatrix would transform each point.
+    FloatWide P[3];
+    for (int i = 0; i < 3; ++i)
+        P[i] = FloatWide(P_ + i * Tex::BatchWidth);
+    const auto& si(texturefile->subimageinfo(opt.subimage));
+    if (si.Mlocal) {
+        const Imath::M44f& M(*si.Mlocal);
+        FloatWide a = P[0] * M[0][0] + P[1] * M[1][0] + P[2] * M[2][0]
+                      + M[3][0];
+        FloatWide b = P[0] * M[0][1] + P[1] * M[1][1] + P[2] * M[2][1]
+                      + M[3][1];
+        FloatWide c = P[0] * M[0][2] + P[1] * M[1][2] + P[2] * M[2][2]
+                      + M[3][2];
+        FloatWide w = P[0] * M[0][3] + P[1] * M[1][3] + P[2] * M[2][3]
+                      + M[3][3];
+        P[0] = a / w;
+        P[1] = b / w;
+        P[2] = c / w;
+    }
+    // As with single point lookups, volume lookups aren't filtered, so the
+    // derivatives of P aren't used (nor transformed).
+
+    FloatWide r[4], drds[4], drdt[4], drdr[4];
+    for (int c = 0; c < nchannels; ++c) {
+        r[c].clear();
+        drds[c].clear();
+        drdt[c].clear();
+        drdr[c].clear();
+    }
+    bool derivs = (dresultds && dresultdt && dresultdr);
+
+    // FIXME: currently, no support of actual MIPmapping.
+    bool ok = accum3d_sample_batch(P, 0, mask, *texturefile, thread_info, opt,
+                                   nchannels, actualchannels, r,
+                                   derivs ? drds : nullptr,
+                                   derivs ? drdt : nullptr,
+                                   derivs ? drdr : nullptr);
+
+    // Update stats
+    stats.aniso_queries += nlanes;
+    stats.aniso_probes += nlanes;
+    switch (opt.interpmode) {
+    case TextureOpt::InterpClosest: stats.closest_interps += nlanes; break;
+    case TextureOpt::InterpBilinear: stats.bilinear_interps += nlanes; break;
+    case TextureOpt::InterpBicubic: stats.cubic_interps += nlanes; break;
+    case TextureOpt::InterpSmartBicubic:
+    case TextureOpt::InterpStochasticBilinear:
+        stats.bilinear_interps += nlanes;
+        break;
+    }
+
+    if (actualchannels < nchannels && opt.firstchannel == 0 && m_gray_to_rgb)
+        fill_gray_channels(spec, nchannels, r, drds, drdt, drdr);
+    for (int c = 0; c < nchannels; ++c) {
+        r[c].store_mask(int(mask), result + c * Tex::BatchWidth);
+        if (dresultds)
+            drds[c].store_mask(int(mask), dresultds + c * Tex::BatchWidth);
+        if (dresultdt)
+            drdt[c].store_mask(int(mask), dresultdt + c * Tex::BatchWidth);
+        if (dresultdr)
+            drdr[c].store_mask(int(mask), dresultdr + c * Tex::BatchWidth);
     }
     return ok;
 }
@@ -119,6 +119,10 @@ public:
         return (TextureHandle*)find_texturefile(filename, thread_info);
     }
 
+    virtual bool get_texture_handles(cspan<ustring> filenames,
+                                     span<TextureHandle*> handles,
+                                     Perthread* thread);
+
     virtual bool good(TextureHandle* texture_handle)
     {
         return texture_handle && !((TextureFile*)texture_handle)->broken();
@@ -139,6 +143,19 @@ public:
                          float dtdx, float dsdy, float dtdy, int nchannels,
                          float* result, float* dresultds = NULL,
                          float* dresultdt = NULL);
+    virtual bool texture_quad(ustring filename, TextureOpt& options,
+                              const float* s, const float* t, float dsdx,
+                              float dtdx, float dsdy, float dtdy,
+                              int nchannels, float* result,
+                              float* dresultds = nullptr,
+                              float* dresultdt = nullptr);
+    virtual bool texture_quad(TextureHandle* texture_handle,
+                              Perthread* thread_info, TextureOpt& options,
+                              const float* s, const float* t, float dsdx,
+                              float dtdx, float dsdy, float dtdy,
+                              int nchannels, float* result,
+                              float* dresultds = nullptr,
+                              float* dresultdt = nullptr);
     virtual bool texture(ustring filename, TextureOptBatch& options,
                          Tex::RunMask mask, const float* s, const float* t,
                          const float* dsdx, const float* dtdx,
@@ -360,6 +377,9 @@ public:
     void operator delete(void* todel) { ::delete ((char*)todel); }
 
     typedef bool (*wrap_impl)(int& coord, int origin, int width);
+    typedef Tex::IntWide::vbool_t (*wrap_impl_wide)(Tex::IntWide& coord,
+                                                    const Tex::IntWide& origin,
+                                                    const Tex::IntWide& width);
 
     /// Return an opaque, non-owning pointer to the underlying ImageCache
     /// (if there is one).
@@ -427,6 +447,55 @@ private:
                         float _dtdx, float _dsdy, float _dtdy, float* result,
                         float* dresultds, float* resultdt);
 
+    /// The MIP levels and sampling pattern of an anisotropic lookup,
+    /// which depend only on the derivatives and options, so lookups at
+    /// several nearby points may share them.
+    struct AnisoFootprint {
+        int miplevel[2];
+        float levelweight[2];
+        float smajor, tmajor;  ///< Half the line the samples are spread on
+        float invsamples;
+        int nsamples;
+        float* lineweight;  ///< Weights of the samples [nsamples]
+        float trueaspect;
+        float xi;  ///< What's left of options.rnd after choosing levels
+        int naturalsres, naturaltres;
+    };
+
+    /// Compute the footprint of an anisotropic lookup. The caller must
+    /// allocate footprint.lineweight, with room for 2*options.anisotropic
+    /// weights, rounded up to a multiple of 4.
+    void aniso_footprint(TextureFile& texfile, TextureOpt& options,
+                         float dsdx, float dtdx, float dsdy, float dtdy,
+                         AnisoFootprint& footprint);
+
+    /// Look up texture from just ONE point, with a precomputed footprint.
+    bool texture_lookup_aniso(TextureFile& texfile, PerThreadInfo* thread_info,
+                              TextureOpt& options,
+                              const AnisoFootprint& footprint,
+                              int nchannels_result, int actualchannels,
+                              float s, float t, float* result,
+                              float* dresultds, float* dresultdt);
+
+    /// Look up texture at up to 4 points with the same derivatives, with
+    /// results in result[i*nchannels..] for point i. Requires nchannels <= 4,
+    /// and if npoints > 1, that the texture is not a udim.
+    bool texture_points(TextureHandle* texture_handle, Perthread* thread_info,
+                        TextureOpt& options, int npoints, const float* s,
+                        const float* t, float dsdx, float dtdx, float dsdy,
+                        float dtdy, int nchannels, float* result,
+                        float* dresultds, float* dresultdt);
+
+    /// The lookup of one point for texture_points, once the file, st and
+    /// derivatives are resolved. If footprint is not null, it's used
+    /// instead of the lookup function.
+    bool texture_point(TextureFile& texfile, PerThreadInfo* thread_info,
+                       TextureOpt& options, texture_lookup_prototype lookup,
+                       const AnisoFootprint* footprint, const ImageSpec& spec,
+                       int nchannels, int actualchannels, float s, float t,
+                       float dsdx, float dtdx, float dsdy, float dtdy,
+                       float* result, float* dresultds, float* dresultdt);
+
     bool texture_lookup_nomip(TextureFile& texfile, PerThreadInfo* thread_info,
                               TextureOpt& options, int nchannels_result,
                               int actualchannels, float _s, float _t,
@@ -470,6 +539,37 @@ private:
                         simd::vfloat4* accum, simd::vfloat4* daccumds,
                         simd::vfloat4* daccumdt);
 
+    /// Sample one MIP level for all the lanes of a batch set in 'lanes',
+    /// using closest or bilinear interpolation, adding weight[lane] times
+    /// the filtered texel values into accum[channel][lane] (and likewise
+    /// for the derivatives if daccumds is not NULL). Lanes whose texels
+    /// hit the same tile share a single tile lookup. Bilinear lookups of
+    /// one-tile levels of lat-long maps fade to the pole colors.
+    bool sample_batch(const Tex::FloatWide& s, const Tex::FloatWide& t,
+                      int level, Tex::RunMask lanes,
+                      const Tex::FloatWide& weight, TextureFile& texturefile,
+                      PerThreadInfo* thread_info, TextureOpt& options,
+                      int nchannels_result, int actualchannels,
+                      bool mark_first_tile_used, Tex::FloatWide* accum,
+                      Tex::FloatWide* daccumds, Tex::FloatWide* daccumdt);
+
+    /// Anisotropic lookup of all the lanes of a batch set in 'lanes', with
+    /// s, t and the derivatives already remapped for flipping and crops,
+    /// adding the results into accum[channel][lane] (and likewise for the
+    /// derivatives if daccumds is not NULL). Each lane's footprint is the
+    /// same as for a single point; then the samples along the major axes
+    /// of all the lanes are taken together, one MIP level at a time, with
+    /// sample_batch. Lanes that need bicubic interpolation are looked up
+    /// one at a time with texture_lookup_aniso.
+    bool texture_lookup_aniso_batch(
+        TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& opt,
+        const TextureOptBatch& options, Tex::RunMask lanes,
+        const Tex::FloatWide& s, const Tex::FloatWide& t,
+        const Tex::FloatWide& dsdx, const Tex::FloatWide& dtdx,
+        const Tex::FloatWide& dsdy, const Tex::FloatWide& dtdy,
+        int nchannels_result, int actualchannels, Tex::FloatWide* accum,
+        Tex::FloatWide* daccumds, Tex::FloatWide* daccumdt);
+
     // Define a prototype of a member function pointer for texture3d
     // lookups.
     typedef bool (TextureSystemImpl::*texture3d_lookup_prototype)(
@@ -502,6 +602,19 @@ private:
                                  int actualchannels, float weight, float* accum,
                                  float* daccumds, float* daccumdt,
                                  float* daccumdr);
+    /// Batched flavor of accum3d_sample_closest/accum3d_sample_bilinear:
+    /// sample one MIP level for all the lanes of a batch set in 'lanes',
+    /// adding the filtered voxel values into accum[channel][lane] (and
+    /// likewise for the derivatives if daccumds is not NULL). P holds the
+    /// x, y, z components of the lookup points. Lanes whose voxels hit the
+    /// same tile share a single tile lookup.
+    bool accum3d_sample_batch(const Tex::FloatWide* P, int level,
+                              Tex::RunMask lanes, TextureFile& texturefile,
+                              PerThreadInfo* thread_info, TextureOpt& options,
+                              int nchannels_result, int actualchannels,
+                              Tex::FloatWide* accum, Tex::FloatWide* daccumds,
+                              Tex::FloatWide* daccumdt,
+                              Tex::FloatWide* daccumdr);
 
     /// Helper function to calculate the anisotropic aspect ratio from
     /// the major and minor ellipse axis lengths.  The "clamped" aspect
@@ -521,19 +634,47 @@ private:
                      const ImageSpec& spec, int& i, int& j, float& ifrac,
                      float& jfrac);
 
+    /// For InterpStochasticBilinear: move each of the nsamples positions
+    /// (s,t) to the center of one of the four texels that bilinear
+    /// interpolation would blend there, chosen with probability equal to
+    /// its bilinear weight using the uniform random deviate xi. A closest
+    /// texel lookup at the new position is then an unbiased estimate of
+    /// the bilinear lookup at the old one.
+    void stochastic_bilinear_texels(int nsamples, float* s, float* t,
+                                    TextureFile& texturefile,
+                                    const ImageSpec& spec, float xi);
+
     /// Called when the requested texture is missing, fills in the
     /// results.
     bool missing_texture(TextureOpt& options, int nchannels, float* result,
                          float* dresultds, float* dresultdt,
                          float* dresultdr = NULL);
+    /// Batched flavor of missing_texture, filling in only the lanes that
+    /// are set in mask.
+    bool missing_texture(TextureOptBatch& options, Tex::RunMask mask,
+                         int nchannels, float* result, float* dresultds,
+                         float* dresultdt, float* dresultdr = NULL);
+
+    /// If a batched 2D lookup was given only one of dresultds/dresultdt,
+    /// zero the lanes of that one and clear both pointers, so that no
+    /// derivatives are computed -- the same as the single point lookups.
+    static void zero_lone_derivs(Tex::RunMask mask, int nchannels,
+                                 float*& dresultds, float*& dresultdt);
 
     /// Handle gray-to-RGB promotion.
     void fill_gray_channels(const ImageSpec& spec, int nchannels, float* result,
                             float* dresultds, float* dresultdt,
                             float* dresultdr = NULL);
+    /// Batched flavor of fill_gray_channels, for results held as one
+    /// FloatWide per channel.
+    void fill_gray_channels(const ImageSpec& spec, int nchannels,
+                            Tex::FloatWide* result, Tex::FloatWide* dresultds,
+                            Tex::FloatWide* dresultdt,
+                            Tex::FloatWide* dresultdr = NULL);
 
     static bool wrap_periodic_sharedborder(int& coord, int origin, int width);
     static const wrap_impl wrap_functions[];
+    static const wrap_impl_wide wrap_functions_wide[];
 
     /// Helper function for lat-long environment maps: compute a "pole"
     /// pixel that's the average of all of row y.  This will only be
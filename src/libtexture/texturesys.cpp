@@ -75,6 +75,37 @@ half2float4(const half* h)
 }
 
 
+// Load (up to) 4 channels of one texel of the given pixel type,
+// converting to float.
+OIIO_FORCEINLINE vfloat4
+load_texel4(TypeDesc::BASETYPE pixeltype, const unsigned char* p)
+{
+    if (pixeltype == TypeDesc::UINT8)
+        return uchar2float4(p);
+    if (pixeltype == TypeDesc::UINT16)
+        return ushort2float4((const unsigned short*)p);
+    if (pixeltype == TypeDesc::HALF)
+        return half2float4((const half*)p);
+    OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
+    return vfloat4((const float*)p);
+}
+
+
+// Use the uniform random deviate xi in [0,1) to make a choice that is true
+// with probability p. Then rescale xi so that it is again uniform on [0,1)
+// and independent of the choice, for use in further choices. (Each
+// rescaling costs some of xi's bits of precision, but plenty are left for
+// the few choices made for a lookup.)
+inline bool
+stochastic_choice(float& xi, float p)
+{
+    bool yes = (xi < p);
+    xi       = yes ? xi / p : (xi - p) / (1.0f - p);
+    xi       = std::min(xi, 0.99999994f);  // Don't let rounding make it 1
+    return yes;
+}
+
+
 static const OIIO_SIMD4_ALIGN vbool4 channel_masks[5] = {
     vbool4(false, false, false, false), vbool4(true, false, false, false),
     vbool4(true, true, false, false),   vbool4(true, true, true, false),
@@ -179,64 +210,69 @@ const TextureSystemImpl::wrap_impl TextureSystemImpl::wrap_functions[] = {
 
 
 
-simd::vbool4
-wrap_black_simd(simd::vint4& coord_, const simd::vint4& origin,
-                const simd::vint4& width)
+// The SIMD wrap functions are templated on the int vector type, so that
+// the same code serves both the 4-wide texel neighborhoods of a single
+// lookup (vint4) and the batched lookups that wrap one coordinate for
+// every lane of a batch at once (Tex::IntWide).
+
+template<typename VINT>
+typename VINT::vbool_t
+wrap_black_simd(VINT& coord_, const VINT& origin, const VINT& width)
 {
-    simd::vint4 coord(coord_);
+    VINT coord(coord_);
     return (coord >= origin) & (coord < (width + origin));
 }
 
 
-simd::vbool4
-wrap_clamp_simd(simd::vint4& coord_, const simd::vint4& origin,
-                const simd::vint4& width)
+template<typename VINT>
+typename VINT::vbool_t
+wrap_clamp_simd(VINT& coord_, const VINT& origin, const VINT& width)
 {
-    simd::vint4 coord(coord_);
-    coord = simd::blend(coord, origin, coord < origin);
-    coord = simd::blend(coord, (origin + width - 1), coord >= (origin + width));
+    VINT coord(coord_);
+    coord  = simd::blend(coord, origin, coord < origin);
+    coord  = simd::blend(coord, (origin + width - 1), coord >= (origin + width));
     coord_ = coord;
-    return simd::vbool4::True();
+    return VINT::vbool_t::True();
 }
 
 
-simd::vbool4
-wrap_periodic_simd(simd::vint4& coord_, const simd::vint4& origin,
-                   const simd::vint4& width)
+template<typename VINT>
+typename VINT::vbool_t
+wrap_periodic_simd(VINT& coord_, const VINT& origin, const VINT& width)
 {
-    simd::vint4 coord(coord_);
+    VINT coord(coord_);
     coord  = coord - origin;
     coord  = coord % width;
     coord  = simd::blend(coord, coord + width, coord < 0);
     coord  = coord + origin;
     coord_ = coord;
-    return simd::vbool4::True();
+    return VINT::vbool_t::True();
 }
 
 
-simd::vbool4
-wrap_periodic_pow2_simd(simd::vint4& coord_, const simd::vint4& origin,
-                        const simd::vint4& width)
+template<typename VINT>
+typename VINT::vbool_t
+wrap_periodic_pow2_simd(VINT& coord_, const VINT& origin, const VINT& width)
 {
-    simd::vint4 coord(coord_);
+    VINT coord(coord_);
     // OIIO_DASSERT (ispow2(width));
     coord = coord - origin;
     coord = coord
             & (width - 1);  // Shortcut periodic if we're sure it's a pow of 2
     coord  = coord + origin;
     coord_ = coord;
-    return simd::vbool4::True();
+    return VINT::vbool_t::True();
 }
 
 
-simd::vbool4
-wrap_mirror_simd(simd::vint4& coord_, const simd::vint4& origin,
-                 const simd::vint4& width)
+template<typename VINT>
+typename VINT::vbool_t
+wrap_mirror_simd(VINT& coord_, const VINT& origin, const VINT& width)
 {
-    simd::vint4 coord(coord_);
-    coord            = coord - origin;
-    coord            = simd::blend(coord, -1 - coord, coord < 0);
-    simd::vint4 iter = coord / width;  // Which iteration of the pattern?
+    VINT coord(coord_);
+    coord     = coord - origin;
+    coord     = simd::blend(coord, -1 - coord, coord < 0);
+    VINT iter = coord / width;  // Which iteration of the pattern?
     coord -= iter * width;
     // Odd iterations -- flip the sense
     coord = blend(coord, (width - 1) - coord, (iter & 1) != 0);
@@ -244,24 +280,25 @@ wrap_mirror_simd(simd::vint4& coord_, const simd::vint4& origin,
     //              "width=%d, origin=%d, result=%d", width, origin, coord);
     coord += origin;
     coord_ = coord;
-    return simd::vbool4::True();
+    return VINT::vbool_t::True();
 }
 
 
-simd::vbool4
-wrap_periodic_sharedborder_simd(simd::vint4& coord_, const simd::vint4& origin,
-                                const simd::vint4& width)
+template<typename VINT>
+typename VINT::vbool_t
+wrap_periodic_sharedborder_simd(VINT& coord_, const VINT& origin,
+                                const VINT& width)
 {
     // Like periodic, but knowing that the first column and last are
     // actually the same position, so we essentially skip the last
     // column in the next cycle.
-    simd::vint4 coord(coord_);
+    VINT coord(coord_);
     coord = coord - origin;
     coord = safe_mod(coord, (width - 1));
-    coord += blend(simd::vint4(origin), width + origin,
+    coord += blend(VINT(origin), width + origin,
                    coord < 0);  // Fix negative values
     coord_ = coord;
-    return true;
+    return VINT::vbool_t::True();
 }
 
 
@@ -273,13 +310,26 @@ typedef simd::vbool4 (*wrap_impl_simd)(simd::vint4& coord,
 
 const wrap_impl_simd wrap_functions_simd[] = {
     // Must be in same order as Wrap enum
-    wrap_black_simd,
-    wrap_black_simd,
-    wrap_clamp_simd,
-    wrap_periodic_simd,
-    wrap_mirror_simd,
-    wrap_periodic_pow2_simd,
-    wrap_periodic_sharedborder_simd
+    wrap_black_simd<simd::vint4>,
+    wrap_black_simd<simd::vint4>,
+    wrap_clamp_simd<simd::vint4>,
+    wrap_periodic_simd<simd::vint4>,
+    wrap_mirror_simd<simd::vint4>,
+    wrap_periodic_pow2_simd<simd::vint4>,
+    wrap_periodic_sharedborder_simd<simd::vint4>
+};
+
+
+const TextureSystemImpl::wrap_impl_wide
+    TextureSystemImpl::wrap_functions_wide[] = {
+    // Must be in same order as Wrap enum
+    wrap_black_simd<Tex::IntWide>,
+    wrap_black_simd<Tex::IntWide>,
+    wrap_clamp_simd<Tex::IntWide>,
+    wrap_periodic_simd<Tex::IntWide>,
+    wrap_mirror_simd<Tex::IntWide>,
+    wrap_periodic_pow2_simd<Tex::IntWide>,
+    wrap_periodic_sharedborder_simd<Tex::IntWide>
 };
 
 
@@ -531,6 +581,26 @@ TextureSystemImpl::resolve_filename(const std::string& filename) const
 
 
 
+bool
+TextureSystemImpl::get_texture_handles(cspan<ustring> filenames,
+                                       span<TextureHandle*> handles,
+                                       Perthread* /*thread*/)
+{
+    OIIO_ASSERT(handles.size() >= filenames.size());
+    // The files are found and opened on many threads, so the calling
+    // thread's info doesn't come into it. As for get_texture_handle(),
+    // the handles are of the files as named, before any switch to a
+    // duplicate.
+    span<TextureFile*> files((TextureFile**)handles.data(), handles.size());
+    m_imagecache->find_files(filenames, files);
+    bool ok = true;
+    for (size_t i = 0, e = filenames.size(); i < e; ++i)
+        ok &= good(handles[i]);
+    return ok;
+}
+
+
+
 bool
 TextureSystemImpl::get_texture_info(ustring filename, int subimage,
                                     ustring dataname, TypeDesc datatype,
@@ -931,6 +1001,56 @@ TextureSystemImpl::missing_texture(TextureOpt& options, int nchannels,
 
 
 
+bool
+TextureSystemImpl::missing_texture(TextureOptBatch& options, Tex::RunMask mask,
+                                   int nchannels, float* result,
+                                   float* dresultds, float* dresultdt,
+                                   float* dresultdr)
+{
+    for (int c = 0; c < nchannels; ++c) {
+        Tex::FloatWide r(options.missingcolor ? options.missingcolor[c]
+                                         : options.fill);
+        r.store_mask(int(mask), result + c * Tex::BatchWidth);
+        if (dresultds)
+            Tex::FloatWide::Zero().store_mask(int(mask),
+                                         dresultds + c * Tex::BatchWidth);
+        if (dresultdt)
+            Tex::FloatWide::Zero().store_mask(int(mask),
+                                         dresultdt + c * Tex::BatchWidth);
+        if (dresultdr)
+            Tex::FloatWide::Zero().store_mask(int(mask),
+                                         dresultdr + c * Tex::BatchWidth);
+    }
+    if (options.missingcolor) {
+        // don't treat it as an error if missingcolor was supplied
+        (void)geterror();  // eat the error
+        return true;
+    } else {
+        return false;
+    }
+}
+
+
+
+void
+TextureSystemImpl::zero_lone_derivs(Tex::RunMask mask, int nchannels,
+                                    float*& dresultds, float*& dresultdt)
+{
+    if (dresultds && dresultdt)
+        return;
+    for (int c = 0; c < nchannels; ++c) {
+        if (dresultds)
+            Tex::FloatWide::Zero().store_mask(int(mask),
+                                              dresultds + c * Tex::BatchWidth);
+        if (dresultdt)
+            Tex::FloatWide::Zero().store_mask(int(mask),
+                                              dresultdt + c * Tex::BatchWidth);
+    }
+    dresultds = dresultdt = nullptr;
+}
+
+
+
 void
 TextureSystemImpl::fill_gray_channels(const ImageSpec& spec, int nchannels,
                                       float* result, float* dresultds,
@@ -981,6 +1101,50 @@ TextureSystemImpl::fill_gray_channels(const ImageSpec& spec, int nchannels,
 
 
 
+void
+TextureSystemImpl::fill_gray_channels(const ImageSpec& spec, int nchannels,
+                                      Tex::FloatWide* result,
+                                      Tex::FloatWide* dresultds,
+                                      Tex::FloatWide* dresultdt,
+                                      Tex::FloatWide* dresultdr)
+{
+    // Same as above, but each "channel" is a whole batch of lanes.
+    int specchans = spec.nchannels;
+    if (specchans == 1 && nchannels >= 3) {
+        result[1] = result[0];
+        result[2] = result[0];
+        if (dresultds) {
+            dresultds[1] = dresultds[0];
+            dresultds[2] = dresultds[0];
+            dresultdt[1] = dresultdt[0];
+            dresultdt[2] = dresultdt[0];
+            if (dresultdr) {
+                dresultdr[1] = dresultdr[0];
+                dresultdr[2] = dresultdr[0];
+            }
+        }
+    } else if (specchans == 2 && nchannels == 4 && spec.alpha_channel == 1) {
+        result[3] = result[1];
+        result[1] = result[0];
+        result[2] = result[0];
+        if (dresultds) {
+            dresultds[3] = dresultds[1];
+            dresultds[1] = dresultds[0];
+            dresultds[2] = dresultds[0];
+            dresultdt[3] = dresultdt[1];
+            dresultdt[1] = dresultdt[0];
+            dresultdt[2] = dresultdt[0];
+            if (dresultdr) {
+                dresultdr[3] = dresultdr[1];
+                dresultdr[1] = dresultdr[0];
+                dresultdr[2] = dresultdr[0];
+            }
+        }
+    }
+}
+
+
+
 bool
 TextureSystemImpl::texture(ustring filename, TextureOptions& options,
                            Runflag* runflags, int beginactive, int endactive,
@@ -1079,6 +1243,68 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         return true;
     }
 
+    return texture_points(texture_handle_, thread_info_, options, 1, &s, &t,
+                          dsdx, dtdx, dsdy, dtdy, nchannels, result, dresultds,
+                          dresultdt);
+}
+
+
+
+bool
+TextureSystemImpl::texture_quad(ustring filename, TextureOpt& options,
+                                const float* s, const float* t, float dsdx,
+                                float dtdx, float dsdy, float dtdy,
+                                int nchannels, float* result, float* dresultds,
+                                float* dresultdt)
+{
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info();
+    TextureFile* texturefile   = find_texturefile(filename, thread_info);
+    return texture_quad((TextureHandle*)texturefile, (Perthread*)thread_info,
+                        options, s, t, dsdx, dtdx, dsdy, dtdy, nchannels,
+                        result, dresultds, dresultdt);
+}
+
+
+
+bool
+TextureSystemImpl::texture_quad(TextureHandle* texture_handle_,
+                                Perthread* thread_info_, TextureOpt& options,
+                                const float* s, const float* t, float dsdx,
+                                float dtdx, float dsdy, float dtdy,
+                                int nchannels, float* result, float* dresultds,
+                                float* dresultdt)
+{
+    // A udim texture may resolve to different files for the four points,
+    // and more than 4 channels take several lookups of each point anyway,
+    // so in those cases just do four separate lookups.
+    TextureFile* texturefile = (TextureFile*)texture_handle_;
+    if (nchannels > 4 || !texturefile || texturefile->is_udim()) {
+        bool ok = true;
+        for (int i = 0; i < 4; ++i)
+            ok &= texture(texture_handle_, thread_info_, options, s[i], t[i],
+                          dsdx, dtdx, dsdy, dtdy, nchannels,
+                          result + i * nchannels,
+                          dresultds ? dresultds + i * nchannels : nullptr,
+                          dresultdt ? dresultdt + i * nchannels : nullptr);
+        return ok;
+    }
+    return texture_points(texture_handle_, thread_info_, options, 4, s, t,
+                          dsdx, dtdx, dsdy, dtdy, nchannels, result, dresultds,
+                          dresultdt);
+}
+
+
+
+bool
+TextureSystemImpl::texture_points(TextureHandle* texture_handle_,
+                                  Perthread* thread_info_, TextureOpt& options,
+                                  int npoints, const float* s_,
+                                  const float* t_, float dsdx, float dtdx,
+                                  float dsdy, float dtdy, int nchannels,
+                                  float* result, float* dresultds,
+                                  float* dresultdt)
+{
+    OIIO_DASSERT(npoints >= 1 && npoints <= 4 && nchannels <= 4);
     static const texture_lookup_prototype lookup_functions[] = {
         // Must be in the same order as Mipmode enum
         &TextureSystemImpl::texture_lookup,
@@ -1091,26 +1317,51 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
     };
     texture_lookup_prototype lookup = lookup_functions[(int)options.mipmode];
 
+    // If the user only provided us with one derivative pointer, zero it
+    // so they know something went wrong, then compute no derivatives.
+    if (!(dresultds && dresultdt)) {
+        float* d = dresultds ? dresultds : dresultdt;
+        if (d)
+            std::fill(d, d + npoints * nchannels, 0.0f);
+        dresultds = dresultdt = nullptr;
+    }
+
     PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
         (PerThreadInfo*)thread_info_);
+    float s[4], t[4];
+    std::copy(s_, s_ + npoints, s);
+    std::copy(t_, t_ + npoints, t);
     TextureFile* texturefile = (TextureFile*)texture_handle_;
     if (texturefile->is_udim()) {
+        OIIO_DASSERT(npoints == 1);
         texturefile = (TextureFile*)resolve_udim((TextureHandle*)texture_handle_,
-                                                 (Perthread*)thread_info, s, t);
+                                                 (Perthread*)thread_info, s[0],
+                                                 t[0]);
         // Adjust s,t to be within the udim tile
-        s -= floorf(s);
-        t -= floorf(t);
+        s[0] -= floorf(s[0]);
+        t[0] -= floorf(t[0]);
     }
 
     texturefile = verify_texturefile(texturefile, thread_info);
 
     ImageCacheStatistics& stats(thread_info->m_stats);
     ++stats.texture_batches;
-    ++stats.texture_queries;
+    stats.texture_queries += npoints;
+
+    // Fill in the missing texture result of every point
+    auto missing = [&]() {
+        bool ok = true;
+        for (int i = 0; i < npoints; ++i)
+            ok = missing_texture(options, nchannels, result + i * nchannels,
+                                 dresultds ? dresultds + i * nchannels
+                                           : nullptr,
+                                 dresultdt ? dresultdt + i * nchannels
+                                           : nullptr);
+        return ok;
+    };
 
     if (!texturefile || texturefile->broken())
-        return missing_texture(options, nchannels, result, dresultds,
-                               dresultdt);
+        return missing();
 
     if (!options.subimagename.empty()) {
         // If subimage was specified by name, figure out its index.
@@ -1119,8 +1370,7 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         if (s < 0) {
             error("Unknown subimage \"{}\" in texture \"{}\"",
                   options.subimagename, texturefile->filename());
-            return missing_texture(options, nchannels, result, dresultds,
-                                   dresultdt);
+            return missing();
         }
         options.subimage = s;
         options.subimagename.clear();
@@ -1147,38 +1397,97 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         && options.twrap != TextureOpt::WrapBlack) {
         // Lookup of constant color texture, non-black wrap -- skip all the
         // hard stuff.
-        for (int c = 0; c < actualchannels; ++c)
-            result[c] = subinfo.average_color[c + options.firstchannel];
-        for (int c = actualchannels; c < nchannels; ++c)
-            result[c] = options.fill;
-        if (dresultds) {
-            // Derivs are always 0 from a constant texture lookup
-            for (int c = 0; c < nchannels; ++c) {
-                dresultds[c] = 0.0f;
-                dresultdt[c] = 0.0f;
+        for (int i = 0; i < npoints; ++i) {
+            float* r = result + i * nchannels;
+            for (int c = 0; c < actualchannels; ++c)
+                r[c] = subinfo.average_color[c + options.firstchannel];
+            for (int c = actualchannels; c < nchannels; ++c)
+                r[c] = options.fill;
+            float* drds = dresultds ? dresultds + i * nchannels : nullptr;
+            float* drdt = dresultdt ? dresultdt + i * nchannels : nullptr;
+            if (drds) {
+                // Derivs are always 0 from a constant texture lookup
+                for (int c = 0; c < nchannels; ++c) {
+                    drds[c] = 0.0f;
+                    drdt[c] = 0.0f;
+                }
             }
+            if (actualchannels < nchannels && options.firstchannel == 0
+                && m_gray_to_rgb)
+                fill_gray_channels(spec, nchannels, r, drds, drdt);
         }
-        if (actualchannels < nchannels && options.firstchannel == 0
-            && m_gray_to_rgb)
-            fill_gray_channels(spec, nchannels, result, dresultds, dresultdt);
         return true;
     }
 
     if (m_flip_t) {
-        t = 1.0f - t;
+        for (int i = 0; i < npoints; ++i)
+            t[i] = 1.0f - t[i];
         dtdx *= -1.0f;
         dtdy *= -1.0f;
     }
 
     if (!subinfo.full_pixel_range) {  // remap st for overscan or crop
-        s = s * subinfo.sscale + subinfo.soffset;
+        for (int i = 0; i < npoints; ++i) {
+            s[i] = s[i] * subinfo.sscale + subinfo.soffset;
+            t[i] = t[i] * subinfo.tscale + subinfo.toffset;
+        }
         dsdx *= subinfo.sscale;
         dsdy *= subinfo.sscale;
-        t = t * subinfo.tscale + subinfo.toffset;
         dtdx *= subinfo.tscale;
         dtdy *= subinfo.tscale;
     }
 
+    // Anisotropic lookups at several points with the same derivatives
+    // share one footprint: the MIP levels and the sampling pattern. The
+    // lookups of nearby points then mostly hit the same tiles, which the
+    // microcache finds again without going to the tile cache.
+    AnisoFootprint footprint;
+    bool shared_footprint = (npoints > 1
+                             && lookup == &TextureSystemImpl::texture_lookup);
+    if (shared_footprint) {
+        footprint.lineweight
+            = OIIO_ALLOCA(float,
+                          round_to_multiple_of_pow2(2 * options.anisotropic,
+                                                    4));
+        aniso_footprint(*texturefile, options, dsdx, dtdx, dsdy, dtdy,
+                        footprint);
+    }
+
+    bool ok = true;
+    for (int i = 0; i < npoints; ++i)
+        ok &= texture_point(*texturefile, thread_info, options, lookup,
+                            shared_footprint ? &footprint : nullptr, spec,
+                            nchannels, actualchannels, s[i], t[i], dsdx,
+                            dtdx, dsdy, dtdy, result + i * nchannels,
+                            dresultds ? dresultds + i * nchannels : nullptr,
+                            dresultdt ? dresultdt + i * nchannels : nullptr);
+    return ok;
+}
+
+
+
+bool
+TextureSystemImpl::texture_point(TextureFile& texturefile,
+                                 PerThreadInfo* thread_info,
+                                 TextureOpt& options,
+                                 texture_lookup_prototype lookup,
+                                 const AnisoFootprint* footprint,
+                                 const ImageSpec& spec, int nchannels,
+                                 int actualchannels, float s, float t,
+                                 float dsdx, float dtdx, float dsdy,
+                                 float dtdy, float* result, float* dresultds,
+                                 float* dresultdt)
+{
+    auto lookup_point = [&](float* r, float* drds, float* drdt) {
+        if (footprint)
+            return texture_lookup_aniso(texturefile, thread_info, options,
+                                        *footprint, nchannels, actualchannels,
+                                        s, t, r, drds, drdt);
+        return (this->*lookup)(texturefile, thread_info, options, nchannels,
+                               actualchannels, s, t, dsdx, dtdx, dsdy, dtdy,
+                               r, drds, drdt);
+    };
+
     bool ok;
     // Everything from the lookup function on down will assume that there
     // is space for a vfloat4 in all of the result locations, so if that's
@@ -1198,9 +1507,7 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
             dresultds = (float*)&dresultds_simd;
             dresultdt = (float*)&dresultdt_simd;
         }
-        ok = (this->*lookup)(*texturefile, thread_info, options, nchannels,
-                             actualchannels, s, t, dsdx, dtdx, dsdy, dtdy,
-                             (float*)&result_simd, dresultds, dresultdt);
+        ok = lookup_point((float*)&result_simd, dresultds, dresultdt);
         if (actualchannels < nchannels && options.firstchannel == 0
             && m_gray_to_rgb)
             fill_gray_channels(spec, nchannels, (float*)&result_simd, dresultds,
@@ -1214,9 +1521,7 @@ TextureSystemImpl::texture(TextureHandle* texture_handle_,
         }
     } else {
         // All provided output slots are aligned 4-floats, use them directly
-        ok = (this->*lookup)(*texturefile, thread_info, options, nchannels,
-                             actualchannels, s, t, dsdx, dtdx, dsdy, dtdy,
-                             result, dresultds, dresultdt);
+        ok = lookup_point(result, dresultds, dresultdt);
         if (actualchannels < nchannels && options.firstchannel == 0
             && m_gray_to_rgb)
             fill_gray_channels(spec, nchannels, result, dresultds, dresultdt);
@@ -1244,14 +1549,41 @@ TextureSystemImpl::texture(ustring filename, TextureOptBatch& options,
 
 
 bool
-TextureSystemImpl::texture(TextureHandle* texture_handle,
-                           Perthread* thread_info, TextureOptBatch& options,
-                           Tex::RunMask mask, const float* s, const float* t,
-                           const float* dsdx, const float* dtdx,
-                           const float* dsdy, const float* dtdy, int nchannels,
-                           float* result, float* dresultds, float* dresultdt)
+TextureSystemImpl::texture(TextureHandle* texture_handle_,
+                           Perthread* thread_info_, TextureOptBatch& options,
+                           Tex::RunMask mask, const float* s_, const float* t_,
+                           const float* dsdx_, const float* dtdx_,
+                           const float* dsdy_, const float* dtdy_,
+                           int nchannels, float* result, float* dresultds,
+                           float* dresultdt)
 {
-    // (FIXME) CHEAT! Texture points individually
+    using Tex::FloatWide;
+    using Tex::IntWide;
+    typedef FloatWide::vbool_t BoolWide;
+
+    // Handle >4 channel lookups by recursion.
+    if (nchannels > 4) {
+        int save_firstchannel = options.firstchannel;
+        bool ok               = true;
+        while (nchannels) {
+            int n = std::min(nchannels, 4);
+            ok &= texture(texture_handle_, thread_info_, options, mask, s_, t_,
+                          dsdx_, dtdx_, dsdy_, dtdy_, n /* chans */, result,
+                          dresultds, dresultdt);
+            result += n * Tex::BatchWidth;
+            if (dresultds)
+                dresultds += n * Tex::BatchWidth;
+            if (dresultdt)
+                dresultdt += n * Tex::BatchWidth;
+            options.firstchannel += n;
+            nchannels -= n;
+        }
+        options.firstchannel = save_firstchannel;  // restore what we changed
+        return ok;
+    }
+
+    zero_lone_derivs(mask, nchannels, dresultds, dresultdt);
+
     TextureOpt opt;
     opt.firstchannel        = options.firstchannel;
     opt.subimage            = options.subimage;
@@ -1266,33 +1598,439 @@ TextureSystemImpl::texture(TextureHandle* texture_handle,
     opt.missingcolor        = options.missingcolor;
     // rwrap not needed for 2D texture
 
-    bool ok          = true;
-    Tex::RunMask bit = 1;
-    for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
-        float r[4], drds[4], drdt[4];  // temp result
-        if (mask & bit) {
-            opt.sblur  = options.sblur[i];
-            opt.tblur  = options.tblur[i];
-            opt.swidth = options.swidth[i];
-            opt.twidth = options.twidth[i];
-            opt.rnd    = options.rnd[i];
-            // rblur, rwidth not needed for 2D texture
-            if (dresultds) {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r,
-                              drds, drdt);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i]    = r[c];
-                    dresultds[c * Tex::BatchWidth + i] = drds[c];
-                    dresultdt[c * Tex::BatchWidth + i] = drdt[c];
+    PerThreadInfo* thread_info = m_imagecache->get_perthread_info(
+        (PerThreadInfo*)thread_info_);
+    TextureFile* texturefile = (TextureFile*)texture_handle_;
+
+    // The batched engine below samples the MIP levels of all the lanes
+    // together, with closest or bilinear interpolation. That includes the
+    // default anisotropic lookups, whose lanes that need bicubic
+    // interpolation (as "smart" bicubic does when magnifying) are looked
+    // up one at a time. Bicubic lookups of the other MIP modes, stochastic
+    // bilinear ones, and UDIM files (whose lanes may each resolve to a
+    // different file) are still textured point by point.
+    bool aniso     = (opt.mipmode == TextureOpt::MipModeDefault
+                  || opt.mipmode == TextureOpt::MipModeAniso
+                  || opt.mipmode == TextureOpt::MipModeStochasticAniso);
+    bool batchable = (aniso || opt.interpmode != TextureOpt::InterpBicubic)
+                     && opt.interpmode != TextureOpt::InterpStochasticBilinear
+                     && !(texturefile && texturefile->is_udim());
+    if (!batchable) {
+        bool ok          = true;
+        Tex::RunMask bit = 1;
+        for (int i = 0; i < Tex::BatchWidth; ++i, bit <<= 1) {
+            float r[4], drds[4], drdt[4];  // temp result
+            if (mask & bit) {
+                opt.sblur  = options.sblur[i];
+                opt.tblur  = options.tblur[i];
+                opt.swidth = options.swidth[i];
+                opt.twidth = options.twidth[i];
+                opt.rnd    = options.rnd[i];
+                // rblur, rwidth not needed for 2D texture
+                if (dresultds) {
+                    ok &= texture(texture_handle_, thread_info_, opt, s_[i],
+                                  t_[i], dsdx_[i], dtdx_[i], dsdy_[i],
+                                  dtdy_[i], nchannels, r, drds, drdt);
+                    for (int c = 0; c < nchannels; ++c) {
+                        result[c * Tex::BatchWidth + i]    = r[c];
+                        dresultds[c * Tex::BatchWidth + i] = drds[c];
+                        dresultdt[c * Tex::BatchWidth + i] = drdt[c];
+                    }
+                } else {
+                    ok &= texture(texture_handle_, thread_info_, opt, s_[i],
+                                  t_[i], dsdx_[i], dtdx_[i], dsdy_[i],
+                                  dtdy_[i], nchannels, r);
+                    for (int c = 0; c < nchannels; ++c) {
+                        result[c * Tex::BatchWidth + i] = r[c];
+                    }
                 }
-            } else {
-                ok &= texture(texture_handle, thread_info, opt, s[i], t[i],
-                              dsdx[i], dtdx[i], dsdy[i], dtdy[i], nchannels, r);
-                for (int c = 0; c < nchannels; ++c) {
-                    result[c * Tex::BatchWidth + i] = r[c];
+            }
+        }
+        return ok;
+    }
+
+    texturefile = verify_texturefile(texturefile, thread_info);
+
+    int nlanes = 0;
+    for (Tex::RunMask m = mask; m; m &= m - 1)
+        ++nlanes;
+    ImageCacheStatistics& stats(thread_info->m_stats);
+    ++stats.texture_batches;
+    stats.texture_queries += nlanes;
+
+    if (!texturefile || texturefile->broken())
+        return missing_texture(options, mask, nchannels, result, dresultds,
+                               dresultdt);
+
+    if (!opt.subimagename.empty()) {
+        // If subimage was specified by name, figure out its index.
+        int s = m_imagecache->subimage_from_name(texturefile, opt.subimagename);
+        if (s < 0) {
+            error("Unknown subimage \"{}\" in texture \"{}\"",
+                  opt.subimagename, texturefile->filename());
+            return missing_texture(options, mask, nchannels, result,
+                                   dresultds, dresultdt);
+        }
+        opt.subimage = s;
+        opt.subimagename.clear();
+    }
+
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile->subimageinfo(opt.subimage));
+    const ImageSpec& spec(texturefile->spec(opt.subimage, 0));
+
+    int actualchannels = OIIO::clamp(spec.nchannels - opt.firstchannel, 0,
+                                     nchannels);
+    bool gray_to_rgb   = (actualchannels < nchannels && opt.firstchannel == 0
+                        && m_gray_to_rgb);
+
+    // Figure out the wrap functions
+    if (opt.swrap == TextureOpt::WrapDefault)
+        opt.swrap = (TextureOpt::Wrap)texturefile->swrap();
+    if (opt.swrap == TextureOpt::WrapPeriodic && ispow2(spec.width))
+        opt.swrap = TextureOpt::WrapPeriodicPow2;
+    if (opt.twrap == TextureOpt::WrapDefault)
+        opt.twrap = (TextureOpt::Wrap)texturefile->twrap();
+    if (opt.twrap == TextureOpt::WrapPeriodic && ispow2(spec.height))
+        opt.twrap = TextureOpt::WrapPeriodicPow2;
+
+    FloatWide r[4], drds[4], drdt[4];
+    for (int c = 0; c < nchannels; ++c) {
+        r[c].clear();
+        drds[c].clear();
+        drdt[c].clear();
+    }
+    bool ok = true;
+
+    if (subinfo.is_constant_image && opt.swrap != TextureOpt::WrapBlack
+        && opt.twrap != TextureOpt::WrapBlack) {
+        // Lookup of constant color texture, non-black wrap -- skip all the
+        // hard stuff. Derivs are always 0 from a constant texture lookup.
+        for (int c = 0; c < actualchannels; ++c)
+            r[c] = FloatWide(subinfo.average_color[c + opt.firstchannel]);
+        for (int c = actualchannels; c < nchannels; ++c)
+            r[c] = FloatWide(opt.fill);
+    } else {
+        FloatWide s(s_), t(t_);
+        FloatWide dsdx(dsdx_), dtdx(dtdx_), dsdy(dsdy_), dtdy(dtdy_);
+        if (m_flip_t) {
+            t    = 1.0f - t;
+            dtdx = -dtdx;
+            dtdy = -dtdy;
+        }
+        if (!subinfo.full_pixel_range) {  // remap st for overscan or crop
+            s = s * subinfo.sscale + subinfo.soffset;
+            dsdx *= subinfo.sscale;
+            dsdy *= subinfo.sscale;
+            t = t * subinfo.tscale + subinfo.toffset;
+            dtdx *= subinfo.tscale;
+            dtdy *= subinfo.tscale;
+        }
+
+        if (aniso) {
+            ok &= texture_lookup_aniso_batch(*texturefile, thread_info, opt,
+                                             options, mask, s, t, dsdx, dtdx,
+                                             dsdy, dtdy, nchannels,
+                                             actualchannels, r,
+                                             dresultds ? drds : nullptr,
+                                             dresultds ? drdt : nullptr);
+        } else {
+            // Determine the MIP-map level(s) of every lane: we will blend
+            //  data(miplevel0) * (1-levelblend) + data(miplevel1) * levelblend
+            // This is the batched equivalent of adjust_width, the filter
+            // width computation of texture_lookup_trilinear_mipmap, and
+            // compute_miplevels.
+            int nmiplevels    = (int)subinfo.levels.size();
+            int min_mip_level = subinfo.min_mip_level;
+            IntWide miplevel0(min_mip_level), miplevel1(min_mip_level);
+            FloatWide levelblend = FloatWide::Zero();
+            if (opt.mipmode != TextureOpt::MipModeNoMIP) {
+                dsdx *= FloatWide(options.swidth);
+                dtdx *= FloatWide(options.twidth);
+                dsdy *= FloatWide(options.swidth);
+                dtdy *= FloatWide(options.twidth);
+                // Clamp degenerate derivatives so they don't cause
+                // mathematical problems
+                static const float eps = 1.0e-8f, eps2 = eps * eps;
+                FloatWide dxlen2 = dsdx * dsdx + dtdx * dtdx;
+                FloatWide dylen2 = dsdy * dsdy + dtdy * dtdy;
+                BoolWide tinydx  = dxlen2 < eps2;
+                BoolWide tinydy  = dylen2 < eps2;
+                if (any(tinydx | tinydy)) {
+                    BoolWide onlydx  = tinydx & !tinydy;
+                    BoolWide onlydy  = tinydy & !tinydx;
+                    BoolWide both    = tinydx & tinydy;
+                    FloatWide xscale = eps / sqrt(max(dxlen2, FloatWide(eps2)));
+                    FloatWide yscale = eps / sqrt(max(dylen2, FloatWide(eps2)));
+                    FloatWide ndsdx  = blend(dsdx, dtdy * yscale, onlydx);
+                    FloatWide ndtdx  = blend(dtdx, -dsdy * yscale, onlydx);
+                    FloatWide ndsdy  = blend(dsdy, -dtdx * xscale, onlydy);
+                    FloatWide ndtdy  = blend(dtdy, dsdx * xscale, onlydy);
+                    dsdx             = blend(ndsdx, FloatWide(eps), both);
+                    dtdx             = blend0not(ndtdx, both);
+                    dsdy             = blend0not(ndsdy, both);
+                    dtdy             = blend(ndtdy, FloatWide(eps), both);
+                }
+                FloatWide sfilt     = max(abs(dsdx), abs(dsdy));
+                FloatWide tfilt     = max(abs(dtdx), abs(dtdy));
+                FloatWide filtwidth = opt.conservative_filter
+                                          ? max(sfilt, tfilt)
+                                          : min(sfilt, tfilt);
+                // account for blur
+                filtwidth += max(FloatWide(options.sblur),
+                                 FloatWide(options.tblur));
+
+                BoolWide found = BoolWide::False();
+                for (int m = min_mip_level; m < nmiplevels; ++m) {
+                    // Once the filter width is smaller than one texel at this
+                    // level, we want to interpolate the previous level and the
+                    // current level.
+                    const ImageSpec& mspec(subinfo.spec(m));
+                    FloatWide filtwidth_ras
+                        = filtwidth
+                          * float(std::min(mspec.width, mspec.height));
+                    BoolWide hit = (filtwidth_ras <= 1.0f) & !found;
+                    if (none(hit))
+                        continue;
+                    miplevel0  = blend(miplevel0, IntWide(m - 1), hit);
+                    miplevel1  = blend(miplevel1, IntWide(m), hit);
+                    levelblend = blend(levelblend,
+                                       min(max(2.0f * filtwidth_ras - 1.0f,
+                                               FloatWide::Zero()),
+                                           FloatWide::One()),
+                                       hit);
+                    found |= hit;
+                    if (all(found))
+                        break;
+                }
+                // Lanes that would like to blur even more make do with the
+                // coarsest MIP level; lanes that wish they had more resolution
+                // than the finest level get the finest.
+                miplevel0  = blend(IntWide(nmiplevels - 1), miplevel0, found);
+                miplevel1  = blend(IntWide(nmiplevels - 1), miplevel1, found);
+                levelblend = blend0(levelblend, found);
+                BoolWide toofine = miplevel0 < min_mip_level;
+                miplevel0  = blend(miplevel0, IntWide(min_mip_level), toofine);
+                miplevel1  = blend(miplevel1, IntWide(min_mip_level), toofine);
+                levelblend = blend0not(levelblend, toofine);
+
+                if (opt.mipmode == TextureOpt::MipModeOneLevel) {
+                    miplevel0  = miplevel1;
+                    levelblend = FloatWide::Zero();
+                } else if (opt.mipmode
+                           == TextureOpt::MipModeStochasticTrilinear) {
+                    // The random deviate picks which ONE of the two MIP
+                    // levels to use, making the same choice as
+                    // compute_miplevels does for a single point.
+                    int usesecond = 0;
+                    for (int i = 0; i < Tex::BatchWidth; ++i) {
+                        float xi = options.rnd[i];
+                        if (stochastic_choice(xi, levelblend[i]))
+                            usesecond |= 1 << i;
+                    }
+                    miplevel1  = blend(miplevel0, miplevel1,
+                                       BoolWide::from_bitmask(usesecond));
+                    miplevel0  = miplevel1;
+                    levelblend = FloatWide::Zero();
                 }
             }
+            FloatWide levelweight0 = 1.0f - levelblend;
+            FloatWide levelweight1 = levelblend;
+
+            // Sample each MIP level that any lane needs, all lanes using
+            // that level at once.
+            BoolWide active = BoolWide::from_bitmask(int(mask));
+            int npointson   = 0;
+            bool first      = true;
+            for (int m = min_mip_level; m < nmiplevels; ++m) {
+                BoolWide use0     = active & (miplevel0 == m)
+                                & (levelweight0 != 0.0f);
+                BoolWide use1     = active & (miplevel1 == m)
+                                & (levelweight1 != 0.0f);
+                Tex::RunMask uses = Tex::RunMask((use0 | use1).bitmask());
+                if (!uses)
+                    continue;
+                for (int b = use0.bitmask(); b; b &= b - 1)
+                    ++npointson;
+                for (int b = use1.bitmask(); b; b &= b - 1)
+                    ++npointson;
+                FloatWide weight = blend0(levelweight0, use0)
+                                   + blend0(levelweight1, use1);
+                ok &= sample_batch(s, t, m, uses, weight, *texturefile,
+                                   thread_info, opt, nchannels, actualchannels,
+                                   first, r, dresultds ? drds : nullptr,
+                                   dresultds ? drdt : nullptr);
+                first = false;
+            }
+
+            // Update stats
+            stats.aniso_queries += npointson;
+            stats.aniso_probes += npointson;
+            if (opt.interpmode == TextureOpt::InterpClosest)
+                stats.closest_interps += npointson;
+            else
+                stats.bilinear_interps += npointson;
+        }
+    }
+
+    if (gray_to_rgb)
+        fill_gray_channels(spec, nchannels, r, drds, drdt);
+    for (int c = 0; c < nchannels; ++c) {
+        r[c].store_mask(int(mask), result + c * Tex::BatchWidth);
+        if (dresultds) {
+            drds[c].store_mask(int(mask), dresultds + c * Tex::BatchWidth);
+            if (m_flip_t)
+                drdt[c] = -drdt[c];
+            drdt[c].store_mask(int(mask), dresultdt + c * Tex::BatchWidth);
+        }
+    }
+    return ok;
+}
+
+
+
+bool
+TextureSystemImpl::texture_lookup_aniso_batch(
+    TextureFile& texturefile, PerThreadInfo* thread_info, TextureOpt& opt,
+    const TextureOptBatch& options, Tex::RunMask lanes,
+    const Tex::FloatWide& s, const Tex::FloatWide& t,
+    const Tex::FloatWide& dsdx, const Tex::FloatWide& dtdx,
+    const Tex::FloatWide& dsdy, const Tex::FloatWide& dtdy,
+    int nchannels_result, int actualchannels, Tex::FloatWide* accum,
+    Tex::FloatWide* daccumds, Tex::FloatWide* daccumdt)
+{
+    using Tex::FloatWide;
+    using Tex::IntWide;
+    typedef FloatWide::vbool_t BoolWide;
+    const int BW = Tex::BatchWidth;
+    ImageCacheStatistics& stats(thread_info->m_stats);
+
+    // The footprint of each lane, exactly as for a single point. Only
+    // closest and bilinear interpolation are batched: like
+    // texture_lookup_aniso, "smart" bicubic uses bicubic on the finest
+    // MIP level or when magnifying, and those lanes go one at a time.
+    int maxlinesamples = round_to_multiple_of_pow2(2 * opt.anisotropic, 4);
+    float* lineweights = OIIO_ALLOCA(float, BW * maxlinesamples);
+    AnisoFootprint footprint[BW];
+    alignas(Tex::BatchAlign) int miplevel[2][BW];
+    alignas(Tex::BatchAlign) int nsamples[BW];
+    alignas(Tex::BatchAlign) float levelweight[2][BW];
+    alignas(Tex::BatchAlign) float smajor[BW], tmajor[BW], invsamples[BW];
+    int pointwise = 0, maxsamples = 0;
+    for (int i = 0; i < BW; ++i) {
+        miplevel[0][i]    = -1;
+        miplevel[1][i]    = -1;
+        levelweight[0][i] = 0.0f;
+        levelweight[1][i] = 0.0f;
+        nsamples[i]       = 0;
+        smajor[i]         = 0.0f;
+        tmajor[i]         = 0.0f;
+        invsamples[i]     = 0.0f;
+        if (!(lanes & (Tex::RunMask(1) << i)))
+            continue;
+        opt.sblur  = options.sblur[i];
+        opt.tblur  = options.tblur[i];
+        opt.swidth = options.swidth[i];
+        opt.twidth = options.twidth[i];
+        opt.rnd    = options.rnd[i];
+        AnisoFootprint& fp(footprint[i]);
+        fp.lineweight = lineweights + i * maxlinesamples;
+        aniso_footprint(texturefile, opt, dsdx[i], dtdx[i], dsdy[i], dtdy[i],
+                        fp);
+        bool bicubic  = false;
+        int npointson = 0;
+        for (int level = 0; level < 2; ++level) {
+            if (!fp.levelweight[level])
+                continue;
+            ++npointson;
+            int lev = fp.miplevel[level];
+            const ImageSpec& spec(texturefile.spec(opt.subimage, lev));
+            if (opt.interpmode == TextureOpt::InterpBicubic
+                || (opt.interpmode == TextureOpt::InterpSmartBicubic
+                    && (lev == 0 || spec.width < fp.naturalsres / 2
+                        || spec.height < fp.naturaltres / 2)))
+                bicubic = true;
+        }
+        if (bicubic) {
+            pointwise |= 1 << i;
+            continue;
+        }
+        miplevel[0][i]    = fp.miplevel[0];
+        miplevel[1][i]    = fp.miplevel[1];
+        levelweight[0][i] = fp.levelweight[0];
+        levelweight[1][i] = fp.levelweight[1];
+        nsamples[i]       = fp.nsamples;
+        smajor[i]         = fp.smajor;
+        tmajor[i]         = fp.tmajor;
+        invsamples[i]     = fp.invsamples;
+        maxsamples        = std::max(maxsamples, fp.nsamples);
+        // Update stats, as texture_lookup_aniso would
+        stats.aniso_queries += npointson;
+        stats.aniso_probes += npointson * fp.nsamples;
+        if (fp.trueaspect > stats.max_aniso)
+            stats.max_aniso = fp.trueaspect;
+        if (opt.interpmode == TextureOpt::InterpClosest)
+            stats.closest_interps += npointson * fp.nsamples;
+        else
+            stats.bilinear_interps += npointson * fp.nsamples;
+    }
+
+    // Take the k-th sample along the major axis of every lane that has
+    // that many, from each MIP level any of them needs, all lanes using
+    // that level at once.
+    bool ok = true;
+    IntWide miplevel0(miplevel[0]), miplevel1(miplevel[1]);
+    FloatWide levelweight0(levelweight[0]), levelweight1(levelweight[1]);
+    IntWide nsamples_wide(nsamples);
+    FloatWide smajor_wide(smajor), tmajor_wide(tmajor);
+    FloatWide invsamples_wide(invsamples);
+    const ImageCacheFile::SubimageInfo& subinfo(
+        texturefile.subimageinfo(opt.subimage));
+    int nmiplevels = (int)subinfo.levels.size();
+    bool first     = true;
+    for (int k = 0; k < maxsamples; ++k) {
+        BoolWide on   = nsamples_wide > k;
+        FloatWide pos = 2.0f * (invsamples_wide * (k + 0.5f) - 0.5f);
+        FloatWide sk  = s + pos * smajor_wide;
+        FloatWide tk  = t + pos * tmajor_wide;
+        alignas(Tex::BatchAlign) float lineweight[BW];
+        for (int i = 0; i < BW; ++i)
+            lineweight[i] = k < nsamples[i] ? footprint[i].lineweight[k]
+                                            : 0.0f;
+        FloatWide lineweight_wide(lineweight);
+        for (int m = subinfo.min_mip_level; m < nmiplevels; ++m) {
+            BoolWide use0 = on & (miplevel0 == m) & (levelweight0 != 0.0f);
+            BoolWide use1 = on & (miplevel1 == m) & (levelweight1 != 0.0f);
+            Tex::RunMask uses = Tex::RunMask((use0 | use1).bitmask());
+            if (!uses)
+                continue;
+            FloatWide weight = lineweight_wide
+                               * (blend0(levelweight0, use0)
+                                  + blend0(levelweight1, use1));
+            ok &= sample_batch(sk, tk, m, uses, weight, texturefile,
+                               thread_info, opt, nchannels_result,
+                               actualchannels, first, accum, daccumds,
+                               daccumdt);
+            first = false;
+        }
+    }
+
+    // The lanes that need bicubic interpolation, one at a time
+    for (int i = 0; pointwise; ++i, pointwise >>= 1) {
+        if (!(pointwise & 1))
+            continue;
+        vfloat4 r, drds, drdt;
+        ok &= texture_lookup_aniso(texturefile, thread_info, opt,
+                                   footprint[i], nchannels_result,
+                                   actualchannels, s[i], t[i], (float*)&r,
+                                   daccumds ? (float*)&drds : nullptr,
+                                   daccumds ? (float*)&drdt : nullptr);
+        for (int c = 0; c < nchannels_result; ++c) {
+            accum[c][i] += r[c];
+            if (daccumds) {
+                daccumds[c][i] += drds[c];
+                daccumdt[c][i] += drdt[c];
+            }
         }
     }
     return ok;
@@ -1321,6 +2059,7 @@ TextureSystemImpl::texture_lookup_nomip(
         &TextureSystemImpl::sample_bilinear,
         &TextureSystemImpl::sample_bicubic,
         &TextureSystemImpl::sample_bilinear,
+        &TextureSystemImpl::sample_closest,  // see below
     };
     sampler_prototype sampler      = sample_functions[(int)options.interpmode];
     OIIO_SIMD4_ALIGN float sval[4] = { s, 0.0f, 0.0f, 0.0f };
@@ -1329,6 +2068,15 @@ TextureSystemImpl::texture_lookup_nomip(
     ImageCacheFile::SubimageInfo& subinfo(
         texturefile.subimageinfo(options.subimage));
     int min_mip_level = subinfo.min_mip_level;
+    bool stochastic = (options.interpmode
+                       == TextureOpt::InterpStochasticBilinear);
+    if (stochastic && dresultds)  // a single texel has no derivatives
+        sampler = &TextureSystemImpl::sample_bilinear;
+    else if (stochastic)
+        stochastic_bilinear_texels(1, sval, tval, texturefile,
+                                   texturefile.spec(options.subimage,
+                                                    min_mip_level),
+                                   options.rnd);
     bool ok = (this->*sampler)(1, sval, tval, min_mip_level, texturefile,
                                thread_info, options, nchannels_result,
                                actualchannels, weight, (vfloat4*)result,
@@ -1343,6 +2091,12 @@ TextureSystemImpl::texture_lookup_nomip(
     case TextureOpt::InterpBilinear: ++stats.bilinear_interps; break;
     case TextureOpt::InterpBicubic: ++stats.cubic_interps; break;
     case TextureOpt::InterpSmartBicubic: ++stats.bilinear_interps; break;
+    case TextureOpt::InterpStochasticBilinear:
+        if (dresultds)
+            ++stats.bilinear_interps;
+        else
+            ++stats.closest_interps;
+        break;
     }
     return ok;
 }
@@ -1459,6 +2213,35 @@ adjust_blur(float& majorlength, float& minorlength, float& theta, float sblur,
 
 
 
+void
+TextureSystemImpl::stochastic_bilinear_texels(int nsamples, float* s,
+                                              float* t,
+                                              TextureFile& texturefile,
+                                              const ImageSpec& spec, float xi)
+{
+    // The size of a texel in (s,t), as st_to_texel maps them.
+    float sscale = 1.0f
+                   / (texturefile.m_sample_border ? std::max(spec.width - 1, 1)
+                                                  : spec.width);
+    float tscale = 1.0f
+                   / (texturefile.m_sample_border ? std::max(spec.height - 1, 1)
+                                                  : spec.height);
+    for (int i = 0; i < nsamples; ++i) {
+        int stex, ttex;
+        float sfrac, tfrac;
+        st_to_texel(s[i], t[i], texturefile, spec, stex, ttex, sfrac, tfrac);
+        // Reusing xi for each sample makes them correlated, but each one
+        // is still unbiased, so their weighted sum is too.
+        float x   = xi;
+        float sto = stochastic_choice(x, sfrac) ? 1.0f : 0.0f;
+        float tto = stochastic_choice(x, tfrac) ? 1.0f : 0.0f;
+        s[i] += (sto - sfrac) * sscale;
+        t[i] += (tto - tfrac) * tscale;
+    }
+}
+
+
+
 // For the given texture file, options, and ellipse major and minor
 // lengths and aspect ratio, compute the two MIPmap levels and
 // respective weights to use for a texture lookup.  The general strategy
@@ -1470,7 +2253,7 @@ adjust_blur(float& majorlength, float& minorlength, float& theta, float sblur,
 inline void
 compute_miplevels(TextureSystemImpl::TextureFile& texturefile,
                   TextureOpt& options, float majorlength, float minorlength,
-                  float& aspect, int* miplevel, float* levelweight)
+                  float& aspect, int* miplevel, float* levelweight, float& xi)
 {
     ImageCacheFile::SubimageInfo& subinfo(
         texturefile.subimageinfo(options.subimage));
@@ -1533,10 +2316,10 @@ compute_miplevels(TextureSystemImpl::TextureFile& texturefile,
         // If using stochastic sampling, the random deviate is a threshold
         // versus the levelblend to determine which ONE of the two MIP
         // levels to use.
-        if (options.rnd > levelblend) {
-            miplevel[1] = miplevel[0];
-        } else {
+        if (stochastic_choice(xi, levelblend)) {
             miplevel[0] = miplevel[1];
+        } else {
+            miplevel[1] = miplevel[0];
         }
         levelblend = 0;
     }
@@ -1574,8 +2357,9 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
     // account for blur
     filtwidth += std::max(options.sblur, options.tblur);
     float aspect = 1.0f;
+    float xi     = options.rnd;
     compute_miplevels(texturefile, options, filtwidth, filtwidth, aspect,
-                      miplevel, levelweight);
+                      miplevel, levelweight, xi);
 
     static const sampler_prototype sample_functions[] = {
         // Must be in the same order as InterpMode enum
@@ -1583,8 +2367,15 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
         &TextureSystemImpl::sample_bilinear,
         &TextureSystemImpl::sample_bicubic,
         &TextureSystemImpl::sample_bilinear,
+        &TextureSystemImpl::sample_closest,  // see below
     };
     sampler_prototype sampler = sample_functions[(int)options.interpmode];
+    bool stochastic = (options.interpmode
+                       == TextureOpt::InterpStochasticBilinear);
+    if (stochastic && dresultds) {  // a single texel has no derivatives
+        sampler    = &TextureSystemImpl::sample_bilinear;
+        stochastic = false;
+    }
 
     // FIXME -- support for smart cubic?
 
@@ -1602,6 +2393,14 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
     for (int level = 0; level < 2; ++level) {
         if (!levelweight[level])  // No contribution from this level, skip it
             continue;
+        if (stochastic) {
+            sval[0] = s;
+            tval[0] = t;
+            stochastic_bilinear_texels(1, sval, tval, texturefile,
+                                       texturefile.spec(options.subimage,
+                                                        miplevel[level]),
+                                       xi);
+        }
         vfloat4 r, drds, drdt;
         ok &= (this->*sampler)(1, sval, tval, miplevel[level], texturefile,
                                thread_info, options, nchannels_result,
@@ -1634,6 +2433,12 @@ TextureSystemImpl::texture_lookup_trilinear_mipmap(
     case TextureOpt::InterpSmartBicubic:
         stats.bilinear_interps += npointson;
         break;
+    case TextureOpt::InterpStochasticBilinear:
+        if (stochastic)
+            stats.closest_interps += npointson;
+        else
+            stats.bilinear_interps += npointson;
+        break;
     }
     return ok;
 }
@@ -1751,31 +2556,25 @@ compute_ellipse_sampling(float aspect, float theta, float majorlength,
 
 
 
-bool
-TextureSystemImpl::texture_lookup(TextureFile& texturefile,
-                                  PerThreadInfo* thread_info,
-                                  TextureOpt& options, int nchannels_result,
-                                  int actualchannels, float s, float t,
-                                  float dsdx, float dtdx, float dsdy,
-                                  float dtdy, float* result, float* dresultds,
-                                  float* dresultdt)
+void
+TextureSystemImpl::aniso_footprint(TextureFile& texturefile,
+                                   TextureOpt& options, float dsdx, float dtdx,
+                                   float dsdy, float dtdy,
+                                   AnisoFootprint& footprint)
 {
-    OIIO_DASSERT((dresultds == NULL) == (dresultdt == NULL));
-
     // Compute the natural resolution we want for the bare derivs, this
     // will be the threshold for knowing we're maxifying (and therefore
     // wanting cubic interpolation).
     float sfilt_noblur = std::max(std::max(fabsf(dsdx), fabsf(dsdy)), 1e-8f);
     float tfilt_noblur = std::max(std::max(fabsf(dtdx), fabsf(dtdy)), 1e-8f);
-    int naturalsres    = (int)(1.0f / sfilt_noblur);
-    int naturaltres    = (int)(1.0f / tfilt_noblur);
+    footprint.naturalsres = (int)(1.0f / sfilt_noblur);
+    footprint.naturaltres = (int)(1.0f / tfilt_noblur);
 
     // Scale by 'width'
     adjust_width(dsdx, dtdx, dsdy, dtdy, options.swidth, options.twidth);
 
     // Determine the MIP-map level(s) we need: we will blend
     //    data(miplevel[0]) * (1-levelblend) + data(miplevel[1]) * levelblend
-    float smajor, tmajor;
     float majorlength, minorlength;
     float theta;
 
@@ -1788,27 +2587,73 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
 
     adjust_blur(majorlength, minorlength, theta, options.sblur, options.tblur);
 
-    float aspect, trueaspect;
-    aspect = anisotropic_aspect(majorlength, minorlength, options, trueaspect);
+    float aspect = anisotropic_aspect(majorlength, minorlength, options,
+                                      footprint.trueaspect);
 
-    int miplevel[2]      = { -1, -1 };
-    float levelweight[2] = { 0, 0 };
+    footprint.miplevel[0]    = -1;
+    footprint.miplevel[1]    = -1;
+    footprint.levelweight[0] = 0.0f;
+    footprint.levelweight[1] = 0.0f;
+    footprint.xi             = options.rnd;
     compute_miplevels(texturefile, options, majorlength, minorlength, aspect,
-                      miplevel, levelweight);
+                      footprint.miplevel, footprint.levelweight, footprint.xi);
 
-    float* lineweight
-        = OIIO_ALLOCA(float,
-                      round_to_multiple_of_pow2(2 * options.anisotropic, 4));
-    float invsamples;
-    int nsamples = compute_ellipse_sampling(aspect, theta, majorlength,
-                                            minorlength, smajor, tmajor,
-                                            invsamples, lineweight);
+    footprint.nsamples = compute_ellipse_sampling(aspect, theta, majorlength,
+                                                  minorlength, footprint.smajor,
+                                                  footprint.tmajor,
+                                                  footprint.invsamples,
+                                                  footprint.lineweight);
     // All the computations were done assuming full diametric axes of
     // the ellipse, but our derivatives are pixel-to-pixel, yielding
     // semi-major and semi-minor lengths, so we need to scale everything
     // by 1/2.
-    smajor *= 0.5f;
-    tmajor *= 0.5f;
+    footprint.smajor *= 0.5f;
+    footprint.tmajor *= 0.5f;
+}
+
+
+
+bool
+TextureSystemImpl::texture_lookup(TextureFile& texturefile,
+                                  PerThreadInfo* thread_info,
+                                  TextureOpt& options, int nchannels_result,
+                                  int actualchannels, float s, float t,
+                                  float dsdx, float dtdx, float dsdy,
+                                  float dtdy, float* result, float* dresultds,
+                                  float* dresultdt)
+{
+    AnisoFootprint footprint;
+    footprint.lineweight
+        = OIIO_ALLOCA(float,
+                      round_to_multiple_of_pow2(2 * options.anisotropic, 4));
+    aniso_footprint(texturefile, options, dsdx, dtdx, dsdy, dtdy, footprint);
+    return texture_lookup_aniso(texturefile, thread_info, options, footprint,
+                                nchannels_result, actualchannels, s, t, result,
+                                dresultds, dresultdt);
+}
+
+
+
+bool
+TextureSystemImpl::texture_lookup_aniso(TextureFile& texturefile,
+                                        PerThreadInfo* thread_info,
+                                        TextureOpt& options,
+                                        const AnisoFootprint& footprint,
+                                        int nchannels_result,
+                                        int actualchannels, float s, float t,
+                                        float* result, float* dresultds,
+                                        float* dresultdt)
+{
+    OIIO_DASSERT((dresultds == NULL) == (dresultdt == NULL));
+
+    const int* miplevel      = footprint.miplevel;
+    const float* levelweight = footprint.levelweight;
+    const float* lineweight  = footprint.lineweight;
+    float smajor             = footprint.smajor;
+    float tmajor             = footprint.tmajor;
+    float invsamples         = footprint.invsamples;
+    int nsamples             = footprint.nsamples;
+    float xi                 = footprint.xi;
 
     bool ok           = true;
     int npointson     = 0;
@@ -1839,6 +2684,31 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
     }
 #endif
 
+    // Stochastic bilinear takes just one texel from each MIP level: first,
+    // just one of the samples along the major axis, chosen with
+    // probability equal to its weight (rescaling xi to be uniform again
+    // within that sample's share of [0,1)); then one of its texels, below.
+    bool stochastic = (options.interpmode
+                       == TextureOpt::InterpStochasticBilinear)
+                      && !dresultds;
+    if (stochastic && nsamples > 1) {
+        int i       = 0;
+        float below = 0.0f;
+        while (i < nsamples - 1 && xi >= below + lineweight[i])
+            below += lineweight[i++];
+        xi = std::min((xi - below) / lineweight[i], 0.99999994f);
+        static const float one = 1.0f;
+        sval[0]    = sval[i];
+        tval[0]    = tval[i];
+        lineweight = &one;
+        nsamples   = 1;
+    }
+
+    // The texel choice moves the sample positions, separately for each
+    // MIP level's texels.
+    float* jsval = OIIO_ALLOCA(float, stochastic ? nsamples : 0);
+    float* jtval = OIIO_ALLOCA(float, stochastic ? nsamples : 0);
+
     vfloat4 r_sum, drds_sum, drdt_sum;
     r_sum.clear();
     if (dresultds) {
@@ -1877,9 +2747,9 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
         case TextureOpt::InterpSmartBicubic:
             if (lev == 0
                 || (texturefile.spec(options.subimage, lev).width
-                    < naturalsres / 2)
+                    < footprint.naturalsres / 2)
                 || (texturefile.spec(options.subimage, lev).height
-                    < naturaltres / 2)) {
+                    < footprint.naturaltres / 2)) {
                 ok &= sample_bicubic(nsamples, sval, tval, lev, texturefile,
                                      thread_info, options, nchannels_result,
                                      actualchannels, lineweight, &r,
@@ -1895,6 +2765,29 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
                 ++bilinearprobes;
             }
             break;
+        case TextureOpt::InterpStochasticBilinear:
+            if (stochastic) {
+                std::copy(sval, sval + nsamples, jsval);
+                std::copy(tval, tval + nsamples, jtval);
+                stochastic_bilinear_texels(nsamples, jsval, jtval,
+                                           texturefile,
+                                           texturefile.spec(options.subimage,
+                                                            lev),
+                                           xi);
+                ok &= sample_closest(nsamples, jsval, jtval, lev,
+                                     texturefile, thread_info, options,
+                                     nchannels_result, actualchannels,
+                                     lineweight, &r, NULL, NULL);
+                ++closestprobes;
+            } else {  // a single texel has no derivatives
+                ok &= sample_bilinear(nsamples, sval, tval, lev, texturefile,
+                                      thread_info, options, nchannels_result,
+                                      actualchannels, lineweight, &r,
+                                      dresultds ? &drds : NULL,
+                                      dresultds ? &drdt : NULL);
+                ++bilinearprobes;
+            }
+            break;
         }
 
         vfloat4 lw = levelweight[level];
@@ -1915,8 +2808,8 @@ TextureSystemImpl::texture_lookup(TextureFile& texturefile,
     ImageCacheStatistics& stats(thread_info->m_stats);
     stats.aniso_queries += npointson;
     stats.aniso_probes += npointson * nsamples;
-    if (trueaspect > stats.max_aniso)
-        stats.max_aniso = trueaspect;  // FIXME?
+    if (footprint.trueaspect > stats.max_aniso)
+        stats.max_aniso = footprint.trueaspect;  // FIXME?
     stats.closest_interps += closestprobes * nsamples;
     stats.bilinear_interps += bilinearprobes * nsamples;
     stats.cubic_interps += bicubicprobes * nsamples;
@@ -1954,9 +2847,12 @@ TextureSystemImpl::pole_color(TextureFile& texturefile,
                 int y = pole * (spec.height - 1);  // 0 or height-1
                 for (int c = 0; c < spec.nchannels; ++c)
                     p[c] = 0.0f;
+                // A constant tile holds just its one pixel
+                int texelstride            = tile->constant() ? 0 : pixelsize;
                 const unsigned char* texel = tile->bytedata()
-                                             + y * spec.tile_width * pixelsize;
-                for (int i = 0; i < width; ++i, texel += pixelsize)
+                                             + y * spec.tile_width
+                                                   * texelstride;
+                for (int i = 0; i < width; ++i, texel += texelstride)
                     for (int c = 0; c < spec.nchannels; ++c) {
                         if (pixeltype == TypeDesc::UINT8)
                             p[c] += uchar2float(texel[c]);
@@ -2081,8 +2977,9 @@ TextureSystemImpl::sample_closest(
             allok = false;
             continue;
         }
-        int offset = id.nchannels() * (tile_t * spec.tile_width + tile_s)
-                     + (firstchannel - id.chbegin());
+        int offset = firstchannel - id.chbegin();
+        if (!tile->constant())
+            offset += id.nchannels() * (tile_t * spec.tile_width + tile_s);
         OIIO_DASSERT((size_t)offset < spec.nchannels * spec.tile_pixels());
         simd::vfloat4 texel_simd;
         if (pixeltype == TypeDesc::UINT8) {
@@ -2265,36 +3162,46 @@ TextureSystemImpl::sample_bilinear(
             if (!tile->valid())
                 return false;
             int pixelsize = tile->pixelsize();
-            int offset    = pixelsize
-                         * (tile_st[T0] * spec.tile_width + tile_st[S0]);
-            const unsigned char* p = tile->bytedata() + offset
-                                     + channelsize
-                                           * (firstchannel - id.chbegin());
-            if (pixeltype == TypeDesc::UINT8) {
-                texel_simd[0][0] = uchar2float4(p);
-                texel_simd[0][1] = uchar2float4(p + pixelsize);
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = uchar2float4(p);
-                texel_simd[1][1] = uchar2float4(p + pixelsize);
-            } else if (pixeltype == TypeDesc::UINT16) {
-                texel_simd[0][0] = ushort2float4((uint16_t*)p);
-                texel_simd[0][1] = ushort2float4((uint16_t*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = ushort2float4((uint16_t*)p);
-                texel_simd[1][1] = ushort2float4((uint16_t*)(p + pixelsize));
-            } else if (pixeltype == TypeDesc::HALF) {
-                texel_simd[0][0] = half2float4((half*)p);
-                texel_simd[0][1] = half2float4((half*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0] = half2float4((half*)p);
-                texel_simd[1][1] = half2float4((half*)(p + pixelsize));
+            int offset    = channelsize * (firstchannel - id.chbegin());
+            if (tile->constant()) {
+                // All four texels are the tile's one pixel
+                texel_simd[0][0] = load_texel4(pixeltype,
+                                               tile->bytedata() + offset);
+                texel_simd[0][1] = texel_simd[0][0];
+                texel_simd[1][0] = texel_simd[0][0];
+                texel_simd[1][1] = texel_simd[0][0];
             } else {
-                OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
-                texel_simd[0][0].load((const float*)p);
-                texel_simd[0][1].load((const float*)(p + pixelsize));
-                p += pixelsize * spec.tile_width;
-                texel_simd[1][0].load((const float*)p);
-                texel_simd[1][1].load((const float*)(p + pixelsize));
+                offset += pixelsize
+                          * (tile_st[T0] * spec.tile_width + tile_st[S0]);
+                const unsigned char* p = tile->bytedata() + offset;
+                if (pixeltype == TypeDesc::UINT8) {
+                    texel_simd[0][0] = uchar2float4(p);
+                    texel_simd[0][1] = uchar2float4(p + pixelsize);
+                    p += pixelsize * spec.tile_width;
+                    texel_simd[1][0] = uchar2float4(p);
+                    texel_simd[1][1] = uchar2float4(p + pixelsize);
+                } else if (pixeltype == TypeDesc::UINT16) {
+                    texel_simd[0][0] = ushort2float4((uint16_t*)p);
+                    texel_simd[0][1] = ushort2float4(
+                        (uint16_t*)(p + pixelsize));
+                    p += pixelsize * spec.tile_width;
+                    texel_simd[1][0] = ushort2float4((uint16_t*)p);
+                    texel_simd[1][1] = ushort2float4(
+                        (uint16_t*)(p + pixelsize));
+                } else if (pixeltype == TypeDesc::HALF) {
+                    texel_simd[0][0] = half2float4((half*)p);
+                    texel_simd[0][1] = half2float4((half*)(p + pixelsize));
+                    p += pixelsize * spec.tile_width;
+                    texel_simd[1][0] = half2float4((half*)p);
+                    texel_simd[1][1] = half2float4((half*)(p + pixelsize));
+                } else {
+                    OIIO_DASSERT(pixeltype == TypeDesc::FLOAT);
+                    texel_simd[0][0].load((const float*)p);
+                    texel_simd[0][1].load((const float*)(p + pixelsize));
+                    p += pixelsize * spec.tile_width;
+                    texel_simd[1][0].load((const float*)p);
+                    texel_simd[1][1].load((const float*)(p + pixelsize));
+                }
             }
         } else {
             bool noreusetile      = (options.swrap == TextureOpt::WrapMirror);
@@ -2329,9 +3236,10 @@ TextureSystemImpl::sample_bilinear(
                     }
                     TileRef& tile(thread_info->tile);
                     int pixelsize = tile->pixelsize();
-                    int offset    = pixelsize
-                                 * (tile_t * spec.tile_width + tile_s);
-                    offset += (firstchannel - id.chbegin()) * channelsize;
+                    int offset    = (firstchannel - id.chbegin()) * channelsize;
+                    if (!tile->constant())
+                        offset += pixelsize
+                                  * (tile_t * spec.tile_width + tile_s);
                     OIIO_DASSERT(offset < spec.tile_width * spec.tile_height
                                               * spec.tile_depth * pixelsize);
                     if (pixeltype == TypeDesc::UINT8)
@@ -2408,6 +3316,233 @@ TextureSystemImpl::sample_bilinear(
 }
 
 
+bool
+TextureSystemImpl::sample_batch(const Tex::FloatWide& s_,
+                                const Tex::FloatWide& t_, int miplevel,
+                                Tex::RunMask lanes,
+                                const Tex::FloatWide& weight_,
+                                TextureFile& texturefile,
+                                PerThreadInfo* thread_info, TextureOpt& options,
+                                int nchannels_result, int actualchannels,
+                                bool mark_first_tile_used,
+                                Tex::FloatWide* accum, Tex::FloatWide* daccumds,
+                                Tex::FloatWide* daccumdt)
+{
+    using Tex::FloatWide;
+    using Tex::IntWide;
+    typedef FloatWide::vbool_t BoolWide;
+
+    const ImageSpec& spec(texturefile.spec(options.subimage, miplevel));
+    const ImageCacheFile::LevelInfo& levelinfo(
+        texturefile.levelinfo(options.subimage, miplevel));
+    TypeDesc::BASETYPE pixeltype = texturefile.pixeltype(options.subimage);
+    wrap_impl_wide swrap_func    = wrap_functions_wide[(int)options.swrap];
+    wrap_impl_wide twrap_func    = wrap_functions_wide[(int)options.twrap];
+    bool closest  = (options.interpmode == TextureOpt::InterpClosest);
+    bool use_fill = (nchannels_result > actualchannels && options.fill);
+    bool tilepow2 = ispow2(spec.tile_width) && ispow2(spec.tile_height);
+    int tile_chbegin = 0, tile_chend = spec.nchannels;
+    // need_pole: do we potentially need to fade to special pole color?
+    // If we do, can't restrict channel range or pole_color won't work.
+    bool need_pole = (options.envlayout == LayoutLatLong && levelinfo.onetile
+                      && !closest);
+    if (spec.nchannels > m_max_tile_channels && !need_pole) {
+        // For files with many channels, narrow the range we cache
+        tile_chbegin = options.firstchannel;
+        tile_chend   = options.firstchannel + actualchannels;
+    }
+    TileID id(texturefile, options.subimage, miplevel, 0, 0, 0, tile_chbegin,
+              tile_chend);
+    int channelsize = int(texturefile.channelsize(options.subimage));
+    int pixelsize   = channelsize * id.nchannels();
+    int chanoffset  = channelsize * (options.firstchannel - id.chbegin());
+
+    // Texel coordinates of all lanes at once, as in st_to_texel_simd.
+    FloatWide s, t;
+    if (texturefile.sample_border() == 0) {
+        s = s_ * float(spec.width) + (spec.x - 0.5f);
+        t = t_ * float(spec.height) + (spec.y - 0.5f);
+    } else {
+        s = s_ * float(spec.width - 1) + float(spec.x);
+        t = t_ * float(spec.height - 1) + float(spec.y);
+    }
+    IntWide sint, tint;
+    FloatWide sfrac = floorfrac(s, &sint);
+    FloatWide tfrac = floorfrac(t, &tint);
+
+    // Columns [0..1] and rows [0..1] of the texels we need, wrapped, and
+    // which of them are valid (false means black border). Closest
+    // interpolation only needs the nearest texel, column 0 and row 0.
+    int ntexels = closest ? 1 : 2;
+    IntWide stex[2], ttex[2];
+    if (closest) {
+        stex[0] = blend(sint, sint + 1, sfrac > 0.5f);
+        ttex[0] = blend(tint, tint + 1, tfrac > 0.5f);
+    } else {
+        stex[0] = sint;
+        stex[1] = sint + 1;
+        ttex[0] = tint;
+        ttex[1] = tint + 1;
+    }
+    IntWide x(spec.x), y(spec.y), width(spec.width), height(spec.height);
+    BoolWide svalid[2], tvalid[2];
+    IntWide colbytes[2], rowbytes[2];  // texel offsets within the tile
+    IntWide tile_x[2], tile_y[2];      // coordinates of the tile origins
+    for (int i = 0; i < ntexels; ++i) {
+        svalid[i] = swrap_func(stex[i], x, width);
+        tvalid[i] = twrap_func(ttex[i], y, height);
+        if (!levelinfo.full_pixel_range) {
+            // Account for crop windows
+            svalid[i] &= (stex[i] >= x) & (stex[i] < (x + width));
+            tvalid[i] &= (ttex[i] >= y) & (ttex[i] < (y + height));
+        }
+        IntWide tile_s = stex[i] - x;
+        IntWide tile_t = ttex[i] - y;
+        if (tilepow2) {
+            tile_s &= (spec.tile_width - 1);
+            tile_t &= (spec.tile_height - 1);
+        } else {
+            tile_s = tile_s % spec.tile_width;
+            tile_t = tile_t % spec.tile_height;
+        }
+        tile_x[i]   = stex[i] - tile_s;
+        tile_y[i]   = ttex[i] - tile_t;
+        colbytes[i] = tile_s * pixelsize + chanoffset;
+        rowbytes[i] = tile_t * (spec.tile_width * pixelsize);
+    }
+
+    // Gather the texels, laid out like the batch results, [channel][lane]
+    // for each of the 2x2 texels. Lanes of a coherent batch usually fall
+    // on the same tile, so we only go back to the cache when a texel is on
+    // a different tile than the previous one.
+    alignas(Tex::BatchAlign) float texels[2][2][4][Tex::BatchWidth];
+    BoolWide texelvalid[2][2];
+    int lanesok                 = int(lanes);
+    const unsigned char* pixels = nullptr;
+    bool constant               = false;  // Is the current tile constant?
+    int curtile_x = 0, curtile_y = 0;
+    for (int j = 0; j < ntexels; ++j) {
+        for (int i = 0; i < ntexels; ++i) {
+            // Lanes that get no texel still get loaded below, so make sure
+            // they aren't garbage.
+            for (int c = 0; c < actualchannels; ++c)
+                FloatWide::Zero().store(texels[j][i][c]);
+            texelvalid[j][i] = svalid[i] & tvalid[j]
+                               & BoolWide::from_bitmask(int(lanes));
+            int todo = texelvalid[j][i].bitmask();
+            for (int lane = 0; todo; ++lane, todo >>= 1) {
+                if (!(todo & 1))
+                    continue;
+                if (!pixels || tile_x[i][lane] != curtile_x
+                    || tile_y[j][lane] != curtile_y) {
+                    curtile_x = tile_x[i][lane];
+                    curtile_y = tile_y[j][lane];
+                    id.xy(curtile_x, curtile_y);
+                    bool ok = find_tile(id, thread_info, mark_first_tile_used);
+                    mark_first_tile_used = false;
+                    if (!ok)
+                        error("{}", m_imagecache->geterror());
+                    TileRef& tile(thread_info->tile);
+                    if (!ok || !tile || !tile->valid()) {
+                        pixels = nullptr;
+                        lanesok &= ~(1 << lane);
+                        continue;
+                    }
+                    // N.B. thread_info->tile will keep holding a ref-counted
+                    // pointer to the tile for as long as we use its pixels.
+                    pixels   = tile->bytedata();
+                    constant = tile->constant();
+                }
+                // A constant tile holds just its one pixel
+                vfloat4 texel = load_texel4(
+                    pixeltype, constant ? pixels + chanoffset
+                                        : pixels + rowbytes[j][lane]
+                                              + colbytes[i][lane]);
+                for (int c = 0; c < actualchannels; ++c)
+                    texels[j][i][c][lane] = texel[c];
+            }
+            // Lanes that couldn't get at their tile contribute nothing
+            texelvalid[j][i] &= BoolWide::from_bitmask(lanesok);
+        }
+    }
+    FloatWide weight = blend0(weight_, BoolWide::from_bitmask(lanesok));
+
+    // When we're on the lowest res mipmap levels, it's more pleasing if
+    // we converge to a single pole color right at the pole. Fade the lanes
+    // within a texel of either pole to its average color, as fade_to_pole
+    // does for single points.
+    if (need_pole && pixels) {
+        float height = spec.height;
+        if (texturefile.m_sample_border)
+            height -= 1.0f;
+        FloatWide tt   = t_ * height;
+        BoolWide north = tt < 1.0f;
+        BoolWide fade  = (north | (tt > (height - 1.0f)))
+                        & BoolWide::from_bitmask(lanesok);
+        if (any(fade)) {
+            // N.B. the level is one tile, which thread_info->tile holds.
+            const float* northcolor = pole_color(texturefile, thread_info,
+                                                 levelinfo, thread_info->tile,
+                                                 options.subimage, miplevel, 0);
+            const float* southcolor = pole_color(texturefile, thread_info,
+                                                 levelinfo, thread_info->tile,
+                                                 options.subimage, miplevel, 1);
+            FloatWide pole = blend(tt - floor(tt), 1.0f - tt, north);
+            pole           = min(max(pole, FloatWide::Zero()), FloatWide::One());
+            pole *= pole;  // squaring makes more pleasing appearance
+            pole = blend0(pole, fade);
+            for (int c = 0; c < actualchannels; ++c) {
+                int ch = options.firstchannel + c;
+                accum[c] += weight * pole
+                            * blend(FloatWide(southcolor[ch]),
+                                    FloatWide(northcolor[ch]), north);
+            }
+            weight *= 1.0f - pole;
+        }
+    }
+
+    // Now filter all the lanes together, one channel at a time.
+    for (int c = 0; c < actualchannels; ++c) {
+        if (closest) {
+            FloatWide texel = blend0(FloatWide(texels[0][0][c]),
+                                     texelvalid[0][0]);
+            accum[c] += weight * texel;
+            // constant interp has 0 derivatives
+            continue;
+        }
+        FloatWide t00 = blend0(FloatWide(texels[0][0][c]), texelvalid[0][0]);
+        FloatWide t01 = blend0(FloatWide(texels[0][1][c]), texelvalid[0][1]);
+        FloatWide t10 = blend0(FloatWide(texels[1][0][c]), texelvalid[1][0]);
+        FloatWide t11 = blend0(FloatWide(texels[1][1][c]), texelvalid[1][1]);
+        accum[c] += weight * bilerp(t00, t01, t10, t11, sfrac, tfrac);
+        if (daccumds) {
+            FloatWide scalex = weight * float(spec.width);
+            FloatWide scaley = weight * float(spec.height);
+            daccumds[c] += scalex * lerp(t01 - t00, t11 - t10, tfrac);
+            daccumdt[c] += scaley * lerp(t10 - t00, t11 - t01, sfrac);
+        }
+    }
+    if (use_fill) {
+        // Add the weighted fill color to the extra channels, in proportion
+        // to how much of the footprint was within the non-"black"-wrapped
+        // region.
+        FloatWide f;
+        if (closest)
+            f = blend0(FloatWide::One(), texelvalid[0][0]);
+        else
+            f = bilerp(blend0(FloatWide::One(), texelvalid[0][0]),
+                       blend0(FloatWide::One(), texelvalid[0][1]),
+                       blend0(FloatWide::One(), texelvalid[1][0]),
+                       blend0(FloatWide::One(), texelvalid[1][1]), sfrac,
+                       tfrac);
+        for (int c = actualchannels; c < nchannels_result; ++c)
+            accum[c] += weight * f * options.fill;
+    }
+    return lanesok == int(lanes);
+}
+
+
+
 namespace {
 
     // Evaluate Bspline weights for both value and derivatives (if dw is not
@@ -2632,11 +3767,18 @@ TextureSystemImpl::sample_bicubic(
             }
             // N.B. thread_info->tile will keep holding a ref-counted pointer
             // to the tile for the duration that we're using the tile data.
-            int offset = pixelsize * (tile_t * spec.tile_width + tile_s);
-            const unsigned char* base = tile->bytedata() + offset
-                                        + firstchannel_offset_bytes;
+            int offset = firstchannel_offset_bytes;
+            if (!tile->constant())
+                offset += pixelsize * (tile_t * spec.tile_width + tile_s);
+            const unsigned char* base = tile->bytedata() + offset;
             OIIO_DASSERT(tile->data());
-            if (pixeltype == TypeDesc::UINT8) {
+            if (tile->constant()) {
+                // All sixteen texels are the tile's one pixel
+                simd::vfloat4 texel = load_texel4(pixeltype, base);
+                for (int j = 0; j < 4; ++j)
+                    for (int i = 0; i < 4; ++i)
+                        texel_simd[j][i] = texel;
+            } else if (pixeltype == TypeDesc::UINT8) {
                 for (int j = 0, j_offset = 0; j < 4;
                      ++j, j_offset += pixelsize * spec.tile_width)
                     for (int i = 0, i_offset = j_offset; i < 4;
@@ -2703,6 +3845,8 @@ TextureSystemImpl::sample_bicubic(
                     TileRef& tile(thread_info->tile);
                     OIIO_DASSERT(tile->data());
                     int offset = row_offset_bytes + column_offset_bytes[i];
+                    if (tile->constant())  // It holds just its one pixel
+                        offset = firstchannel_offset_bytes;
                     // const unsigned char *pixelptr = tile->bytedata() + offset[i];
                     if (pixeltype == TypeDesc::UINT8)
                         texel_simd[j][i] = uchar2float4(tile->bytedata()
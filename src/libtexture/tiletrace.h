@@ -0,0 +1,62 @@
+// Copyright 2008-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/OpenImageIO/oiio
+
+
+/// \file
+/// The binary format of ImageCache tile lookup traces (written when the
+/// "trace_file" attribute is set, and replayed by the tilereplay tool).
+
+
+#ifndef OPENIMAGEIO_TILETRACE_H
+#define OPENIMAGEIO_TILETRACE_H
+
+#include <cstdint>
+
+#include <OpenImageIO/oiioversion.h>
+
+
+OIIO_NAMESPACE_BEGIN
+
+namespace pvt {
+
+// A trace file starts with these 8 bytes, and is followed by chunks, each
+// starting with a uint32_t tag:
+//   - TileTraceFileTag: uint32_t file index, uint32_t name length, then
+//     the bytes of the file name. This comes before any tile record that
+//     uses the index.
+//   - TileTraceTilesTag: uint32_t count, then that many TileTraceRecords.
+// Everything is in the byte order of the machine that wrote the trace.
+static const char tile_trace_magic[8] = { 'O', 'I', 'I', 'O',
+                                          't', 'r', 'c', '1' };
+
+enum TileTraceTag : uint32_t {
+    TileTraceFileTag  = 0x656c6966,  // "file"
+    TileTraceTilesTag = 0x656c6974,  // "tile"
+};
+
+enum TileTraceFlags : uint32_t {
+    TileTraceHit = 1,  ///< The tile was in the cache already
+};
+
+/// One tile lookup that got past the per-thread microcache to the main
+/// tile cache.
+struct TileTraceRecord {
+    uint64_t time;      ///< Nanoseconds since the trace started
+    uint32_t file;      ///< Index of the file name
+    uint16_t subimage;  ///< Subimage of the tile
+    uint16_t miplevel;  ///< MIP level of the tile
+    int32_t x, y, z;    ///< Origin of the tile
+    int16_t chbegin;    ///< First channel of the tile
+    int16_t chend;      ///< One past its last channel
+    uint32_t thread;    ///< Which thread looked it up
+    uint32_t flags;     ///< TileTraceFlags
+};
+
+static_assert(sizeof(TileTraceRecord) == 40, "TileTraceRecord has padding");
+
+}  // namespace pvt
+
+OIIO_NAMESPACE_END
+
+#endif  // OPENIMAGEIO_TILETRACE_H
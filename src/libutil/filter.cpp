@@ -20,6 +20,7 @@
 
 
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <iostream>
@@ -28,6 +29,7 @@
 #include <OpenImageIO/dassert.h>
 #include <OpenImageIO/filter.h>
 #include <OpenImageIO/fmath.h>
+#include <OpenImageIO/simd.h>
 
 
 OIIO_NAMESPACE_BEGIN
@@ -1015,4 +1017,75 @@ Filter2D::destroy(Filter2D* filt)
 }
 
 
+
+template<typename F>
+void
+FilterTable::Profile::init(float width_, int resolution, F&& f)
+{
+    resolution = std::max(2, resolution & ~1);  // even, so 0 is an entry
+    width      = width_;
+    rad        = 0.5f * width;
+    scale      = width > 0.0f ? resolution / width : 0.0f;
+    table.resize(resolution + 1);
+    for (int i = 0; i <= resolution; ++i)
+        table[i] = f(float(i) / scale - rad);
+    // The end entries are the limits from inside the filter, which differ
+    // from the values exactly at the edges for truncated filters.
+    float inside  = std::nextafter(rad, 0.0f);
+    edge[0]       = f(-rad);
+    edge[1]       = f(rad);
+    table.front() = f(-inside);
+    table.back()  = f(inside);
+}
+
+
+
+void
+FilterTable::Profile::eval(float x0, float dx, int n, float* w) const
+{
+    using namespace simd;
+    vfloat8 x = vfloat8::Iota(x0, dx);
+    for (int i = 0; i < n; i += 8, x += vfloat8(8.0f * dx)) {
+        vfloat8 u = (x + vfloat8(rad)) * vfloat8(scale);
+        vint8 j   = min(max(ifloor(u), vint8::Zero()),
+                        vint8(int(table.size()) - 2));
+        vfloat8 f = u - vfloat8(j);
+        vfloat8 a, b;
+        a.gather(table.data(), j);
+        b.gather(table.data() + 1, j);
+        vfloat8 ax = abs(x);
+        vfloat8 r  = select(ax < vfloat8(rad), madd(f, b - a, a),
+                            vfloat8::Zero());
+        r = select(ax == vfloat8(rad),
+                   select(x > vfloat8::Zero(), vfloat8(edge[1]),
+                          vfloat8(edge[0])),
+                   r);
+        if (i + 8 <= n)
+            r.store(w + i);
+        else
+            r.store(w + i, n - i);
+    }
+}
+
+
+
+FilterTable::FilterTable(const Filter1D& filter, int resolution)
+{
+    m_x.init(filter.width(), resolution, [&](float x) { return filter(x); });
+    m_y = m_x;
+}
+
+
+
+FilterTable::FilterTable(const Filter2D& filter, int resolution)
+{
+    m_x.init(filter.width(), resolution,
+             [&](float x) { return filter.xfilt(x); });
+    m_y.init(filter.height(), resolution,
+             [&](float y) { return filter.yfilt(y); });
+    if (!filter.separable())
+        m_filter2d = &filter;
+}
+
+
 OIIO_NAMESPACE_END
@@ -76,6 +76,8 @@ public:
                                       void* data) override;
     virtual bool read_native_tile(int subimage, int miplevel, int x, int y,
                                   int z, void* data) override;
+    virtual bool tile_constant_value(int subimage, int miplevel, int x, int y,
+                                     int z, void* pixel) override;
 
 private:
     std::string m_filename;        ///< Stash the filename
@@ -400,4 +402,18 @@ NullInput::read_native_tile(int /*subimage*/, int /*miplevel*/, int /*x*/,
 }
 
 
+
+bool
+NullInput::tile_constant_value(int /*subimage*/, int /*miplevel*/, int /*x*/,
+                               int /*y*/, int /*z*/, void* pixel)
+{
+    // Every tile is the same
+    if (m_value.size())
+        memcpy(pixel, m_value.data(), m_spec.pixel_bytes());
+    else
+        memset(pixel, 0, m_spec.pixel_bytes());
+    return true;
+}
+
+
 OIIO_PLUGIN_NAMESPACE_END
@@ -70,7 +70,8 @@ public:
     virtual const char* format_name(void) const override { return "openvdb"; }
     virtual int supports(string_view feature) const override
     {
-        return (feature == "arbitrary_metadata");
+        return (feature == "arbitrary_metadata"
+                || feature == "constant_tiles");
     }
     virtual bool valid_file(const std::string& filename) const override;
     virtual bool open(const std::string& name, ImageSpec& newspec) override;
@@ -82,6 +83,8 @@ public:
                                       void* data) override;
     virtual bool read_native_tile(int subimage, int miplevel, int x, int y,
                                   int z, void* data) override;
+    virtual bool tile_constant_value(int subimage, int miplevel, int x, int y,
+                                     int z, void* pixel) override;
 
     ImageSpec spec(int subimage, int miplevel) override;
     ImageSpec spec_dimensions(int subimage, int miplevel) override;
@@ -225,6 +228,25 @@ template<typename GridType> struct VDBReader {
         return true;
     }
 
+    // Most of a sparse volume is not stored in leaf nodes, and has the
+    // value of the tile (or background) above it. Report that value
+    // without making a dense block, and likewise for constant leaves.
+    static bool constantTile(const GridType& grid, int x, int y, int z,
+                             ValueType* value)
+    {
+        enum { kOffset = LeafType::DIM / 2 };
+        const openvdb::Coord xyz(x + kOffset, y + kOffset, z + kOffset);
+        const RootType& root = grid.tree().root();
+        typename GridType::ConstAccessor cache = grid.getConstAccessor();
+        if (auto* leaf = root.probeConstLeafAndCache(xyz, cache)) {
+            bool active;
+            return leaf->getNodeBoundingBox().min() == Coord(x, y, z)
+                   && leaf->isConstant(*value, active);
+        }
+        *value = cache.getValue(xyz);
+        return true;
+    }
+
     static void fillSpec(const CoordBBox& bounds, const Coord& dim,
                          ImageSpec& spec)
     {
@@ -578,6 +600,31 @@ OpenVDBInput::read_native_tile(int subimage, int miplevel, int x, int y, int z,
 
 
 
+bool
+OpenVDBInput::tile_constant_value(int subimage, int miplevel, int x, int y,
+                                  int z, void* pixel)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage_nolock(subimage, miplevel))
+        return false;
+
+    const layerrecord& lay = m_layers[m_subimage];
+    switch (lay.spec.nchannels) {
+    case 1:
+        return VDBReader<FloatGrid>::constantTile(
+            *gridPtrCast<ScalarGrid>(lay.grid), x, y, z,
+            reinterpret_cast<float*>(pixel));
+    case 3:
+        return VDBReader<Vec3fGrid>::constantTile(
+            *gridPtrCast<Vec3fGrid>(lay.grid), x, y, z,
+            reinterpret_cast<Vec3f*>(pixel));
+    default: break;
+    }
+    return false;
+}
+
+
+
 // Obligatory material to make this a recognizeable imageio plugin:
 OIIO_PLUGIN_EXPORTS_BEGIN
 
@@ -151,7 +151,31 @@ declare_imagecache(py::module& m)
                 py::gil_scoped_release gil;
                 ic.m_cache->invalidate_all(force);
             },
-            "force"_a = false);
+            "force"_a = false)
+        .def(
+            "prefetch",
+            [](ImageCacheWrap& ic, const std::string& filename, int subimage,
+               int miplevel, ROI roi, int chbegin, int chend) {
+                py::gil_scoped_release gil;
+                return ic.m_cache->prefetch(ustring(filename), subimage,
+                                            miplevel, roi, chbegin, chend);
+            },
+            "filename"_a, "subimage"_a = 0, "miplevel"_a = 0,
+            "roi"_a = ROI::All(), "chbegin"_a = 0, "chend"_a = -1)
+        .def(
+            "write_tile_manifest",
+            [](ImageCacheWrap& ic, const std::string& filename) {
+                py::gil_scoped_release gil;
+                return ic.m_cache->write_tile_manifest(filename);
+            },
+            "filename"_a)
+        .def(
+            "preload_tile_manifest",
+            [](ImageCacheWrap& ic, const std::string& filename, bool wait) {
+                py::gil_scoped_release gil;
+                return ic.m_cache->preload_tile_manifest(filename, wait);
+            },
+            "filename"_a, "wait"_a = true);
 }
 
 }  // namespace PyOpenImageIO
@@ -89,7 +89,9 @@ declare_mipmpode(py::module& m)
         .value("NoMIP", Tex::MipMode::NoMIP)
         .value("OneLevel", Tex::MipMode::OneLevel)
         .value("Trilinear", Tex::MipMode::Trilinear)
-        .value("Aniso", Tex::MipMode::Aniso);
+        .value("Aniso", Tex::MipMode::Aniso)
+        .value("StochasticTrilinear", Tex::MipMode::StochasticTrilinear)
+        .value("StochasticAniso", Tex::MipMode::StochasticAniso);
 }
 
 
@@ -101,7 +103,8 @@ declare_interpmode(py::module& m)
         .value("Closest", Tex::InterpMode::Closest)
         .value("Bilinear", Tex::InterpMode::Bilinear)
         .value("Bicubic", Tex::InterpMode::Bicubic)
-        .value("SmartBicubic", Tex::InterpMode::SmartBicubic);
+        .value("SmartBicubic", Tex::InterpMode::SmartBicubic)
+        .value("StochasticBilinear", Tex::InterpMode::StochasticBilinear);
 }
 
 
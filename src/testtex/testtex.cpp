@@ -82,6 +82,7 @@ static bool test_statquery         = false;
 static bool invalidate_before_iter = true;
 static bool close_before_iter      = false;
 static bool runstats               = false;
+static bool batchbench             = false;
 static Imath::M33f xform;
 static std::string texoptions;
 static std::string gtiname;
@@ -221,6 +222,8 @@ getargs(int argc, const char* argv[])
       .help("Test queries of statistics");
     ap.arg("--runstats", &runstats)
       .help("Print runtime statistics");
+    ap.arg("--batchbench", &batchbench)
+      .help("Time single point versus batched environment and volume lookups");
 
     // clang-format on
     ap.parse(argc, argv);
@@ -934,6 +937,28 @@ tex3d_region_batch(ImageBuf& image, ustring filename, Mapping3DWide mapping,
 
 
 
+// Time single point versus batched lookups of the same points, reporting
+// the throughput of each. render(use_batch) does all the lookups of the
+// test once, returning the time it took. One untimed pass comes first, so
+// that both timings start with the cache full.
+static void
+batch_benchmark(string_view what, function_view<double(bool)> render)
+{
+    double lookups = double(output_xres) * output_yres * iters;
+    render(batch);
+    double single  = render(false);
+    double batched = render(true);
+    Strutil::print("{} lookups: {} per run ({} x {} x {} iters)\n", what,
+                   lookups, output_xres, output_yres, iters);
+    Strutil::print("  single point: {:8.3f} s  {:8.2f} Mlookups/s\n", single,
+                   lookups / single * 1.0e-6);
+    Strutil::print("  batch of {:2d}: {:8.3f} s  {:8.2f} Mlookups/s  ({:.2f}x)\n",
+                   Tex::BatchWidth, batched, lookups / batched * 1.0e-6,
+                   single / batched);
+}
+
+
+
 void
 test_texture3d(ustring filename, Mapping3D mapping)
 {
@@ -996,11 +1021,196 @@ test_texture3d_batch(ustring filename, Mapping3DWide mapping)
 
 
 
+void
+bench_texture3d(ustring filename, Mapping3D mapping,
+                Mapping3DWide mapping_wide)
+{
+    std::cout << "Timing 3d texture " << filename << "\n";
+    int nchannels = nchannels_override ? nchannels_override : 4;
+    ImageSpec outspec(output_xres, output_yres, nchannels, TypeDesc::FLOAT);
+    ImageBuf image(outspec);
+    OIIO::ImageBufAlgo::zero(image);
+
+    batch_benchmark("Volume", [&](bool use_batch) {
+        Timer timer;
+        for (int iter = 0; iter < iters; ++iter) {
+            if (close_before_iter)
+                texsys->close_all();
+            ImageBufAlgo::parallel_image(
+                get_roi(image.spec()), nthreads, [&](ROI roi) {
+                    if (use_batch)
+                        tex3d_region_batch(image, filename, mapping_wide, roi);
+                    else
+                        tex3d_region(image, filename, mapping, roi);
+                });
+        }
+        return timer();
+    });
+}
+
+
+
 static void test_shadow(ustring /*filename*/) {}
 
 
 
-static void test_environment(ustring /*filename*/) {}
+// Map the output image to the whole sphere of directions, as a lat-long
+// environment map would be laid out (z is up, y at the center), with the
+// ray differentials of one pixel step.
+static void
+map_env(int x, int y, Imath::V3f& R, Imath::V3f& dRdx, Imath::V3f& dRdy)
+{
+    float dphi   = float(2.0 * M_PI) / output_xres;
+    float dtheta = float(M_PI) / output_yres;
+    float phi    = (x + 0.5f) * dphi + texoffset[0];
+    float theta  = (y + 0.5f) * dtheta + texoffset[1];
+    float sinphi, cosphi, sintheta, costheta;
+    sincos(phi, &sinphi, &cosphi);
+    sincos(theta, &sintheta, &costheta);
+    R    = Imath::V3f(-sintheta * cosphi, -sintheta * sinphi, costheta);
+    dRdx = Imath::V3f(sintheta * sinphi, -sintheta * cosphi, 0.0f) * dphi;
+    dRdy = Imath::V3f(-costheta * cosphi, -costheta * sinphi, -sintheta)
+           * dtheta;
+}
+
+
+
+void
+env_region(ImageBuf& image, ustring filename, ROI roi)
+{
+    TextureSystem::Perthread* perthread_info     = texsys->get_perthread_info();
+    TextureSystem::TextureHandle* texture_handle = texsys->get_texture_handle(
+        filename);
+    int nchannels = nchannels_override ? nchannels_override : image.nchannels();
+
+    TextureOpt opt;
+    initialize_opt(opt);
+
+    float* result    = OIIO_ALLOCA(float, nchannels);
+    float* dresultds = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    float* dresultdt = test_derivs ? OIIO_ALLOCA(float, nchannels) : NULL;
+    for (ImageBuf::Iterator<float> p(image, roi); !p.done(); ++p) {
+        Imath::V3f R, dRdx, dRdy;
+        map_env(p.x(), p.y(), R, dRdx, dRdy);
+        bool ok = texsys->environment(texture_handle, perthread_info, opt, R,
+                                      dRdx, dRdy, nchannels, result,
+                                      dresultds, dresultdt);
+        if (!ok) {
+            std::string e = texsys->geterror();
+            if (!e.empty())
+                Strutil::fprintf(std::cerr, "ERROR: %s\n", e);
+        }
+        for (int i = 0; i < nchannels; ++i)
+            result[i] *= scalefactor;
+        image.setpixel(p.x(), p.y(), result);
+    }
+}
+
+
+
+void
+env_region_batch(ImageBuf& image, ustring filename, ROI roi)
+{
+    using namespace Tex;
+    TextureSystem::Perthread* perthread_info     = texsys->get_perthread_info();
+    TextureSystem::TextureHandle* texture_handle = texsys->get_texture_handle(
+        filename);
+    int nchannels_img = image.nchannels();
+    int nchannels = nchannels_override ? nchannels_override : image.nchannels();
+
+    TextureOptBatch opt;
+    initialize_opt(opt);
+
+    FloatWide* result    = OIIO_ALLOCA(FloatWide, nchannels);
+    FloatWide* dresultds = test_derivs ? OIIO_ALLOCA(FloatWide, nchannels)
+                                       : NULL;
+    FloatWide* dresultdt = test_derivs ? OIIO_ALLOCA(FloatWide, nchannels)
+                                       : NULL;
+    for (int y = roi.ybegin; y < roi.yend; ++y) {
+        for (int x = roi.xbegin; x < roi.xend; x += BatchWidth) {
+            // Directions are laid out [axis][lane], like the results
+            FloatWide R[3], dRdx[3], dRdy[3];
+            int npoints  = std::min(BatchWidth, roi.xend - x);
+            RunMask mask = RunMaskOn >> (BatchWidth - npoints);
+            for (int i = 0; i < npoints; ++i) {
+                Imath::V3f R_, dRdx_, dRdy_;
+                map_env(x + i, y, R_, dRdx_, dRdy_);
+                for (int a = 0; a < 3; ++a) {
+                    R[a][i]    = R_[a];
+                    dRdx[a][i] = dRdx_[a];
+                    dRdy[a][i] = dRdy_[a];
+                }
+            }
+            bool ok = texsys->environment(texture_handle, perthread_info, opt,
+                                          mask, (float*)R, (float*)dRdx,
+                                          (float*)dRdy, nchannels,
+                                          (float*)result, (float*)dresultds,
+                                          (float*)dresultdt);
+            if (!ok) {
+                std::string e = texsys->geterror();
+                if (!e.empty())
+                    Strutil::fprintf(std::cerr, "ERROR: %s\n", e);
+            }
+
+            // Save filtered pixels back to the image.
+            for (int c = 0; c < nchannels; ++c)
+                result[c] *= scalefactor;
+            float* resultptr = (float*)image.pixeladdr(x, y);
+            for (int c = 0; c < nchannels; ++c)
+                for (int i = 0; i < npoints; ++i)
+                    resultptr[c + i * nchannels_img] = result[c][i];
+        }
+    }
+}
+
+
+
+// Render the environment map over the output image, returning the time
+// taken by the lookups of all iterations.
+static double
+render_environment(ImageBuf& image, ustring filename, bool use_batch)
+{
+    Timer timer;
+    for (int iter = 0; iter < iters; ++iter) {
+        if (close_before_iter)
+            texsys->close_all();
+        ImageBufAlgo::parallel_image(get_roi(image.spec()), nthreads,
+                                     [&](ROI roi) {
+                                         if (use_batch)
+                                             env_region_batch(image, filename,
+                                                              roi);
+                                         else
+                                             env_region(image, filename, roi);
+                                     });
+    }
+    return timer();
+}
+
+
+
+static void
+test_environment(ustring filename)
+{
+    std::cout << "Testing environment " << filename
+              << ", output = " << output_filename << "\n";
+    int nchannels = nchannels_override ? nchannels_override : 4;
+    ImageSpec outspec(output_xres, output_yres, nchannels, TypeDesc::FLOAT);
+    ImageBuf image(outspec);
+    TypeDesc fmt(dataformatname);
+    image.set_write_format(fmt);
+    OIIO::ImageBufAlgo::zero(image);
+
+    if (batchbench)
+        batch_benchmark("Environment", [&](bool use_batch) {
+            return render_environment(image, filename, use_batch);
+        });
+    else
+        render_environment(image, filename, batch);
+
+    if (!image.write(output_filename))
+        Strutil::fprintf(std::cerr, "Error writing %s : %s\n", output_filename,
+                         image.geterror());
+}
 
 
 
@@ -1629,7 +1839,12 @@ main(int argc, const char* argv[])
             }
         }
         if (!strcmp(texturetype, "Volume Texture")) {
-            if (batch) {
+            if (batchbench) {
+                if (nowarp)
+                    bench_texture3d(filename, map_default_3D, map_default_3D);
+                else
+                    bench_texture3d(filename, map_warp_3D, map_warp_3D);
+            } else if (batch) {
                 if (nowarp)
                     test_texture3d_batch(filename, map_default_3D);
                 else
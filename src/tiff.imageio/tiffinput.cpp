@@ -109,6 +109,8 @@ public:
     virtual bool read_native_tiles(int subimage, int miplevel, int xbegin,
                                    int xend, int ybegin, int yend, int zbegin,
                                    int zend, void* data) override;
+    virtual bool tile_file_offset(int subimage, int miplevel, int x, int y,
+                                  int z, int64_t& offset) override;
     virtual bool read_scanline(int y, int z, TypeDesc format, void* data,
                                stride_t xstride) override;
     virtual bool read_scanlines(int subimage, int miplevel, int ybegin,
@@ -2019,6 +2021,41 @@ TIFFInput::read_native_tile(int subimage, int miplevel, int x, int y, int z,
 
 
 
+bool
+TIFFInput::tile_file_offset(int subimage, int miplevel, int x, int y, int z,
+                            int64_t& offset)
+{
+    lock_guard lock(*this);
+    if (!seek_subimage(subimage, miplevel))
+        return false;
+    // Only the simplest layout qualifies: uncompressed, contiguous, whole
+    // bytes per channel in our byte order, and no palette, color or alpha
+    // conversion of any kind to do after reading.
+    if (!m_spec.tile_width || m_io || m_compression != COMPRESSION_NONE
+        || m_separate || m_use_rgba_interface || m_convert_alpha
+        || (m_photometric != PHOTOMETRIC_RGB
+            && m_photometric != PHOTOMETRIC_MINISBLACK)
+        || m_spec.channelformats.size()
+        || m_inputchannels != m_spec.nchannels
+        || m_bitspersample != 8 * m_spec.format.size()
+        || (m_is_byte_swapped && m_spec.format.size() > 1))
+        return false;
+
+    ttile_t tile = TIFFComputeTile(m_tif, x - m_spec.x, y - m_spec.y, z, 0);
+    toff_t* offsets    = nullptr;
+    toff_t* bytecounts = nullptr;
+    if (tile >= TIFFNumberOfTiles(m_tif)
+        || !TIFFGetField(m_tif, TIFFTAG_TILEOFFSETS, &offsets)
+        || !TIFFGetField(m_tif, TIFFTAG_TILEBYTECOUNTS, &bytecounts)
+        || !offsets || !bytecounts
+        || imagesize_t(bytecounts[tile]) != m_spec.tile_bytes())
+        return false;
+    offset = int64_t(offsets[tile]);
+    return true;
+}
+
+
+
 bool
 TIFFInput::read_native_tiles(int subimage, int miplevel, int xbegin, int xend,
                              int ybegin, int yend, int zbegin, int zend,
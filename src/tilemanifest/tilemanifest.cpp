@@ -0,0 +1,99 @@
+// Copyright 2008-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/OpenImageIO/oiio
+
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/argparse.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/timer.h>
+
+using namespace OIIO;
+
+static bool help    = false;
+static bool verbose = false;
+static bool stats   = false;
+static int nthreads = 0;  // default: use #cores threads if available
+static float max_memory_MB = 0.0f;
+static std::string disk_cache;
+static std::string mergefile;
+static std::vector<std::string> manifests;
+
+
+
+int
+main(int argc, const char* argv[])
+{
+    // Helpful for debugging to make sure that any crashes dump a stack
+    // trace.
+    Sysutil::setup_crash_stacktrace("stdout");
+
+    Filesystem::convert_native_arguments(argc, (const char**)argv);
+    ArgParse ap;
+    // clang-format off
+    ap.intro("tilemanifest -- read the tiles listed in ImageCache tile manifests\n"
+             OIIO_INTRO_STRING);
+    ap.usage("tilemanifest [options] manifest...");
+    ap.arg("manifest")
+      .hidden()
+      .action([&](cspan<const char*> argv){ manifests.emplace_back(argv[0]); });
+    ap.arg("-v", &verbose)
+      .help("Verbose output");
+    ap.arg("--threads %d:NTHREADS", &nthreads)
+      .help("Number of threads (default: #cores)");
+    ap.arg("--memory %f:MB", &max_memory_MB)
+      .help("Tile cache memory limit (default: as for the ImageCache)");
+    ap.arg("--disk-cache %s:DIR", &disk_cache)
+      .help("Fill this persistent tile cache directory with the tiles");
+    ap.arg("--merge %s:FILENAME", &mergefile)
+      .help("Write a manifest of all the tiles read");
+    ap.arg("--stats", &stats)
+      .help("Print ImageCache statistics when done");
+    // clang-format on
+    if (ap.parse(argc, argv) < 0 || manifests.empty()) {
+        std::cerr << ap.geterror() << std::endl;
+        ap.print_help();
+        return help ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    OIIO::attribute("threads", nthreads);
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    if (max_memory_MB > 0.0f)
+        ic->attribute("max_memory_MB", max_memory_MB);
+    if (disk_cache.size())
+        ic->attribute("disk_cache", disk_cache);
+
+    int returncode = EXIT_SUCCESS;
+    for (auto&& m : manifests) {
+        Timer timer;
+        bool ok = ic->preload_tile_manifest(m);
+        if (!ok) {
+            std::cerr << "tilemanifest ERROR: \"" << m
+                      << "\" : " << ic->geterror() << "\n";
+            returncode = EXIT_FAILURE;
+        }
+        if (verbose) {
+            int tiles = 0;
+            ic->getattribute("stat:prefetch_tiles", tiles);
+            std::cout << m << ": " << Strutil::sprintf("%.2f", timer())
+                      << "s, " << tiles << " tiles read so far\n";
+        }
+    }
+
+    if (mergefile.size() && !ic->write_tile_manifest(mergefile)) {
+        std::cerr << "tilemanifest ERROR: " << ic->geterror() << "\n";
+        returncode = EXIT_FAILURE;
+    }
+    if (stats)
+        std::cout << ic->getstats(2) << "\n";
+    ImageCache::destroy(ic);
+    return returncode;
+}
@@ -0,0 +1,224 @@
+// Copyright 2008-present Contributors to the OpenImageIO project.
+// SPDX-License-Identifier: BSD-3-Clause
+// https://github.com/OpenImageIO/oiio
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <OpenImageIO/argparse.h>
+#include <OpenImageIO/filesystem.h>
+#include <OpenImageIO/imagecache.h>
+#include <OpenImageIO/strutil.h>
+#include <OpenImageIO/sysutil.h>
+#include <OpenImageIO/timer.h>
+
+#include "tiletrace.h"
+
+using namespace OIIO;
+using namespace OIIO::pvt;
+
+static bool help    = false;
+static bool verbose = false;
+static std::string memory_list;
+static std::string autotile_list;
+static std::string max_open_files_list;
+static std::string tracefile;
+
+struct Trace {
+    std::vector<ustring> files;
+    std::vector<TileTraceRecord> records;
+    int nthreads = 0;
+};
+
+
+
+// Read the whole trace, putting the records in time order.
+static bool
+read_trace(const std::string& filename, Trace& trace)
+{
+    FILE* f = Filesystem::fopen(filename, "rb");
+    if (!f) {
+        std::cerr << "tilereplay ERROR: could not open \"" << filename
+                  << "\"\n";
+        return false;
+    }
+    char magic[8];
+    bool ok = (fread(magic, sizeof(magic), 1, f) == 1
+               && std::equal(magic, magic + 8, tile_trace_magic));
+    uint32_t tag;
+    while (ok && fread(&tag, sizeof(tag), 1, f) == 1) {
+        if (tag == TileTraceFileTag) {
+            uint32_t header[2];  // index, name length
+            ok = (fread(header, sizeof(header), 1, f) == 1);
+            std::string name(header[1], '\0');
+            ok = ok && (!header[1] || fread(&name[0], header[1], 1, f) == 1);
+            if (ok && header[0] >= trace.files.size())
+                trace.files.resize(header[0] + 1);
+            if (ok)
+                trace.files[header[0]] = ustring(name);
+        } else if (tag == TileTraceTilesTag) {
+            uint32_t count;
+            ok = (fread(&count, sizeof(count), 1, f) == 1);
+            size_t n = trace.records.size();
+            trace.records.resize(n + count);
+            ok = ok
+                 && fread(&trace.records[n], sizeof(TileTraceRecord), count, f)
+                        == count;
+        } else {
+            ok = false;
+        }
+    }
+    fclose(f);
+    if (!ok) {
+        std::cerr << "tilereplay ERROR: \"" << filename
+                  << "\" is not a valid tile trace\n";
+        return false;
+    }
+    // Each thread's records were written in batches, so they're not in
+    // order overall.
+    std::stable_sort(trace.records.begin(), trace.records.end(),
+                     [](const TileTraceRecord& a, const TileTraceRecord& b) {
+                         return a.time < b.time;
+                     });
+    for (auto& r : trace.records) {
+        trace.nthreads = std::max(trace.nthreads, int(r.thread) + 1);
+        if (r.file >= trace.files.size()) {
+            std::cerr << "tilereplay ERROR: \"" << filename
+                      << "\" refers to an unnamed file\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+// Parse a comma-separated list of numbers; an empty list means just the
+// ImageCache default (-1).
+template<typename T>
+static std::vector<T>
+parse_list(const std::string& list)
+{
+    std::vector<T> values;
+    Strutil::extract_from_list_string(values, list);
+    if (values.empty())
+        values.push_back(T(-1));
+    return values;
+}
+
+
+
+// Replay the trace against a new ImageCache with the given settings, and
+// print what happened.
+static void
+replay(const Trace& trace, float memory, int autotile, int max_open_files)
+{
+    ImageCache* ic = ImageCache::create(false /*not shared*/);
+    if (memory >= 0.0f)
+        ic->attribute("max_memory_MB", memory);
+    if (autotile >= 0)
+        ic->attribute("autotile", autotile);
+    if (max_open_files >= 0)
+        ic->attribute("max_open_files", max_open_files);
+    ic->getattribute("max_memory_MB", memory);
+    ic->getattribute("autotile", autotile);
+    ic->getattribute("max_open_files", max_open_files);
+
+    // A Perthread for each thread of the traced run, so that they each
+    // have their own microcache, as they did then.
+    std::vector<ImageCache::Perthread*> threads(trace.nthreads);
+    for (auto& t : threads)
+        t = ic->create_thread_info();
+    std::vector<ImageCache::ImageHandle*> handles(trace.files.size());
+    for (size_t i = 0; i < handles.size(); ++i)
+        handles[i] = ic->get_image_handle(trace.files[i], threads[0]);
+
+    // Tiles are looked up by their origin in the traced run. If the tile
+    // size is different now (because of autotile), that's just the tile
+    // containing that pixel.
+    Timer timer;
+    int failed = 0;
+    for (auto& r : trace.records) {
+        ImageCache::Tile* tile = ic->get_tile(handles[r.file],
+                                              threads[r.thread], r.subimage,
+                                              r.miplevel, r.x, r.y, r.z,
+                                              r.chbegin, r.chend);
+        if (tile)
+            ic->release_tile(tile);
+        else
+            ++failed;
+    }
+    double time = timer();
+
+    int misses = 0, opens = 0, open_now = 0;
+    long long bytes = 0;
+    ic->getattribute("stat:find_tile_cache_misses", misses);
+    ic->getattribute("stat:open_files_created", opens);
+    ic->getattribute("stat:open_files_current", open_now);
+    ic->getattribute("stat:bytes_read", TypeDesc::INT64, &bytes);
+    double lookups = std::max(size_t(1), trace.records.size());
+    std::cout << Strutil::sprintf(
+        "%10.1f %8d %10d   %6.2f%% %12s %8d %8d %9.2fs\n", memory, autotile,
+        max_open_files, 100.0 * (1.0 - misses / lookups),
+        Strutil::memformat(bytes), opens, opens - open_now, time);
+    if (failed)
+        std::cout << "    (" << failed << " tiles could not be read)\n";
+    if (verbose)
+        std::cout << ic->getstats(2) << "\n";
+    for (auto& t : threads)
+        ic->destroy_thread_info(t);
+    ImageCache::destroy(ic);
+}
+
+
+
+int
+main(int argc, const char* argv[])
+{
+    // Helpful for debugging to make sure that any crashes dump a stack
+    // trace.
+    Sysutil::setup_crash_stacktrace("stdout");
+
+    Filesystem::convert_native_arguments(argc, (const char**)argv);
+    ArgParse ap;
+    // clang-format off
+    ap.intro("tilereplay -- replay ImageCache tile traces with other settings\n"
+             OIIO_INTRO_STRING);
+    ap.usage("tilereplay [options] tracefile");
+    ap.arg("tracefile")
+      .hidden()
+      .action([&](cspan<const char*> argv){ tracefile = argv[0]; });
+    ap.arg("-v", &verbose)
+      .help("Verbose output (print full statistics of each replay)");
+    ap.arg("--memory %s:MB", &memory_list)
+      .help("Comma-separated list of max_memory_MB values to try");
+    ap.arg("--autotile %s:SIZES", &autotile_list)
+      .help("Comma-separated list of autotile values to try");
+    ap.arg("--max-open-files %s:N", &max_open_files_list)
+      .help("Comma-separated list of max_open_files values to try");
+    // clang-format on
+    if (ap.parse(argc, argv) < 0 || tracefile.empty()) {
+        std::cerr << ap.geterror() << std::endl;
+        ap.print_help();
+        return help ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    Trace trace;
+    if (!read_trace(tracefile, trace))
+        return EXIT_FAILURE;
+    std::cout << "Trace \"" << tracefile << "\": " << trace.records.size()
+              << " tile lookups of " << trace.files.size() << " files by "
+              << trace.nthreads << " threads\n\n";
+    std::cout << "  memory MB autotile  max files  hit rate   bytes read"
+                 "    opens   closes      time\n";
+    for (float memory : parse_list<float>(memory_list))
+        for (int autotile : parse_list<int>(autotile_list))
+            for (int max_open_files : parse_list<int>(max_open_files_list))
+                replay(trace, memory, autotile, max_open_files);
+    return EXIT_SUCCESS;
+}